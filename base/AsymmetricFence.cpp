@@ -0,0 +1,69 @@
+#include "AsymmetricFence.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#if defined(__NR_membarrier)
+#include <linux/membarrier.h>
+#if defined(MEMBARRIER_CMD_PRIVATE_EXPEDITED) && defined(MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED)
+#define BO_NET_HAVE_MEMBARRIER 1
+#endif
+#endif
+
+using namespace bo_net;
+
+bool detail::AsymmetricFence::expedited_ = false;
+
+namespace
+{
+
+pthread_once_t g_once = PTHREAD_ONCE_INIT;
+
+#ifdef BO_NET_HAVE_MEMBARRIER
+int membarrier(int cmd)
+{
+  return static_cast<int>(syscall(__NR_membarrier, cmd, 0));
+}
+#endif
+
+}  // namespace
+
+// 只在pthread_once里执行一次，expedited_在其他线程使用之前写好
+void detail::AsymmetricFence::registerOnce()
+{
+#ifdef BO_NET_HAVE_MEMBARRIER
+  // 需要Linux 4.14以上；QUERY返回内核支持的命令位图
+  int commands = membarrier(MEMBARRIER_CMD_QUERY);
+  if (commands > 0
+      && (commands & MEMBARRIER_CMD_PRIVATE_EXPEDITED)
+      && membarrier(MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED) == 0)
+  {
+    expedited_ = true;
+  }
+#endif
+}
+
+void detail::AsymmetricFence::init()
+{
+  pthread_once(&g_once, registerOnce);
+}
+
+void detail::AsymmetricFence::heavy()
+{
+#ifdef BO_NET_HAVE_MEMBARRIER
+  if (expedited_)
+  {
+    // 注册成功之后不应该失败；失败时对面的light()只有编译器屏障，退化成fence也不安全，只能终止
+    if (membarrier(MEMBARRIER_CMD_PRIVATE_EXPEDITED) != 0)
+    {
+      perror("membarrier");
+      abort();
+    }
+    return;
+  }
+#endif
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+}
@@ -0,0 +1,51 @@
+#ifndef BO_NET_BASE_ASYMMETRICFENCE_H
+#define BO_NET_BASE_ASYMMETRICFENCE_H
+
+#include <atomic>
+
+/**
+ * http://man7.org/linux/man-pages/man2/membarrier.2.html
+ * 非对称内存屏障：两个线程各自"先写自己的变量，再读对方的变量"（Dekker式的配对）时，两边都需要StoreLoad屏障。
+ * 如果一边执行得非常频繁（生产者发布元素之后检查有没有等待者），另一边很少执行（消费者挂起之前登记自己），
+ * 可以让频繁的一边只用编译器屏障，由很少执行的一边调用membarrier(MEMBARRIER_CMD_PRIVATE_EXPEDITED)，
+ * 让本进程所有正在运行的线程都执行一次完整的内存屏障，效果等同于两边都用了seq_cst fence。
+ * 内核不支持时两边都退化为std::atomic_thread_fence(seq_cst)
+*/
+
+namespace bo_net
+{
+
+namespace detail
+{
+
+class AsymmetricFence
+{
+    public:
+        // 探测并注册membarrier，只有第一次调用真正执行。必须在任何线程调用light()/heavy()之前完成，
+        // 使用者一般在构造函数里调用，对象发布给其他线程之前light()的行为就已经确定了
+        static void init();
+
+        // 频繁执行的一侧：membarrier可用时只阻止编译器重排，不产生任何指令
+        static void light() {
+            if(__builtin_expect(expedited_, 1)) {
+                std::atomic_signal_fence(std::memory_order_seq_cst);
+            }
+            else {
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+            }
+        }
+
+        // 很少执行的一侧：一次系统调用，开销在微秒级
+        static void heavy();
+
+    private:
+        static void registerOnce();
+
+        static bool expedited_;  // 注册成功之后为true，此后不再改变
+};
+
+} // namespace detail
+
+} // namespace bo_net
+
+#endif // BO_NET_BASE_ASYMMETRICFENCE_H
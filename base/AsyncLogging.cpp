@@ -0,0 +1,202 @@
+#include "AsyncLogging.h"
+#include "Timestamp.h"
+
+#include <stdio.h>
+
+using namespace bo_net;
+
+namespace
+{
+
+// 后端积压超过这么多个写满的缓冲区（约100MB）时开始丢弃
+const size_t kMaxPendingBuffers = 25;
+
+size_t roundUpToPowerOfTwo(int n)
+{
+  size_t size = 1;
+  while (size < static_cast<size_t>(n))
+  {
+    size <<= 1;
+  }
+  return size;
+}
+
+}  // namespace
+
+AsyncLogging::AsyncLogging(const OutputFunc& output,
+                           const FlushFunc& flush,
+                           int flushInterval,
+                           int numBuckets)
+  : flushInterval_(flushInterval),
+    running_(false),
+    output_(output),
+    flush_(flush),
+    thread_(std::bind(&AsyncLogging::threadFunc, this), "Logging"),
+    latch_(1),
+    bucketMask_(roundUpToPowerOfTwo(numBuckets > 0 ? numBuckets : 1) - 1),
+    buckets_(new CacheLinePadded<Bucket>[bucketMask_ + 1]),
+    mutex_(),
+    cond_(mutex_)
+{
+  for (size_t i = 0; i <= bucketMask_; ++i)
+  {
+    Bucket& bucket = buckets_[i].value;
+    MutexLockGuard lock(bucket.mutex);
+    bucket.currentBuffer.reset(new Buffer);
+    bucket.currentBuffer->bzero();
+  }
+  // 每个bucket预备一个空闲缓冲区，缓冲区写满时通常不需要再分配内存
+  MutexLockGuard lock(mutex_);
+  for (size_t i = 0; i <= bucketMask_; ++i)
+  {
+    emptyBuffers_.emplace_back(new Buffer);
+    emptyBuffers_.back()->bzero();
+  }
+}
+
+void AsyncLogging::append(const char* logline, int len)
+{
+  Bucket& bucket = buckets_[static_cast<size_t>(CurrentThread::tid()) & bucketMask_].value;
+  MutexLockGuard lock(bucket.mutex);
+  if (bucket.currentBuffer->avail() > len)
+  {
+    bucket.currentBuffer->append(logline, len);
+    return;
+  }
+
+  // 当前缓冲区写满了，交给后端，再换一个空的
+  {
+    MutexLockGuard globalLock(mutex_);
+    buffers_.push_back(std::move(bucket.currentBuffer));
+    if (!emptyBuffers_.empty())
+    {
+      bucket.currentBuffer = std::move(emptyBuffers_.back());
+      emptyBuffers_.pop_back();
+    }
+    cond_.notifyOne();
+  }
+  if (!bucket.currentBuffer)
+  {
+    bucket.currentBuffer.reset(new Buffer); // Rarely happens
+  }
+  bucket.currentBuffer->append(logline, len);
+}
+
+void AsyncLogging::takeBuffers(bool collectPartial, BufferVector& buffersToWrite, BufferVector& spareBuffers)
+{
+  if (!collectPartial)
+  {
+    MutexLockGuard lock(mutex_);
+    buffersToWrite.swap(buffers_);
+    return;
+  }
+
+  // 锁的顺序和append()相同：先按下标依次拿所有bucket锁，再拿mutex_。
+  // 否则在交换buffers_和收集某个bucket之间，前端可能交上来一个写满的缓冲区F并开始写新的缓冲区P，
+  // 这一轮写出P而F留到下一轮，同一个线程的日志就乱序了（退出时F还会丢失）
+  for (size_t i = 0; i <= bucketMask_; ++i)
+  {
+    buckets_[i].value.mutex.lock();
+  }
+  {
+    MutexLockGuard lock(mutex_);
+    buffersToWrite.swap(buffers_);
+  }
+  for (size_t i = 0; i <= bucketMask_; ++i)
+  {
+    Bucket& bucket = buckets_[i].value;
+    if (bucket.currentBuffer->length() != 0)
+    {
+      buffersToWrite.push_back(std::move(bucket.currentBuffer));
+      if (!spareBuffers.empty())
+      {
+        bucket.currentBuffer = std::move(spareBuffers.back());
+        spareBuffers.pop_back();
+      }
+      else
+      {
+        bucket.currentBuffer.reset(new Buffer);
+      }
+    }
+  }
+  for (size_t i = bucketMask_ + 1; i > 0; --i)
+  {
+    buckets_[i - 1].value.mutex.unlock();
+  }
+}
+
+void AsyncLogging::threadFunc()
+{
+  assert(running_ == true);
+  latch_.countDown();
+
+  const size_t kMaxSpareBuffers = 2 * (bucketMask_ + 1);
+  BufferVector buffersToWrite;
+  BufferVector spareBuffers;  // 后端自己留着的空闲缓冲区，用来替换没写满的bucket缓冲区
+  buffersToWrite.reserve(16);
+  Timestamp lastCollect = Timestamp::now(Timestamp::kMonotonicCoarse);
+
+  for (bool stopping = false; !stopping; )
+  {
+    stopping = !running_;
+    assert(buffersToWrite.empty());
+
+    {
+      MutexLockGuard lock(mutex_);
+      if (buffers_.empty() && running_)  // unusual usage!
+      {
+        cond_.waitForSeconds(flushInterval_);
+      }
+    }
+
+    // 写满的缓冲区随时会到；没写满的只在超过flushInterval_或者退出时收集，避免负载高时产生很多小的写操作
+    Timestamp now = Timestamp::now(Timestamp::kMonotonicCoarse);
+    bool collectPartial = stopping || timeDifference(now, lastCollect) >= flushInterval_;
+    takeBuffers(collectPartial, buffersToWrite, spareBuffers);
+    if (collectPartial)
+    {
+      lastCollect = now;
+    }
+
+    if (buffersToWrite.size() > kMaxPendingBuffers)
+    {
+      char buf[256];
+      snprintf(buf, sizeof buf, "Dropped log messages at %s, %zu larger buffers\n",
+               Timestamp::now().toFormattedString().c_str(),
+               buffersToWrite.size() - 2);
+      fputs(buf, stderr);
+      droppedBuffers_.add(static_cast<int64_t>(buffersToWrite.size() - 2), std::memory_order_relaxed);
+      output_(buf, strlen(buf));
+      buffersToWrite.erase(buffersToWrite.begin() + 2, buffersToWrite.end());
+    }
+
+    for (const auto& buffer : buffersToWrite)
+    {
+      // FIXME: use unbuffered stdio FILE ? or use ::writev ?
+      output_(buffer->data(), buffer->length());
+    }
+    if (!buffersToWrite.empty())
+    {
+      flush_();
+    }
+
+    // 写完的缓冲区清空后归还：先补给前端，再留一些给自己，多余的释放掉
+    {
+      MutexLockGuard lock(mutex_);
+      while (!buffersToWrite.empty() && emptyBuffers_.size() <= bucketMask_)
+      {
+        buffersToWrite.back()->reset();
+        emptyBuffers_.push_back(std::move(buffersToWrite.back()));
+        buffersToWrite.pop_back();
+      }
+    }
+    while (!buffersToWrite.empty() && spareBuffers.size() < kMaxSpareBuffers)
+    {
+      buffersToWrite.back()->reset();
+      spareBuffers.push_back(std::move(buffersToWrite.back()));
+      buffersToWrite.pop_back();
+    }
+    buffersToWrite.clear();
+  }
+  flush_();
+}
@@ -0,0 +1,106 @@
+#ifndef BO_NET_BASE_ASYNCLOGGING_H
+#define BO_NET_BASE_ASYNCLOGGING_H
+
+#include "Atomic.h"
+#include "Condition.h"
+#include "CountDownLatch.h"
+#include "FixedBuffer.h"
+#include "Mutex.h"
+#include "Thread.h"
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace bo_net
+{
+
+// 多缓冲的异步日志后端：
+//   - 前端线程按tid哈希到若干个bucket（见TODO），每个bucket有自己的锁和当前缓冲区，
+//     append只是在bucket锁内做一次memcpy，不同bucket的线程之间没有竞争；
+//   - 缓冲区写满时交给后端，同时从空闲缓冲区中换一个新的，这一步才需要拿一次全局锁；
+//   - 后端线程成批地取走写满的缓冲区，在锁外调用output写盘，前端永远不会等待磁盘I/O；
+//   - 后端处理不过来、积压的缓冲区过多时，只保留最前面的两个，其余丢弃并计数。
+//
+// 同一个线程写的日志保持先后顺序，不同线程之间的日志在文件中可能不是严格按时间排列的
+class AsyncLogging : noncopyable
+{
+    public:
+        typedef std::function<void (const char *data, size_t len)> OutputFunc;
+        typedef std::function<void ()> FlushFunc;
+
+        // output和flush都只在后端线程中调用，例如写文件、fflush；
+        // flushInterval秒内即使缓冲区没有写满，也会把已有的日志交给output
+        AsyncLogging(const OutputFunc &output,
+                     const FlushFunc &flush,
+                     int flushInterval = 3,
+                     int numBuckets = 4);
+
+        ~AsyncLogging() {
+            if(running_) {
+                stop();
+            }
+        }
+
+        void append(const char *logline, int len);
+
+        void start() {
+            running_ = true;
+            thread_.start();
+            latch_.wait();
+        }
+
+        // 把已经append的日志全部写出之后再返回
+        void stop() {
+            running_ = false;
+            {
+                MutexLockGuard lock(mutex_);
+                cond_.notifyOne();
+            }
+            thread_.join();
+        }
+
+        // 因为后端来不及写而丢弃的缓冲区个数
+        int64_t droppedBuffers() const { return droppedBuffers_.get(std::memory_order_relaxed); }
+
+    private:
+        typedef detail::FixedBuffer<detail::kLargeBuffer> Buffer;
+        typedef std::unique_ptr<Buffer> BufferPtr;
+        typedef std::vector<BufferPtr> BufferVector;
+
+        struct Bucket
+        {
+            MutexLock mutex;
+            BufferPtr currentBuffer GUARDED_BY(mutex);
+        };
+
+        void threadFunc();
+        // 取走写满的缓冲区，collectPartial为true时再把各个bucket中没写满但有内容的缓冲区换出来，
+        // 都追加到buffersToWrite。两者在同一次持有所有bucket锁和mutex_时取走，
+        // 前端不会在中间再交上来一个写满的缓冲区，同一个线程的日志不会乱序
+        void takeBuffers(bool collectPartial, BufferVector &buffersToWrite, BufferVector &spareBuffers)
+            NO_THREAD_SAFETY_ANALYSIS;
+
+        const int flushInterval_;
+        std::atomic<bool> running_;
+        OutputFunc output_;
+        FlushFunc flush_;
+        Thread thread_;
+        CountDownLatch latch_;
+
+        const size_t bucketMask_;
+        std::unique_ptr<CacheLinePadded<Bucket>[]> buckets_;
+
+        // 锁的顺序：bucket锁 -> mutex_
+        MutexLock mutex_;
+        Condition cond_ GUARDED_BY(mutex_);
+        BufferVector buffers_ GUARDED_BY(mutex_);       // 写满了等待后端写出的缓冲区
+        BufferVector emptyBuffers_ GUARDED_BY(mutex_);  // 后端归还的空闲缓冲区，前端换缓冲区时从这里拿
+
+        AtomicInt64 droppedBuffers_;
+};
+
+} // namespace bo_net
+
+#endif // BO_NET_BASE_ASYNCLOGGING_H
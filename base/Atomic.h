@@ -1,12 +1,21 @@
 #ifndef BO_NET_BASE_ATOMIC_H
 #define BO_NET_BASE_ATOMIC_H
 
+#include "CurrentThread.h"
+#include "Types.h"
+
 #include <boost/noncopyable.hpp>
+#include <atomic>
+#include <memory>
+#include <thread>
 #include <stdint.h>
 
 /**
- * https://gcc.gnu.org/onlinedocs/gcc-4.1.0/gcc/Atomic-Builtins.html
- * 上述文档是gcc对常见的原子操作的介绍
+ * https://en.cppreference.com/w/cpp/atomic/memory_order
+ * 以前基于gcc的__sync_*内置函数实现，每个操作（包括读）都是带完整内存屏障的RMW指令。
+ * 现在基于std::atomic，每个操作都可以指定内存序，默认仍然是seq_cst，与原来的语义兼容：
+ *   - 只用来统计的计数器用memory_order_relaxed，x86上就是一条不带屏障的lock xadd / 普通mov
+ *   - 用来发布数据的标志用release写、acquire读
 */
 
 namespace bo_net 
@@ -23,56 +32,60 @@ class AtomicIntegerT : boost::noncopyable
             : value_(0) 
         {
         }
-        
-        // AtomicIntegerT(const AtomicIntegerT& that)
-        //   : value_(that.get())
-        // {}
-        
-        // AtomicIntegerT& operator=(const AtomicIntegerT& that)
-        // {
-        //   getAndSet(that.get());
-        //   return *this;
-        // }
+
+        explicit AtomicIntegerT(T initial)
+            : value_(initial)
+        {
+        }
     
-        T get() {
-            // 这个函数一定会返回value_的原值，因此可以用于设计读取操作
-            return __sync_val_compare_and_swap(&value_, 0, 0);
+        // 读操作现在只是一次load，x86上seq_cst的load也只是一条普通的mov
+        T get(std::memory_order order = std::memory_order_seq_cst) const {
+            return value_.load(order);
         }   
 
-        T getAndAdd(T x) {
-            return __sync_fetch_and_add(&value_, x);
+        void set(T newValue, std::memory_order order = std::memory_order_seq_cst) {
+            value_.store(newValue, order);
+        }
+
+        T getAndAdd(T x, std::memory_order order = std::memory_order_seq_cst) {
+            return value_.fetch_add(x, order);
+        }
+
+        T addAndGet(T x, std::memory_order order = std::memory_order_seq_cst) {
+            return getAndAdd(x, order) + x;
         }
 
-        T addAndGet(T x) {
-            return getAndAdd(x) + x;
+        T incrementAndGet(std::memory_order order = std::memory_order_seq_cst) {
+            return addAndGet(1, order);
         }
 
-        T incrementAndGet() {
-            return addAndGet(1);
+        T decrementAndGet(std::memory_order order = std::memory_order_seq_cst) {
+            return addAndGet(-1, order);
         }
 
-        T decrementAndGet() {
-            return addAndGet(-1);
+        void add(T x, std::memory_order order = std::memory_order_seq_cst) {
+            getAndAdd(x, order);
         }
 
-        void add(T x){
-            getAndAdd(x);
+        void increment(std::memory_order order = std::memory_order_seq_cst) {
+            incrementAndGet(order);
         }
 
-        void increment(){
-            incrementAndGet();
+        void decrement(std::memory_order order = std::memory_order_seq_cst) {
+            decrementAndGet(order);
         }
 
-        void decrement(){
-            decrementAndGet();
+        T getAndSet(T newValue, std::memory_order order = std::memory_order_seq_cst) {
+            return value_.exchange(newValue, order);
         }
 
-        T getAndSet(T newValue) {
-            return __sync_lock_test_and_set(&value_, newValue);
+        // 当前值等于expected时修改为desired并返回true，否则返回false
+        bool compareAndSet(T expected, T desired, std::memory_order order = std::memory_order_seq_cst) {
+            return value_.compare_exchange_strong(expected, desired, order);
         }
 
     private:
-        volatile T value_; // volatile主要是为了防止编译器考虑不到的那些情况，多线程程序中，如果一个变量被多个线程使用，那么编译器本身就不会优化，这里添加这个标志，只是增加一个保证
+        std::atomic<T> value_;
 };
 
 } // namespace detail
@@ -80,7 +93,84 @@ class AtomicIntegerT : boost::noncopyable
 typedef detail::AtomicIntegerT<int32_t> AtomicInt32;
 using AtomicInt64 = detail::AtomicIntegerT<int64_t>;
 
+// 线程之间传递"某件事已经完成"的标志：set()之前的写操作，对get()读到true的线程都可见
+class AtomicFlag : boost::noncopyable
+{
+    public:
+        explicit AtomicFlag(bool initial = false)
+            : value_(initial)
+        {
+        }
+
+        bool get() const { return value_.load(std::memory_order_acquire); }
+        void set(bool value) { value_.store(value, std::memory_order_release); }
+        bool getAndSet(bool value) { return value_.exchange(value, std::memory_order_acq_rel); }
+
+    private:
+        std::atomic<bool> value_;
+};
+
+// 把T单独放在一个cache line里，多个线程各自频繁写入相邻的变量时避免false sharing，例如：
+//   CacheLinePadded<AtomicInt64> counters[kThreads];
+template<typename T>
+struct alignas(kCacheLineSize) CacheLinePadded
+{
+    T value;
+};
+
+// 分片计数器：写多读少的热点统计（请求数、字节数等）。每个线程按tid落到不同的分片上，
+// 各自只修改自己那个cache line，读取时再把所有分片加起来，因此get()的结果只是某一时刻的近似值
+class StripedCounter : boost::noncopyable
+{
+    public:
+        // stripes为0时按照CPU个数决定分片数，最终会向上取整到2的幂
+        explicit StripedCounter(int stripes = 0)
+            : mask_(roundUpToPowerOfTwo(stripes > 0 ? stripes : static_cast<int>(std::thread::hardware_concurrency())) - 1),
+              stripes_(new CacheLinePadded<std::atomic<int64_t> >[mask_ + 1])
+        {
+            reset();
+        }
+
+        void add(int64_t x) {
+            stripes_[static_cast<size_t>(CurrentThread::tid()) & mask_].value.fetch_add(x, std::memory_order_relaxed);
+        }
+
+        void increment() { add(1); }
+        void decrement() { add(-1); }
+
+        int64_t get() const {
+            int64_t sum = 0;
+            for(size_t i = 0; i <= mask_; ++i) {
+                sum += stripes_[i].value.load(std::memory_order_relaxed);
+            }
+            return sum;
+        }
+
+        // 和正在进行的add()并发时，那一次add可能被清掉
+        void reset() {
+            for(size_t i = 0; i <= mask_; ++i) {
+                stripes_[i].value.store(0, std::memory_order_relaxed);
+            }
+        }
+
+        size_t stripes() const { return mask_ + 1; }
+
+    private:
+        static const int kMaxStripes = 64;
+
+        static size_t roundUpToPowerOfTwo(int n) {
+            size_t size = 1;
+            while(size < static_cast<size_t>(n) && size < static_cast<size_t>(kMaxStripes)) {
+                size <<= 1;
+            }
+            return size;
+        }
+
+        const size_t mask_;
+        std::unique_ptr<CacheLinePadded<std::atomic<int64_t> >[]> stripes_;
+};
+
 } // namespace bo_net
 
 
-#endif
\ No newline at end of file
+#endif
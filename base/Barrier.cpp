@@ -0,0 +1,58 @@
+#include "Barrier.h"
+#include "Futex.h"
+#include "Types.h"
+
+#include <limits.h>
+#include <assert.h>
+
+using namespace bo_net;
+
+namespace
+{
+
+// 同一批任务的耗时通常差不多，最后几个线程往往很快就会到达，先自旋一会儿可以省掉一次睡眠和唤醒
+const int kSpinCount = 256;
+
+}  // namespace
+
+Barrier::Barrier(int parties)
+  : parties_(parties),
+    remaining_(parties),
+    phase_(0)
+{
+  assert(parties > 0);
+}
+
+int Barrier::arriveAndWait()
+{
+  // 必须在递减remaining_之前读取阶段号，否则最后一个线程可能已经推进了阶段
+  int phase = phase_.load(std::memory_order_acquire);
+  if (remaining_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+  {
+    // 最后一个到达：先为下一阶段重置计数，再推进阶段号放行其他线程。
+    // 被放行的线程只有在看到新阶段号之后才可能再次到达，所以不会用到旧的计数
+    const int parties = parties_;
+    remaining_.store(parties, std::memory_order_relaxed);
+    // 推进阶段号之后被放行的线程可能马上析构屏障，之后不能再读写成员，
+    // futexWake只是把地址交给内核，屏障已经被析构时最坏是一次多余的唤醒
+    phase_.fetch_add(1, std::memory_order_release);
+    if (parties > 1)
+    {
+      detail::futexWake(&phase_, INT_MAX);
+    }
+    return phase;
+  }
+
+  for (int spin = 0; phase_.load(std::memory_order_acquire) == phase; ++spin)
+  {
+    if (spin < kSpinCount)
+    {
+      cpuRelax();
+    }
+    else
+    {
+      detail::futexWait(&phase_, phase);
+    }
+  }
+  return phase;
+}
@@ -0,0 +1,38 @@
+#ifndef BO_NET_BASE_BARRIER_H
+#define BO_NET_BASE_BARRIER_H
+
+#include <boost/noncopyable.hpp>
+#include <atomic>
+
+namespace bo_net
+{
+
+// 可以重复使用的循环屏障：每凑齐parties个线程调用arriveAndWait()，就一起放行，并进入下一个阶段。
+// 与CountDownLatch不同，它不需要每一轮重新创建，适合每一批任务的fan-out/fan-in
+//
+// 到达的线程先自旋一小段时间，阶段仍然没有推进再睡眠在阶段号的futex上，最后一个到达的线程负责唤醒
+class Barrier : boost::noncopyable
+{
+    public:
+        explicit Barrier(int parties);
+
+        // 阻塞直到本阶段所有线程都到达，返回本次到达所属的阶段号（从0开始，每凑齐一次加一）。
+        // 最后一个到达的线程不会阻塞
+        int arriveAndWait();
+
+        // 当前正在进行的阶段号
+        int phase() const {
+            return phase_.load(std::memory_order_acquire);
+        }
+
+        int parties() const { return parties_; }
+
+    private:
+        const int        parties_;
+        std::atomic<int> remaining_;  // 本阶段还没有到达的线程个数
+        std::atomic<int> phase_;      // 阶段号，也是等待者睡眠的futex
+};
+
+} // namespace bo_net
+
+#endif // BO_NET_BASE_BARRIER_H
@@ -4,22 +4,29 @@
 
 #include "Condition.h"
 #include "Mutex.h"
+#include "Timestamp.h"
 
+#include <algorithm>
 #include <deque>
+#include <memory>
+#include <vector>
 #include <assert.h>
 
 namespace bo_net
 {
 
-template<typename T>
+// Alloc是内部deque使用的分配器，传入PoolAllocator<T>（ObjectPool.h）可以让deque的分段从slab分配器分配，
+// 生产者和消费者在不同线程时，分段在各自线程的缓存里循环使用，不再经过全局malloc
+template<typename T, typename Alloc = std::allocator<T> >
 class BlockingQueue : boost::noncopyable
 {
     public:
-        using queue_type = std::deque<T>;
+        using queue_type = std::deque<T, Alloc>;
 
         BlockingQueue()
             : mutex_(),
               notEmpty_(mutex_),
+              waiters_(0),
               queue_()
         {
         }
@@ -40,7 +47,7 @@ class BlockingQueue : boost::noncopyable
             MutexLockGuard lock(mutex_);
             // use while-loop to avoid spurious-wakeup problem
             while(queue_.empty()) {
-                notEmpty_.wait();
+                waitNotEmpty();
             }
             assert(!queue_.empty());
 
@@ -49,14 +56,101 @@ class BlockingQueue : boost::noncopyable
             return front;
         }
 
+        // 无界队列总能立即放入，总是返回true；和BoundedBlockingQueue::offerFor保持相同的接口
+        bool offerFor(const T &x, double seconds) {
+            put(x);
+            return true;
+        }
+
+        bool offerFor(T &&x, double seconds) {
+            put(std::move(x));
+            return true;
+        }
+
+        // 最多等待seconds秒，取到元素时放入out并返回true，超时返回false
+        bool pollFor(T &out, double seconds) {
+            Timestamp deadline = addTime(Timestamp::now(Timestamp::kMonotonic), seconds);
+            MutexLockGuard lock(mutex_);
+            while(queue_.empty()) {
+                if(waitNotEmpty(deadline) && queue_.empty()) {
+                    return false;
+                }
+            }
+            out = std::move(queue_.front());
+            queue_.pop_front();
+            return true;
+        }
+
+        // 一次加锁放入一批元素，只在临界区末尾唤醒一次消费者
+        template<typename InputIterator>
+        void putBatch(InputIterator first, InputIterator last) {
+            MutexLockGuard lock(mutex_);
+            size_t n = 0;
+            for(; first != last; ++first, ++n) {
+                queue_.push_back(*first);
+            }
+            notifyConsumers(n);
+        }
+
+        void putBatch(std::vector<T> &&items) {
+            MutexLockGuard lock(mutex_);
+            for(T &x : items) {
+                queue_.push_back(std::move(x));
+            }
+            notifyConsumers(items.size());
+            items.clear();
+        }
+
+        // 阻塞直到队列非空，然后一次取走最多maxItems个元素追加到out中，返回取到的个数
+        size_t takeBatch(size_t maxItems, std::vector<T> &out) {
+            assert(maxItems > 0);
+            MutexLockGuard lock(mutex_);
+            while(queue_.empty()) {
+                waitNotEmpty();
+            }
+            assert(!queue_.empty());
+
+            size_t n = std::min(maxItems, queue_.size());
+            out.reserve(out.size() + n);
+            for(size_t i = 0; i < n; ++i) {
+                out.push_back(std::move(queue_.front()));
+                queue_.pop_front();
+            }
+            return n;
+        }
+
+        // 攒批：最多等待seconds秒，期间陆续到达的元素都追加到out中，攒够maxItems个或者超时就返回取到的个数（可能为0）。
+        // 等待时不持有锁，生产者照常放入；适合"最多攒200微秒再一起刷出去"这种延迟有上界的批处理
+        size_t takeBatchFor(size_t maxItems, double seconds, std::vector<T> &out) {
+            assert(maxItems > 0);
+            Timestamp deadline = addTime(Timestamp::now(Timestamp::kMonotonic), seconds);
+            MutexLockGuard lock(mutex_);
+            size_t n = 0;
+            bool timedOut = false;
+            for(;;) {
+                // 超时的同时也可能有元素到达，超时之后再取一次
+                for(; n < maxItems && !queue_.empty(); ++n) {
+                    out.push_back(std::move(queue_.front()));
+                    queue_.pop_front();
+                }
+                if(n == maxItems || timedOut) {
+                    break;
+                }
+                timedOut = waitNotEmpty(deadline);
+            }
+            return n;
+        }
+
+        // 一次性取走队列中的全部元素，临界区内只是交换两个deque的内部指针
         queue_type drain() {
-            std::deque<T> queue;
+            queue_type queue;
 
             {
                 MutexLockGuard lock(mutex_);
-                queue = std::move(queue_); // 调用deque的移动赋值函数
+                queue.swap(queue_);
                 assert(queue_.empty());
             }
+            return queue;
         }
 
         size_t size() const {
@@ -65,8 +159,30 @@ class BlockingQueue : boost::noncopyable
         }    
 
     private:  
+        // 在notEmpty_上等待一次，deadline无效时不限时，超时返回true。等待期间计入waiters_，notifyConsumers据此决定唤醒几次
+        bool waitNotEmpty(Timestamp deadline = Timestamp::invalid()) REQUIRES(mutex_) {
+            ++waiters_;
+            bool timedOut = false;
+            if(deadline.valid()) {
+                timedOut = notEmpty_.waitUntil(deadline);
+            }
+            else {
+                notEmpty_.wait();
+            }
+            --waiters_;
+            return timedOut;
+        }
+
+        // 合并唤醒：放入n个元素时唤醒min(n, waiters_)个消费者，不用notifyAll把所有消费者都叫醒去抢这一批
+        void notifyConsumers(size_t n) REQUIRES(mutex_) {
+            for(size_t i = std::min(n, waiters_); i > 0; --i) {
+                notEmpty_.notifyOne();
+            }
+        }
+
         mutable MutexLock mutex_;
         Condition         notEmpty_ GUARDED_BY(mutex_);
+        size_t            waiters_ GUARDED_BY(mutex_);  // 正在notEmpty_上等待的消费者个数
         queue_type        queue_ GUARDED_BY(mutex_);
 };
 
@@ -3,14 +3,21 @@
 
 #include "Mutex.h"
 #include "Condition.h"
+#include "Timestamp.h"
 
 #include <boost/circular_buffer.hpp>
+#include <algorithm>
+#include <iterator>
+#include <memory>
+#include <vector>
 #include <assert.h>
 
 namespace bo_net 
 {
 
-template<typename T>
+// Alloc是环形缓冲区使用的分配器，和BlockingQueue一样可以换成PoolAllocator<T>。
+// 环形缓冲区只在构造时分配一次，超过SlabAllocator::kMaxSize的容量会直接走::operator new
+template<typename T, typename Alloc = std::allocator<T> >
 class BoundedBlockingQueue : boost::noncopyable
 {
 
@@ -19,6 +26,8 @@ class BoundedBlockingQueue : boost::noncopyable
             : mutex_(),
               notEmpty_(mutex_),
               notFull_(mutex_),
+              consumersWaiting_(0),
+              producersWaiting_(0),
               queue_(maxSize)
         {
         }
@@ -26,7 +35,7 @@ class BoundedBlockingQueue : boost::noncopyable
     void put(const T &x) {
         MutexLockGuard lock(mutex_);
         while(queue_.full()) {
-            notFull_.wait();
+            waitOn(notFull_, producersWaiting_);
         }
         assert(!queue_.full());
 
@@ -37,7 +46,7 @@ class BoundedBlockingQueue : boost::noncopyable
     void put(T &&x) {
         MutexLockGuard lock(mutex_);
         while(queue_.full()) {
-            notFull_.wait();
+            waitOn(notFull_, producersWaiting_);
         }
         assert(!queue_.full());
 
@@ -49,7 +58,7 @@ class BoundedBlockingQueue : boost::noncopyable
     T take() {
         MutexLockGuard lock(mutex_);
         while(queue_.empty()) {
-            notEmpty_.wait();
+            waitOn(notEmpty_, consumersWaiting_);
         }
         assert(!queue_.empty());
 
@@ -60,6 +69,110 @@ class BoundedBlockingQueue : boost::noncopyable
         return front;
     }
 
+    // 队列满时最多等待seconds秒，放入了返回true，超时返回false（x不会被移走）
+    bool offerFor(const T &x, double seconds) {
+        Timestamp deadline = addTime(Timestamp::now(Timestamp::kMonotonic), seconds);
+        MutexLockGuard lock(mutex_);
+        if(!waitNotFull(deadline)) {
+            return false;
+        }
+        queue_.push_back(x);
+        notEmpty_.notifyOne();
+        return true;
+    }
+
+    bool offerFor(T &&x, double seconds) {
+        Timestamp deadline = addTime(Timestamp::now(Timestamp::kMonotonic), seconds);
+        MutexLockGuard lock(mutex_);
+        if(!waitNotFull(deadline)) {
+            return false;
+        }
+        queue_.push_back(std::move(x));
+        notEmpty_.notifyOne();
+        return true;
+    }
+
+    // 最多等待seconds秒，取到元素时放入out并返回true，超时返回false
+    bool pollFor(T &out, double seconds) {
+        Timestamp deadline = addTime(Timestamp::now(Timestamp::kMonotonic), seconds);
+        MutexLockGuard lock(mutex_);
+        while(queue_.empty()) {
+            if(waitOn(notEmpty_, consumersWaiting_, deadline) && queue_.empty()) {
+                return false;
+            }
+        }
+        out = std::move(queue_.front());
+        queue_.pop_front();
+        notFull_.notifyOne();
+        return true;
+    }
+
+    // 一次加锁放入一批元素。队列放不下时会在notFull_上等待，每次腾出空间后尽可能多地放入，
+    // 每放入一段只唤醒一次消费者
+    template<typename InputIterator>
+    void putBatch(InputIterator first, InputIterator last) {
+        MutexLockGuard lock(mutex_);
+        while(first != last) {
+            while(queue_.full()) {
+                waitOn(notFull_, producersWaiting_);
+            }
+            assert(!queue_.full());
+
+            size_t n = 0;
+            for(; first != last && !queue_.full(); ++first, ++n) {
+                queue_.push_back(*first);
+            }
+            notify(notEmpty_, consumersWaiting_, n);
+        }
+    }
+
+    void putBatch(std::vector<T> &&items) {
+        putBatch(std::make_move_iterator(items.begin()), std::make_move_iterator(items.end()));
+        items.clear();
+    }
+
+    // 阻塞直到队列非空，然后一次取走最多maxItems个元素追加到out中，返回取到的个数
+    size_t takeBatch(size_t maxItems, std::vector<T> &out) {
+        assert(maxItems > 0);
+        MutexLockGuard lock(mutex_);
+        while(queue_.empty()) {
+            waitOn(notEmpty_, consumersWaiting_);
+        }
+        assert(!queue_.empty());
+
+        size_t n = std::min(maxItems, queue_.size());
+        out.reserve(out.size() + n);
+        for(size_t i = 0; i < n; ++i) {
+            out.push_back(std::move(queue_.front()));
+            queue_.pop_front();
+        }
+        notify(notFull_, producersWaiting_, n);
+        return n;
+    }
+
+    // 攒批：最多等待seconds秒，攒够maxItems个或者超时就返回取到的个数（可能为0），语义和BlockingQueue::takeBatchFor相同。
+    // 每取走一段就唤醒生产者，攒批期间队列腾出的空间可以立即被填上
+    size_t takeBatchFor(size_t maxItems, double seconds, std::vector<T> &out) {
+        assert(maxItems > 0);
+        Timestamp deadline = addTime(Timestamp::now(Timestamp::kMonotonic), seconds);
+        MutexLockGuard lock(mutex_);
+        size_t n = 0;
+        bool timedOut = false;
+        for(;;) {
+            size_t taken = 0;
+            for(; n < maxItems && !queue_.empty(); ++n, ++taken) {
+                out.push_back(std::move(queue_.front()));
+                queue_.pop_front();
+            }
+            notify(notFull_, producersWaiting_, taken);
+            if(n == maxItems || timedOut) {
+                break;
+            }
+            timedOut = waitOn(notEmpty_, consumersWaiting_, deadline);
+        }
+        return n;
+    }
+
     bool empty() const {
         MutexLockGuard lock(mutex_);
         return queue_.empty();
@@ -82,11 +195,44 @@ class BoundedBlockingQueue : boost::noncopyable
     }
 
     private:
+        // 等到队列不满或者超过deadline，不满时返回true
+        bool waitNotFull(Timestamp deadline) REQUIRES(mutex_) {
+            while(queue_.full()) {
+                if(waitOn(notFull_, producersWaiting_, deadline) && queue_.full()) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        // 在cond上等待一次，deadline无效时不限时，超时返回true。等待期间计入waiters，notify据此决定唤醒几次
+        bool waitOn(Condition &cond, size_t &waiters, Timestamp deadline = Timestamp::invalid()) REQUIRES(mutex_) {
+            ++waiters;
+            bool timedOut = false;
+            if(deadline.valid()) {
+                timedOut = cond.waitUntil(deadline);
+            }
+            else {
+                cond.wait();
+            }
+            --waiters;
+            return timedOut;
+        }
+
+        // 合并唤醒：一次变化了n个位置时唤醒min(n, waiters)个等待者，不用notifyAll把所有等待者都叫醒去抢这几个位置
+        void notify(Condition &cond, size_t waiters, size_t n) REQUIRES(mutex_) {
+            for(size_t i = std::min(n, waiters); i > 0; --i) {
+                cond.notifyOne();
+            }
+        }
+
         mutable MutexLock mutex_;
         // 使用两个条件变量分别处理两种不同的情况
         Condition         notEmpty_ GUARDED_BY(mutex_);
         Condition         notFull_ GUARDED_BY(mutex_);
-        boost::circular_buffer<T> queue_ GUARDED_BY(mutex_); // circular_buffer是一个环形缓冲区，提供了类似于deque那样的队列相关的接口，适合用来设计有界阻塞队列
+        size_t            consumersWaiting_ GUARDED_BY(mutex_);  // 正在notEmpty_上等待的线程数
+        size_t            producersWaiting_ GUARDED_BY(mutex_);  // 正在notFull_上等待的线程数
+        boost::circular_buffer<T, Alloc> queue_ GUARDED_BY(mutex_); // circular_buffer是一个环形缓冲区，提供了类似于deque那样的队列相关的接口，适合用来设计有界阻塞队列
 
         
 };
@@ -0,0 +1,267 @@
+#ifndef BO_NET_BASE_BOUNDEDMPMCQUEUE_H
+#define BO_NET_BASE_BOUNDEDMPMCQUEUE_H
+
+#include "AsymmetricFence.h"
+#include "Condition.h"
+#include "Mutex.h"
+#include "Types.h"
+
+#include <atomic>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <assert.h>
+
+/**
+ * http://www.1024cores.net/home/lock-free-algorithms/queues/bounded-mpmc-queue
+ * Dmitry Vyukov的有界MPMC队列：每个槽位带一个序号，生产者和消费者各自用CAS推进tail/head，
+ * 通过比较槽位序号和自己拿到的位置判断槽位是否可写/可读，快路径上没有任何锁
+*/
+
+namespace bo_net
+{
+
+// 接口与BoundedBlockingQueue保持一致（put/take/size/capacity/empty/full），可以直接替换；
+// 另外提供非阻塞的tryPut/tryTake。队列满或空时，put/take先自旋一小段时间，仍然不成功再挂起在条件变量上
+//
+// 注意：capacity会被向上取整到2的幂，这样槽位下标可以用位与代替取模
+template<typename T>
+class BoundedMPMCQueue : boost::noncopyable
+{
+    public:
+        explicit BoundedMPMCQueue(int maxSize)
+            : capacity_(roundUpToPowerOfTwo(maxSize)),
+              mask_(capacity_ - 1),
+              slots_(new Slot[capacity_]),
+              mutex_(),
+              notEmpty_(mutex_),
+              notFull_(mutex_)
+        {
+            assert(maxSize > 0);
+            detail::AsymmetricFence::init();
+            for(size_t i = 0; i < capacity_; ++i) {
+                slots_[i].sequence.store(i, std::memory_order_relaxed);
+            }
+            tail_.store(0, std::memory_order_relaxed);
+            head_.store(0, std::memory_order_relaxed);
+            waitingConsumers_.store(0, std::memory_order_relaxed);
+            waitingProducers_.store(0, std::memory_order_relaxed);
+        }
+
+        ~BoundedMPMCQueue() {
+            // 析构时已经不会有并发访问了，把还留在队列里的元素析构掉
+            size_t pos;
+            while(Slot *slot = claimHead(pos)) {
+                slot->item()->~T();
+            }
+            delete[] slots_;
+        }
+
+        bool tryPut(const T &x) {
+            return tryEmplace(x);
+        }
+
+        bool tryPut(T &&x) {
+            return tryEmplace(std::move(x));
+        }
+
+        bool tryTake(T &x) {
+            size_t pos;
+            Slot *slot = claimHead(pos);
+            if(slot == NULL) {
+                return false;
+            }
+            x = std::move(*slot->item());
+            releaseHead(slot, pos);
+            return true;
+        }
+
+        void put(const T &x) {
+            T copy(x);
+            put(std::move(copy));
+        }
+
+        void put(T &&x) {
+            for(int spin = 0; ; ++spin) {
+                if(tryPut(std::move(x))) {
+                    return;
+                }
+                if(spin < kSpinCount) {
+                    cpuRelax();
+                    continue;
+                }
+
+                // 自旋失败，挂起等待消费者取走元素。先登记为等待者再检查队列状态，
+                // 与releaseHead中"先发布槽位再检查等待者"配对，保证唤醒不会丢失。
+                // 这一侧的heavy()负责两边的StoreLoad顺序，快路径上的wakeup()只需要light()
+                MutexLockGuard lock(mutex_);
+                waitingProducers_.fetch_add(1, std::memory_order_seq_cst);
+                detail::AsymmetricFence::heavy();
+                while(fullApprox()) {
+                    notFull_.wait();
+                }
+                waitingProducers_.fetch_sub(1, std::memory_order_relaxed);
+                spin = 0;
+            }
+        }
+
+        T take() {
+            for(int spin = 0; ; ++spin) {
+                size_t pos;
+                if(Slot *slot = claimHead(pos)) {
+                    T front(std::move(*slot->item()));
+                    releaseHead(slot, pos);
+                    return front;
+                }
+                if(spin < kSpinCount) {
+                    cpuRelax();
+                    continue;
+                }
+
+                MutexLockGuard lock(mutex_);
+                waitingConsumers_.fetch_add(1, std::memory_order_seq_cst);
+                detail::AsymmetricFence::heavy();
+                while(emptyApprox()) {
+                    notEmpty_.wait();
+                }
+                waitingConsumers_.fetch_sub(1, std::memory_order_relaxed);
+                spin = 0;
+            }
+        }
+
+        // 以下几个查询函数在并发修改时只是一个近似值
+        bool empty() const {
+            return emptyApprox();
+        }
+
+        bool full() const {
+            return fullApprox();
+        }
+
+        size_t size() const {
+            size_t head = head_.load(std::memory_order_acquire);
+            size_t tail = tail_.load(std::memory_order_acquire);
+            // 先读head再读tail，tail >= head总是成立；极端情况下读到的差值可能瞬时超过capacity
+            size_t n = tail - head;
+            return n > capacity_ ? capacity_ : n;
+        }
+
+        size_t capacity() const {
+            return capacity_;
+        }
+
+    private:
+        static const int kSpinCount = 64;
+
+        struct Slot
+        {
+            std::atomic<size_t> sequence;
+            typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+
+            T* item() { return reinterpret_cast<T*>(&storage); }
+        };
+
+        static size_t roundUpToPowerOfTwo(int n) {
+            size_t size = 1;
+            while(size < static_cast<size_t>(n)) {
+                size <<= 1;
+            }
+            return size;
+        }
+
+        template<typename U>
+        bool tryEmplace(U &&x) {
+            Slot *slot;
+            size_t pos = tail_.load(std::memory_order_relaxed);
+            for(;;) {
+                slot = &slots_[pos & mask_];
+                size_t seq = slot->sequence.load(std::memory_order_acquire);
+                intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+                if(diff == 0) {
+                    if(tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                        break;
+                    }
+                }
+                else if(diff < 0) {
+                    return false; // 上一轮的元素还没有被取走，队列已满
+                }
+                else {
+                    pos = tail_.load(std::memory_order_relaxed);
+                }
+            }
+
+            new (slot->item()) T(std::forward<U>(x));
+            slot->sequence.store(pos + 1, std::memory_order_release);
+            wakeup(waitingConsumers_, notEmpty_);
+            return true;
+        }
+
+        // 抢占head位置上已经写好的槽位，队列为空时返回NULL
+        Slot* claimHead(size_t &pos) {
+            Slot *slot;
+            pos = head_.load(std::memory_order_relaxed);
+            for(;;) {
+                slot = &slots_[pos & mask_];
+                size_t seq = slot->sequence.load(std::memory_order_acquire);
+                intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+                if(diff == 0) {
+                    if(head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                        return slot;
+                    }
+                }
+                else if(diff < 0) {
+                    return NULL; // 槽位还没有被写入，队列为空
+                }
+                else {
+                    pos = head_.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        // 元素已经被移走，析构槽位里的对象，并把槽位序号推进一圈，表示可以被下一轮的生产者使用
+        void releaseHead(Slot *slot, size_t pos) {
+            slot->item()->~T();
+            slot->sequence.store(pos + capacity_, std::memory_order_release);
+            wakeup(waitingProducers_, notFull_);
+        }
+
+        // 只有确实有线程挂起时才去拿锁。内核支持membarrier时，快路径上只多一次relaxed原子读，
+        // 没有任何屏障指令；不支持时多一次seq_cst fence（x86上是mfence，几十个周期，见Primitives_bench的fence/用例）
+        void wakeup(std::atomic<int> &waiters, Condition &cond) {
+            detail::AsymmetricFence::light();
+            if(waiters.load(std::memory_order_relaxed) > 0) {
+                MutexLockGuard lock(mutex_);
+                cond.notifyOne();
+            }
+        }
+
+        bool emptyApprox() const {
+            size_t pos = head_.load(std::memory_order_acquire);
+            size_t seq = slots_[pos & mask_].sequence.load(std::memory_order_acquire);
+            return static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1) < 0;
+        }
+
+        bool fullApprox() const {
+            size_t pos = tail_.load(std::memory_order_acquire);
+            size_t seq = slots_[pos & mask_].sequence.load(std::memory_order_acquire);
+            return static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos) < 0;
+        }
+
+        const size_t capacity_;
+        const size_t mask_;
+        Slot *const  slots_;
+
+        // head和tail分别被消费者和生产者频繁修改，各自独占一个cache line，避免false sharing
+        alignas(kCacheLineSize) std::atomic<size_t> tail_;
+        alignas(kCacheLineSize) std::atomic<size_t> head_;
+
+        alignas(kCacheLineSize) std::atomic<int> waitingConsumers_;
+        std::atomic<int>  waitingProducers_;
+        mutable MutexLock mutex_;  // 只在挂起/唤醒的慢路径上使用
+        Condition         notEmpty_;
+        Condition         notFull_;
+};
+
+} // namespace bo_net
+
+#endif // BO_NET_BASE_BOUNDEDMPMCQUEUE_H
@@ -1,22 +1,70 @@
 
 #include "Condition.h"
+#include "Futex.h"
 
 #include <errno.h>
 #include <time.h>
 #include <inttypes.h>
 
+namespace
+{
+
+const int64_t kNanoSecondsPerSecond = 1000000000;
+
+} // namespace
+
 // 超时返回true，否则返回false
 bool bo_net::Condition::waitForSeconds(double seconds) {
+    int64_t nanoseconds = static_cast<int64_t>(seconds * kNanoSecondsPerSecond);
+    return waitUntilNanos(Timestamp::nowNanos(Timestamp::kMonotonic) + nanoseconds);
+}
 
-    struct timespec abstime;
-    clock_gettime(CLOCK_REALTIME, &abstime);
+bool bo_net::Condition::waitUntil(Timestamp deadline) {
+    return waitUntilNanos(deadline.microSecondsSinceEpoth() * 1000);
+}
 
-    const int64_t kNanoSecondsPerSecond = 1000000000;
-    int64_t nanoseconds = static_cast<int64_t>(seconds * kNanoSecondsPerSecond);
+bool bo_net::Condition::waitUntilNanos(int64_t deadline) {
+    if(mutex_.policy() != MutexLock::kPthread) {
+        // FUTEX_WAIT的超时是相对时间，内核按CLOCK_MONOTONIC计时
+        int64_t nanoseconds = deadline - Timestamp::nowNanos(Timestamp::kMonotonic);
+        if(nanoseconds <= 0) {
+            return true;
+        }
+        struct timespec reltime;
+        reltime.tv_sec = static_cast<time_t>(nanoseconds / kNanoSecondsPerSecond);
+        reltime.tv_nsec = static_cast<long>(nanoseconds % kNanoSecondsPerSecond);
+        return waitOnFutex(&reltime);
+    }
 
-    abstime.tv_sec += static_cast<time_t>((abstime.tv_nsec + nanoseconds) / kNanoSecondsPerSecond);
-    abstime.tv_nsec = static_cast<long>((abstime.tv_nsec + nanoseconds) % kNanoSecondsPerSecond);
+    // pcond_构造时用condattr指定了CLOCK_MONOTONIC，abstime也是这个时钟上的时间
+    struct timespec abstime;
+    abstime.tv_sec = static_cast<time_t>(deadline / kNanoSecondsPerSecond);
+    abstime.tv_nsec = static_cast<long>(deadline % kNanoSecondsPerSecond);
 
     MutexLock::UnassignGuard ug(mutex_);
-    return ETIMEDOUT == pthread_cond_timedwait(&pcond_, mutex_.getPthreadMutex(), &abstime);    
+    return ETIMEDOUT == pthread_cond_timedwait(&pcond_, mutex_.getPthreadMutex(), &abstime);
+}
+
+bool bo_net::Condition::waitOnFutex(const struct timespec *timeout) {
+    // 持有锁时先登记、再读序号，notify的一方在修改条件之后才递增序号，
+    // 因此解锁之后发生的notify一定会让futexWait立即返回，不会丢失唤醒
+    waiters_.fetch_add(1, std::memory_order_seq_cst);
+    int sequence = sequence_.load(std::memory_order_seq_cst);
+
+    int err;
+    {
+        MutexLock::UnassignGuard ug(mutex_);
+        mutex_.unlockInternal();
+        err = detail::futexWait(&sequence_, sequence, timeout);
+        mutex_.lockInternal();
+    }
+    waiters_.fetch_sub(1, std::memory_order_relaxed);
+    return err == ETIMEDOUT;
+}
+
+void bo_net::Condition::notifyOnFutex(int n) {
+    sequence_.fetch_add(1, std::memory_order_seq_cst);
+    if(waiters_.load(std::memory_order_seq_cst) > 0) {
+        detail::futexWake(&sequence_, n);
+    }
 }
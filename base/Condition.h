@@ -1,20 +1,31 @@
 # pragma once
 
 #include "Mutex.h"
+#include "Timestamp.h"
 
+#include <limits.h>
 #include <pthread.h>
 
 namespace bo_net
 {
 
+// 对于kPthread策略的MutexLock使用pthread_cond_t；另外两种策略的锁不是pthread_mutex_t，
+// 用一个futex序号实现条件变量：等待者记下序号后解锁睡眠，notify时递增序号并唤醒。
+// 两种实现的超时都按CLOCK_MONOTONIC计算，NTP调整或者手动修改系统时间不会让等待提前结束或者多等
 class Condition : boost::noncopyable
 {
     public:
 
         explicit Condition(MutexLock &mutex)
-            : mutex_(mutex) 
+            : mutex_(mutex),
+              sequence_(0),
+              waiters_(0)
         {
-            MCHECK(pthread_cond_init(&pcond_, NULL));
+            pthread_condattr_t attr;
+            MCHECK(pthread_condattr_init(&attr));
+            MCHECK(pthread_condattr_setclock(&attr, CLOCK_MONOTONIC));
+            MCHECK(pthread_cond_init(&pcond_, &attr));
+            MCHECK(pthread_condattr_destroy(&attr));
         }
 
         ~Condition() {
@@ -22,25 +33,50 @@ class Condition : boost::noncopyable
         }
 
         void wait() { 
+            if(mutex_.policy() != MutexLock::kPthread) {
+                waitOnFutex(NULL);
+                return;
+            }
             MutexLock::UnassignGuard ug(mutex_); // Condition是MutexLock的友元类，这里使用RAII的方式来修改MutexLock里面的holder_
             MCHECK(pthread_cond_wait(&pcond_, mutex_.getPthreadMutex()));  // 注意这个系统调用需要获取到MutexLock的底层pthread锁
         }
 
+        // 超时返回true，和wait()一样可能被虚假唤醒，调用者需要在循环里重新检查条件
         bool waitForSeconds(double seconds);
 
+        // 等到deadline为止，deadline是Timestamp::now(Timestamp::kMonotonic)时钟上的时间点，
+        // 已经过去时直接返回true。在循环里反复等待同一个截止时间时，总的等待时间不会因为虚假唤醒而变长
+        bool waitUntil(Timestamp deadline);
+
         void notifyOne() {
+            if(mutex_.policy() != MutexLock::kPthread) {
+                notifyOnFutex(1);
+                return;
+            }
             MCHECK(pthread_cond_signal(&pcond_));
         }
 
         void notifyAll() {
+            if(mutex_.policy() != MutexLock::kPthread) {
+                notifyOnFutex(INT_MAX);
+                return;
+            }
             MCHECK(pthread_cond_broadcast(&pcond_));
         }
 
     private:
+        // deadline是CLOCK_MONOTONIC上的纳秒数
+        bool waitUntilNanos(int64_t deadline);
+
+        // 超时返回true
+        bool waitOnFutex(const struct timespec *timeout);
+        void notifyOnFutex(int n);
 
         MutexLock &mutex_;  // 因为要处理MutexLock的holder_，所以需要在Condition里面事先就拿到对应的MutexLock对象
                             // 一般情况下，条件变量在定义的时候已经比较明确和哪一个互斥锁协作，因此直接在初始化时就直接拿到对应的互斥锁也可以
         pthread_cond_t pcond_;
+        std::atomic<int> sequence_;  // 非pthread策略：每次notify加一，等待者在这个地址上futex睡眠
+        std::atomic<int> waiters_;   // 非pthread策略：正在等待的线程个数，没有等待者时notify不进入内核
 };
 
 } // namespace bo_net
\ No newline at end of file
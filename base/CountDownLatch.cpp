@@ -1,41 +1,66 @@
 #include "CountDownLatch.h"
+#include "Futex.h"
+
+#include <assert.h>
+#include <limits.h>
 
 using namespace bo_net;
 
 
 CountDownLatch::CountDownLatch(int count)
-  : mutex_(),
-    condition_(mutex_),
-    count_(count)
+  : count_(count > 0 ? count : 0)
 {
+  assert(count <= kCountMask);
 }
 
 void CountDownLatch::wait()
 {
-  MutexLockGuard lock(mutex_);
-  while (count_ > 0)
+  int value = count_.load(std::memory_order_acquire);
+  while (value != 0)
   {
-    condition_.wait();
+    // 先置上等待者标志再睡眠：countDown()归零时要么看到标志而唤醒，要么futexWait看到值已经变了而立即返回
+    if (!(value & kWaitersFlag))
+    {
+      if (!count_.compare_exchange_weak(value, value | kWaitersFlag, std::memory_order_acquire))
+      {
+        continue;
+      }
+      value |= kWaitersFlag;
+    }
+    detail::futexWait(&count_, value);
+    value = count_.load(std::memory_order_acquire);
   }
 }
 
 void CountDownLatch::countDown()
 {
-  MutexLockGuard lock(mutex_);
-  --count_;
-  if (count_ == 0)
+  int value = count_.load(std::memory_order_relaxed);
+  for (;;)
   {
-    condition_.notifyAll();
+    if ((value & kCountMask) == 0)
+    {
+      return;
+    }
+    // 减到0时连同等待者标志一起清掉，归零之后的第一个值就是0
+    int next = (value & kCountMask) == 1 ? 0 : value - 1;
+    if (count_.compare_exchange_weak(value, next, std::memory_order_acq_rel, std::memory_order_relaxed))
+    {
+      if (next == 0 && (value & kWaitersFlag))
+      {
+        // 这里只把count_的地址交给内核，不再读写对象；latch即使已经被析构，
+        // 最坏也只是一次多余的唤醒，futex的使用者本来就要能处理
+        detail::futexWake(&count_, INT_MAX);
+      }
+      return;
+    }
   }
 }
 
 int CountDownLatch::getCount() const
 {
-  MutexLockGuard lock(mutex_);
-  return count_;
+  return count_.load(std::memory_order_acquire) & kCountMask;
 }
 
-
 // CountDownLatch::CountDownLatch(int count)
 //     : mutex_(),
 //       condition_(),
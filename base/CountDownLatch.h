@@ -1,11 +1,16 @@
 #pragma once
 
-#include "Condition.h"
-#include "Mutex.h"
+#include <boost/noncopyable.hpp>
+#include <atomic>
 
 namespace bo_net
 {
 
+// 计数本身是一个原子变量，countDown()只是一次原子读-改-写；只有减到0的那一次，并且确实有线程在等待时，
+// 才会进入内核唤醒等待者。wait()在计数还没有归零时置上"有等待者"位，睡眠在计数变量的futex上。
+//
+// 等待者标志和计数在同一个变量里：计数归零的那次修改同时决定要不要唤醒，之后不再读写对象的任何成员。
+// wait()返回之后latch通常马上被析构（例如栈上的latch），countDown()不能在归零之后再访问它
 class CountDownLatch : boost::noncopyable
 {
     public:
@@ -19,9 +24,10 @@ class CountDownLatch : boost::noncopyable
     int getCount() const;
 
     private:
-    mutable MutexLock mutex_;
-    Condition condition_ GUARDED_BY(mutex_);
-    int count_ GUARDED_BY(mutex_);
+    static const int kWaitersFlag = 1 << 30;        // 有线程睡眠在count_上
+    static const int kCountMask = kWaitersFlag - 1;
+
+    std::atomic<int> count_;  // 低30位是计数，归零时等待者标志一起清掉
 };
 
 }  // namespace bo_net
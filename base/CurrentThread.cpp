@@ -0,0 +1,78 @@
+#include "CurrentThread.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace bo_net
+{
+
+namespace CurrentThread
+{
+
+__thread int t_cachedTid = 0;
+__thread char t_tidString[32];
+__thread int t_tidStringLength = 6;
+__thread const char* t_threadName = "unknown";
+
+}  // namespace CurrentThread
+
+namespace detail
+{
+
+pid_t gettid()
+{
+  return static_cast<pid_t>(::syscall(SYS_gettid));
+}
+
+// fork之后子进程只剩下调用fork的那个线程，它的tid变了，必须清掉父进程里缓存的值
+void afterFork()
+{
+  CurrentThread::t_cachedTid = 0;
+  CurrentThread::t_threadName = "main";
+  CurrentThread::tid();
+}
+
+class ThreadNameInitializer
+{
+ public:
+  ThreadNameInitializer()
+  {
+    CurrentThread::t_threadName = "main";
+    CurrentThread::tid();
+    pthread_atfork(NULL, NULL, &afterFork);
+  }
+};
+
+ThreadNameInitializer init;
+
+}  // namespace detail
+
+}  // namespace bo_net
+
+using namespace bo_net;
+
+void CurrentThread::cacheTid()
+{
+  if (t_cachedTid == 0)
+  {
+    t_cachedTid = detail::gettid();
+    t_tidStringLength = snprintf(t_tidString, sizeof t_tidString, "%5d ", t_cachedTid);
+  }
+}
+
+bool CurrentThread::isMainThread()
+{
+  return tid() == ::getpid();
+}
+
+void CurrentThread::sleepUsec(int64_t usec)
+{
+  const int64_t kMicroSecondsPerSecond = 1000 * 1000;
+  struct timespec ts = { 0, 0 };
+  ts.tv_sec = static_cast<time_t>(usec / kMicroSecondsPerSecond);
+  ts.tv_nsec = static_cast<long>(usec % kMicroSecondsPerSecond * 1000);
+  ::nanosleep(&ts, NULL);
+}
@@ -0,0 +1,54 @@
+#ifndef BO_NET_BASE_CURRENTTHREAD_H
+#define BO_NET_BASE_CURRENTTHREAD_H
+
+#include <stdint.h>
+
+namespace bo_net
+{
+
+// 每个线程第一次调用tid()时执行一次gettid系统调用，之后都从线程局部存储中读取，
+// MutexLock每次加锁解锁都会调用tid()，因此这里不能有系统调用
+//
+// 使用__thread而不是thread_local：两者都是线程局部存储，但extern的thread_local变量
+// 每次访问都要经过编译器生成的TLS包装函数（检查动态初始化），__thread只能用于POD类型，访问就是一次内存读取
+namespace CurrentThread
+{
+    // internal
+    extern __thread int t_cachedTid;
+    extern __thread char t_tidString[32];
+    extern __thread int t_tidStringLength;
+    extern __thread const char* t_threadName;
+
+    void cacheTid();
+
+    inline int tid() {
+        if(__builtin_expect(t_cachedTid == 0, 0)) {
+            cacheTid();
+        }
+        return t_cachedTid;
+    }
+
+    // 预先格式化好的tid字符串，给日志使用，避免每一行日志都做一次整数转换
+    inline const char* tidString() {
+        tid();
+        return t_tidString;
+    }
+
+    inline int tidStringLength() {
+        tid();
+        return t_tidStringLength;
+    }
+
+    inline const char* name() {
+        return t_threadName;
+    }
+
+    bool isMainThread();
+
+    void sleepUsec(int64_t usec);  // for testing
+
+} // namespace CurrentThread
+
+} // namespace bo_net
+
+#endif // BO_NET_BASE_CURRENTTHREAD_H
@@ -1,3 +1,39 @@
+#include "Date.h"
 
+#include <time.h>
 
+using namespace bo_net;
 
+Date::Date(const struct tm& t)
+  : julianDayNumber_(static_cast<int>(detail::daysFromCivil(t.tm_year + 1900, t.tm_mon + 1, t.tm_mday)) + kJulianDayOf1970_01_01)
+{
+}
+
+size_t Date::formatIsoTo(char* buf, size_t len) const
+{
+  const size_t kIsoLength = 10;  // yyyy-mm-dd
+  YearMonthDay ymd(yearMonthDay());
+  if (len < kIsoLength + 1 || ymd.year < 0 || ymd.year > 9999)
+  {
+    return 0;
+  }
+  buf[0] = static_cast<char>('0' + ymd.year / 1000);
+  buf[1] = static_cast<char>('0' + ymd.year / 100 % 10);
+  buf[2] = static_cast<char>('0' + ymd.year / 10 % 10);
+  buf[3] = static_cast<char>('0' + ymd.year % 10);
+  buf[4] = '-';
+  buf[5] = static_cast<char>('0' + ymd.month / 10);
+  buf[6] = static_cast<char>('0' + ymd.month % 10);
+  buf[7] = '-';
+  buf[8] = static_cast<char>('0' + ymd.day / 10);
+  buf[9] = static_cast<char>('0' + ymd.day % 10);
+  buf[10] = '\0';
+  return kIsoLength;
+}
+
+string Date::toIsoString() const
+{
+  char buf[32];
+  size_t n = formatIsoTo(buf, sizeof buf);
+  return string(buf, n);
+}
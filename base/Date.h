@@ -0,0 +1,141 @@
+#ifndef BO_NET_BASE_DATE_H
+#define BO_NET_BASE_DATE_H
+
+#include "copyable.h"
+#include "Types.h"
+
+struct tm;
+
+namespace bo_net
+{
+
+namespace detail
+{
+
+// http://howardhinnant.github.io/date_algorithms.html
+// 纪元（1970-01-01）以来的天数与公历年月日之间的互相转换，纯整数运算，不依赖gmtime_r的时区和locale，
+// 而且都是constexpr，编译期就可以算出常量日期
+
+struct YearMonthDay
+{
+    int year;   // 公历年（向前推算的格里历），0表示公元前1年，算法本身不限范围
+    int month;  // [1..12]
+    int day;    // [1..31]
+};
+
+// 公历年月日 -> 纪元以来的天数。把三月当作一年的第一个月，闰日就落在一年的最后，计算每月的天数时不需要特殊处理二月
+constexpr int64_t daysFromCivil(int year, int month, int day)
+{
+    // C++14起constexpr函数里可以有局部变量和多条语句
+    year -= month <= 2;
+    const int64_t era = (year >= 0 ? year : year - 399) / 400;
+    const int yoe = static_cast<int>(year - era * 400);                      // [0, 399]
+    const int doy = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;  // [0, 365]
+    const int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;                   // [0, 146096]
+    return era * 146097 + doe - 719468;
+}
+
+// 纪元以来的天数 -> 公历年月日
+constexpr YearMonthDay civilFromDays(int64_t days)
+{
+    days += 719468;
+    const int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+    const int doe = static_cast<int>(days - era * 146097);                  // [0, 146096]
+    const int yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;  // [0, 399]
+    const int doy = doe - (365 * yoe + yoe / 4 - yoe / 100);                // [0, 365]
+    const int mp = (5 * doy + 2) / 153;                                     // [0, 11]，从三月开始算
+    const int day = doy - (153 * mp + 2) / 5 + 1;                           // [1, 31]
+    const int month = mp < 10 ? mp + 3 : mp - 9;                            // [1, 12]
+    const int year = static_cast<int>(yoe + era * 400) + (month <= 2);
+    return YearMonthDay{ year, month, day };
+}
+
+} // namespace detail
+
+// UTC日期，内部只保存一个儒略日编号（Julian Day Number），可以直接比较、相减
+class Date : public bo_net::copyable
+{
+    public:
+        typedef detail::YearMonthDay YearMonthDay;
+
+        static const int kDaysPerWeek = 7;
+        static const int kJulianDayOf1970_01_01 = 2440588;
+
+        // Constucts an invalid Date.
+        constexpr Date()
+            : julianDayNumber_(0)
+        {
+        }
+
+        // Constucts a yyyy-mm-dd Date.
+        // 1 <= month <= 12
+        constexpr Date(int year, int month, int day)
+            : julianDayNumber_(static_cast<int>(detail::daysFromCivil(year, month, day)) + kJulianDayOf1970_01_01)
+        {
+        }
+
+        constexpr explicit Date(int julianDayNum)
+            : julianDayNumber_(julianDayNum)
+        {
+        }
+
+        // Constucts a Date from struct tm
+        explicit Date(const struct tm&);
+
+        // 纪元以来的天数，Timestamp就是通过它把秒数转换成日期的
+        static constexpr Date fromDaysSinceEpoch(int64_t days) {
+            return Date(static_cast<int>(days) + kJulianDayOf1970_01_01);
+        }
+
+        // default copy/assignment/dtor are Okay
+
+        void swap(Date &that) {
+            std::swap(julianDayNumber_, that.julianDayNumber_);
+        }
+
+        constexpr bool valid() const { return julianDayNumber_ > 0; }
+
+        // Converts to yyyy-mm-dd format.
+        string toIsoString() const;
+        // 不分配内存的版本，写入"yyyy-mm-dd"和'\0'，返回写入的字符数，buf放不下时返回0
+        size_t formatIsoTo(char *buf, size_t len) const;
+
+        constexpr YearMonthDay yearMonthDay() const {
+            return detail::civilFromDays(daysSinceEpoch());
+        }
+
+        constexpr int year() const { return yearMonthDay().year; }
+        constexpr int month() const { return yearMonthDay().month; }
+        constexpr int day() const { return yearMonthDay().day; }
+
+        // [0, 1, ..., 6] => [Sunday, Monday, ..., Saturday ]
+        constexpr int weekDay() const {
+            return (julianDayNumber_ + 1) % kDaysPerWeek;
+        }
+
+        constexpr int julianDayNumber() const { return julianDayNumber_; }
+
+        constexpr int64_t daysSinceEpoch() const {
+            return julianDayNumber_ - kJulianDayOf1970_01_01;
+        }
+
+    private:
+        int julianDayNumber_;
+};
+
+inline constexpr bool operator<(Date x, Date y) {
+    return x.julianDayNumber() < y.julianDayNumber();
+}
+
+inline constexpr bool operator==(Date x, Date y) {
+    return x.julianDayNumber() == y.julianDayNumber();
+}
+
+static_assert(Date(1970, 1, 1).julianDayNumber() == Date::kJulianDayOf1970_01_01, "1970-01-01");
+static_assert(Date(2000, 3, 1).daysSinceEpoch() == 11017, "2000-03-01");
+static_assert(Date::fromDaysSinceEpoch(11016).day() == 29, "2000 is a leap year");
+static_assert(Date(1970, 1, 1).weekDay() == 4, "1970-01-01 is Thursday");
+
+} // namespace bo_net
+
+#endif // BO_NET_BASE_DATE_H
@@ -0,0 +1,340 @@
+#ifndef BO_NET_BASE_DELAYQUEUE_H
+#define BO_NET_BASE_DELAYQUEUE_H
+
+#include "Condition.h"
+#include "CurrentThread.h"
+#include "Mutex.h"
+#include "Timestamp.h"
+
+#include <algorithm>
+#include <stdint.h>
+#include <vector>
+#include <assert.h>
+
+namespace bo_net
+{
+
+/**
+ * 延迟队列：每个元素带一个截止时间，take()阻塞到队首元素的截止时间过去才返回，适合重试、限流放行、延迟任务。
+ * - 截止时间是Timestamp::now(Timestamp::kMonotonic)时钟上的时间点，用now()取当前时间，不受NTP和修改系统时间影响；
+ * - 内部是4叉小根堆，同一个截止时间按放入的先后顺序出队。4叉堆比二叉堆矮一半，下沉时比较的4个孩子在同一段连续内存里；
+ * - put()返回一个Handle，cancel(handle)在O(log n)内删除还没有出队的元素，元素出队或者取消之后handle自动失效；
+ * - leader/follower：同一时刻只有一个消费者（leader）按队首的截止时间定时等待，其余消费者无限期等待。
+ *   新元素成为队首时只唤醒一个线程来重新计时，队首到期时leader取走它之后再唤醒一个follower接班，
+ *   不会每放入一个元素就把所有消费者都叫醒去抢同一个队首
+*/
+template<typename T>
+class DelayQueue : boost::noncopyable
+{
+    public:
+        // 指向队列中某个元素的句柄，可以复制，默认构造的句柄无效
+        class Handle
+        {
+            public:
+                Handle()
+                    : slot_(kInvalidSlot),
+                      generation_(0)
+                {
+                }
+
+                bool valid() const { return slot_ != kInvalidSlot; }
+
+            private:
+                friend class DelayQueue;
+
+                Handle(uint32_t slot, uint32_t generation)
+                    : slot_(slot),
+                      generation_(generation)
+                {
+                }
+
+                uint32_t slot_;
+                uint32_t generation_;
+        };
+
+        DelayQueue()
+            : mutex_(),
+              available_(mutex_),
+              leader_(0),
+              sequence_(0),
+              freeSlot_(kInvalidSlot)
+        {
+        }
+
+        // 截止时间使用的时钟
+        static Timestamp now() {
+            return Timestamp::now(Timestamp::kMonotonic);
+        }
+
+        Handle put(const T &x, Timestamp when) {
+            MutexLockGuard lock(mutex_);
+            return push(Entry(x, when));
+        }
+
+        Handle put(T &&x, Timestamp when) {
+            MutexLockGuard lock(mutex_);
+            return push(Entry(std::move(x), when));
+        }
+
+        Handle putAfter(T x, double seconds) {
+            return put(std::move(x), addTime(now(), seconds));
+        }
+
+        // 删除handle对应的元素，元素已经出队、已经取消或者handle无效时返回false
+        bool cancel(Handle handle) {
+            MutexLockGuard lock(mutex_);
+            if(handle.slot_ >= slots_.size()) {
+                return false;
+            }
+            Slot &slot = slots_[handle.slot_];
+            if(slot.generation != handle.generation_) {
+                return false;
+            }
+            size_t index = slot.index;
+            removeAt(index);
+            // 取消的是队首：leader可能还在按旧的截止时间等待，让它重新计时
+            if(index == 0) {
+                leader_ = 0;
+                available_.notifyOne();
+            }
+            return true;
+        }
+
+        // 阻塞直到队首元素到期，取走并返回它
+        T take() {
+            MutexLockGuard lock(mutex_);
+            waitForExpired();
+            T front(popFront());
+            handOver();
+            return front;
+        }
+
+        // 阻塞直到队首元素到期，然后一次取走所有已经到期的元素（最多maxItems个）追加到out中，返回取到的个数
+        size_t takeBatch(size_t maxItems, std::vector<T> &out) {
+            assert(maxItems > 0);
+            MutexLockGuard lock(mutex_);
+            waitForExpired();
+            size_t n = drainExpiredLocked(now(), maxItems, out);
+            handOver();
+            return n;
+        }
+
+        // 不阻塞，取走所有已经到期的元素（最多maxItems个），返回取到的个数
+        size_t drainExpired(std::vector<T> &out, size_t maxItems = SIZE_MAX) {
+            MutexLockGuard lock(mutex_);
+            size_t n = drainExpiredLocked(now(), maxItems, out);
+            if(n > 0) {
+                handOver();
+            }
+            return n;
+        }
+
+        // 队首元素的截止时间，队列为空时返回无效的Timestamp
+        Timestamp earliest() const {
+            MutexLockGuard lock(mutex_);
+            return heap_.empty() ? Timestamp::invalid() : heap_.front().when;
+        }
+
+        size_t size() const {
+            MutexLockGuard lock(mutex_);
+            return heap_.size();
+        }
+
+        bool empty() const {
+            return size() == 0;
+        }
+
+    private:
+        static const uint32_t kInvalidSlot = UINT32_MAX;
+        static const size_t kArity = 4;
+
+        struct Entry
+        {
+            Entry(const T &x, Timestamp w)
+                : when(w), sequence(0), slot(kInvalidSlot), value(x)
+            {
+            }
+
+            Entry(T &&x, Timestamp w)
+                : when(w), sequence(0), slot(kInvalidSlot), value(std::move(x))
+            {
+            }
+
+            Timestamp when;
+            uint64_t  sequence;  // 截止时间相同时先放入的先出队
+            uint32_t  slot;
+            T         value;
+        };
+
+        // handle通过slot找到元素在堆中的下标。slot释放时generation加一，旧的handle就对不上了；
+        // 空闲的slot用index串成链表，下次放入元素时复用
+        struct Slot
+        {
+            size_t   index;
+            uint32_t generation;
+        };
+
+        static bool before(const Entry &lhs, const Entry &rhs) {
+            if(lhs.when == rhs.when) {
+                return lhs.sequence < rhs.sequence;
+            }
+            return lhs.when < rhs.when;
+        }
+
+        Handle push(Entry &&entry) REQUIRES(mutex_) {
+            uint32_t slot = allocSlot();
+            entry.sequence = sequence_++;
+            entry.slot = slot;
+            heap_.push_back(std::move(entry));
+            slots_[slot].index = heap_.size() - 1;
+            siftUp(heap_.size() - 1);
+            // 只有新元素成为队首时才需要有人重新计时：撤掉当前的leader，只唤醒一个线程
+            if(slots_[slot].index == 0) {
+                leader_ = 0;
+                available_.notifyOne();
+            }
+            return Handle(slot, slots_[slot].generation);
+        }
+
+        uint32_t allocSlot() REQUIRES(mutex_) {
+            if(freeSlot_ != kInvalidSlot) {
+                uint32_t slot = freeSlot_;
+                freeSlot_ = static_cast<uint32_t>(slots_[slot].index);
+                return slot;
+            }
+            Slot s;
+            s.index = kInvalidSlot;
+            s.generation = 0;
+            slots_.push_back(s);
+            return static_cast<uint32_t>(slots_.size() - 1);
+        }
+
+        void freeSlot(uint32_t slot) REQUIRES(mutex_) {
+            ++slots_[slot].generation;
+            slots_[slot].index = freeSlot_;
+            freeSlot_ = slot;
+        }
+
+        // 等到队首元素到期：leader按截止时间定时等待，follower无限期等待leader交接
+        void waitForExpired() REQUIRES(mutex_) {
+            for(;;) {
+                if(heap_.empty()) {
+                    available_.wait();
+                    continue;
+                }
+                Timestamp when = heap_.front().when;
+                if(!(now() < when)) {
+                    return;
+                }
+                if(leader_ != 0) {
+                    available_.wait();
+                    continue;
+                }
+                int self = CurrentThread::tid();
+                leader_ = self;
+                available_.waitUntil(when);
+                if(leader_ == self) {
+                    leader_ = 0;
+                }
+            }
+        }
+
+        // 取走元素之后，如果没有leader并且队列里还有元素，唤醒一个follower接班
+        void handOver() REQUIRES(mutex_) {
+            if(leader_ == 0 && !heap_.empty()) {
+                available_.notifyOne();
+            }
+        }
+
+        size_t drainExpiredLocked(Timestamp current, size_t maxItems, std::vector<T> &out) REQUIRES(mutex_) {
+            size_t n = 0;
+            while(n < maxItems && !heap_.empty() && !(current < heap_.front().when)) {
+                out.push_back(popFront());
+                ++n;
+            }
+            return n;
+        }
+
+        T popFront() REQUIRES(mutex_) {
+            assert(!heap_.empty());
+            T front(std::move(heap_.front().value));
+            removeAt(0);
+            return front;
+        }
+
+        // 用最后一个元素填补index的位置，再根据它和新位置的父节点的大小关系上浮或者下沉
+        void removeAt(size_t index) REQUIRES(mutex_) {
+            assert(index < heap_.size());
+            freeSlot(heap_[index].slot);
+            size_t last = heap_.size() - 1;
+            if(index != last) {
+                heap_[index] = std::move(heap_[last]);
+                slots_[heap_[index].slot].index = index;
+            }
+            heap_.pop_back();
+            if(index < heap_.size()) {
+                if(index > 0 && before(heap_[index], heap_[(index - 1) / kArity])) {
+                    siftUp(index);
+                }
+                else {
+                    siftDown(index);
+                }
+            }
+        }
+
+        void siftUp(size_t index) REQUIRES(mutex_) {
+            Entry entry(std::move(heap_[index]));
+            while(index > 0) {
+                size_t parent = (index - 1) / kArity;
+                if(!before(entry, heap_[parent])) {
+                    break;
+                }
+                moveTo(parent, index);
+                index = parent;
+            }
+            heap_[index] = std::move(entry);
+            slots_[heap_[index].slot].index = index;
+        }
+
+        void siftDown(size_t index) REQUIRES(mutex_) {
+            Entry entry(std::move(heap_[index]));
+            const size_t n = heap_.size();
+            for(;;) {
+                size_t first = index * kArity + 1;
+                if(first >= n) {
+                    break;
+                }
+                size_t last = std::min(first + kArity, n);
+                size_t child = first;
+                for(size_t i = first + 1; i < last; ++i) {
+                    if(before(heap_[i], heap_[child])) {
+                        child = i;
+                    }
+                }
+                if(!before(heap_[child], entry)) {
+                    break;
+                }
+                moveTo(child, index);
+                index = child;
+            }
+            heap_[index] = std::move(entry);
+            slots_[heap_[index].slot].index = index;
+        }
+
+        void moveTo(size_t from, size_t to) REQUIRES(mutex_) {
+            heap_[to] = std::move(heap_[from]);
+            slots_[heap_[to].slot].index = to;
+        }
+
+        mutable MutexLock  mutex_;
+        Condition          available_ GUARDED_BY(mutex_);
+        int                leader_ GUARDED_BY(mutex_);  // 正在定时等待队首的消费者线程id，0表示没有
+        uint64_t           sequence_ GUARDED_BY(mutex_);
+        std::vector<Entry> heap_ GUARDED_BY(mutex_);
+        std::vector<Slot>  slots_ GUARDED_BY(mutex_);
+        uint32_t           freeSlot_ GUARDED_BY(mutex_);
+};
+
+} // namespace bo_net
+
+#endif // BO_NET_BASE_DELAYQUEUE_H
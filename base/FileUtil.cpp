@@ -0,0 +1,182 @@
+#include "FileUtil.h"
+
+#include <algorithm>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace bo_net;
+
+namespace
+{
+
+// 每次预分配并映射16MB，按1GB/小时的日志量大约每分钟才需要换一次映射
+const size_t kChunkSize = 16 * 1024 * 1024;
+
+}  // namespace
+
+FileUtil::MappedAppendFile::MappedAppendFile(const string& filename)
+  : fd_(::open(filename.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644)),
+    chunk_(NULL),
+    chunkOffset_(0),
+    chunkSize_(kChunkSize),
+    chunkPos_(0),
+    flushedPos_(0),
+    writtenBytes_(0),
+    droppedBytes_(0)
+{
+  if (fd_ < 0)
+  {
+    fprintf(stderr, "MappedAppendFile: open %s failed: %s\n", filename.c_str(), strerror(errno));
+    return;
+  }
+  // 文件已经存在时接在原有内容后面写
+  struct stat st;
+  if (::fstat(fd_, &st) == 0)
+  {
+    writtenBytes_ = st.st_size;
+  }
+  if (!mapChunk())
+  {
+    ::close(fd_);
+    fd_ = -1;
+  }
+}
+
+FileUtil::MappedAppendFile::~MappedAppendFile()
+{
+  if (fd_ >= 0)
+  {
+    unmapChunk();
+    // 去掉预分配出来但没有写入的部分
+    if (::ftruncate(fd_, writtenBytes_) < 0)
+    {
+      fprintf(stderr, "MappedAppendFile: ftruncate failed: %s\n", strerror(errno));
+    }
+    // 已经滚动出去的文件不会再被读写，提示内核尽快回写并丢弃它的页缓存
+    ::posix_fadvise(fd_, 0, 0, POSIX_FADV_DONTNEED);
+    ::close(fd_);
+  }
+}
+
+bool FileUtil::MappedAppendFile::mapChunk()
+{
+  long pageSize = ::sysconf(_SC_PAGESIZE);
+  chunkOffset_ = writtenBytes_ / pageSize * pageSize;
+  chunkPos_ = static_cast<size_t>(writtenBytes_ - chunkOffset_);
+  flushedPos_ = chunkPos_;
+
+  // 映射超出文件末尾的部分访问时会SIGBUS，所以先把文件扩展到chunk的末尾；fallocate同时保证磁盘空间已经分配
+  int err = ::posix_fallocate(fd_, chunkOffset_, static_cast<off_t>(chunkSize_));
+  if (err != 0)
+  {
+    fprintf(stderr, "MappedAppendFile: fallocate failed: %s\n", strerror(err));
+    return false;
+  }
+
+  void* addr = ::mmap(NULL, chunkSize_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, chunkOffset_);
+  if (addr == MAP_FAILED)
+  {
+    fprintf(stderr, "MappedAppendFile: mmap failed: %s\n", strerror(errno));
+    chunk_ = NULL;
+    return false;
+  }
+  chunk_ = static_cast<char*>(addr);
+  // 只会顺序写，不需要预读
+  ::madvise(chunk_, chunkSize_, MADV_SEQUENTIAL);
+  return true;
+}
+
+void FileUtil::MappedAppendFile::unmapChunk()
+{
+  if (chunk_ == NULL)
+  {
+    return;
+  }
+  flush();
+  // 共享文件映射上的MADV_DONTNEED只是解除映射，脏页仍然在页缓存中，不会丢数据，但可以立刻降低进程的RSS
+  ::madvise(chunk_, chunkSize_, MADV_DONTNEED);
+  ::munmap(chunk_, chunkSize_);
+  chunk_ = NULL;
+}
+
+void FileUtil::MappedAppendFile::append(const char* logline, size_t len)
+{
+  while (len > 0)
+  {
+    if (chunk_ == NULL)
+    {
+      // 上次换chunk失败了，先用pwrite写，下一次flush()再尝试映射
+      writeDirect(logline, len);
+      return;
+    }
+
+    size_t n = std::min(len, chunkSize_ - chunkPos_);
+    memcpy(chunk_ + chunkPos_, logline, n);
+    chunkPos_ += n;
+    writtenBytes_ += static_cast<off_t>(n);
+    logline += n;
+    len -= n;
+
+    if (chunkPos_ == chunkSize_)
+    {
+      unmapChunk();
+      if (!mapChunk())
+      {
+        fprintf(stderr, "MappedAppendFile: falling back to pwrite until the next flush\n");
+      }
+    }
+  }
+}
+
+void FileUtil::MappedAppendFile::writeDirect(const char* data, size_t len)
+{
+  while (len > 0)
+  {
+    ssize_t n = ::pwrite(fd_, data, len, writtenBytes_);
+    if (n < 0 && errno == EINTR)
+    {
+      continue;
+    }
+    if (n <= 0)
+    {
+      // 只在开始丢数据时报告一次，恢复映射时flush()会报告累计丢弃的字节数
+      if (droppedBytes_ == 0)
+      {
+        fprintf(stderr, "MappedAppendFile: pwrite failed: %s, dropping log data\n", n < 0 ? strerror(errno) : "no progress");
+      }
+      droppedBytes_ += static_cast<int64_t>(len);
+      return;
+    }
+    writtenBytes_ += static_cast<off_t>(n);
+    data += n;
+    len -= static_cast<size_t>(n);
+  }
+}
+
+void FileUtil::MappedAppendFile::flush()
+{
+  if (chunk_ == NULL)
+  {
+    // 映射失败期间的内容已经用pwrite写进了页缓存，这里只需要重新尝试映射
+    if (fd_ >= 0 && mapChunk())
+    {
+      fprintf(stderr, "MappedAppendFile: mapping restored, %lld bytes dropped so far\n",
+              static_cast<long long>(droppedBytes_));
+    }
+    return;
+  }
+  if (flushedPos_ == chunkPos_)
+  {
+    return;
+  }
+  // msync的起始地址必须按页对齐
+  long pageSize = ::sysconf(_SC_PAGESIZE);
+  size_t start = flushedPos_ / pageSize * pageSize;
+  ::msync(chunk_ + start, chunkPos_ - start, MS_ASYNC);
+  flushedPos_ = chunkPos_;
+}
@@ -0,0 +1,61 @@
+#ifndef BO_NET_BASE_FILEUTIL_H
+#define BO_NET_BASE_FILEUTIL_H
+
+#include "Types.h"
+#include "noncopyable.h"
+
+#include <sys/types.h>  // for off_t
+
+namespace bo_net
+{
+
+namespace FileUtil
+{
+
+// 通过内存映射追加写文件：每次用fallocate把文件预先扩展一个chunk，再把这个chunk映射进来，
+// append只是一次memcpy，没有系统调用；写满一个chunk才munmap并映射下一个。
+// flush()只发起异步回写（msync MS_ASYNC），不等待落盘。
+//
+// 文件关闭时会把文件截断到实际写入的长度；进程崩溃时文件末尾可能留下预分配出来的'\0'
+//
+// 换下一个chunk时fallocate或者mmap失败（磁盘满、地址空间不够），之后的append改用pwrite直接写，
+// 每次flush()重新尝试映射，成功后回到memcpy的快路径；pwrite也失败的内容被丢弃并计入droppedBytes()
+class MappedAppendFile : noncopyable
+{
+    public:
+        explicit MappedAppendFile(const string &filename);
+        ~MappedAppendFile();
+
+        // 文件打开失败时返回false，此时append()什么也不做
+        bool valid() const { return fd_ >= 0; }
+
+        void append(const char *logline, size_t len);
+
+        // 把上次flush之后写入的内容交给内核异步回写
+        void flush();
+
+        off_t writtenBytes() const { return writtenBytes_; }
+
+        // 因为映射和pwrite都失败而丢弃的字节数
+        int64_t droppedBytes() const { return droppedBytes_; }
+
+    private:
+        bool mapChunk();
+        void unmapChunk();
+        void writeDirect(const char *data, size_t len);
+
+        int    fd_;
+        char  *chunk_;          // 当前映射的chunk
+        off_t  chunkOffset_;    // chunk在文件中的起始偏移，按页对齐
+        size_t chunkSize_;
+        size_t chunkPos_;       // chunk内下一个写入位置
+        size_t flushedPos_;     // chunk内已经msync过的位置
+        off_t  writtenBytes_;   // 文件的有效长度
+        int64_t droppedBytes_;
+};
+
+} // namespace FileUtil
+
+} // namespace bo_net
+
+#endif // BO_NET_BASE_FILEUTIL_H
@@ -0,0 +1,57 @@
+#ifndef BO_NET_BASE_FIXEDBUFFER_H
+#define BO_NET_BASE_FIXEDBUFFER_H
+
+#include "Types.h"
+#include "noncopyable.h"
+
+namespace bo_net
+{
+
+namespace detail
+{
+
+const int kSmallBuffer = 4000;         // 一条日志
+const int kLargeBuffer = 4000 * 1000;  // 异步日志前后端之间交换的缓冲区
+
+// 定长缓冲区，空间在对象内部预先分配好，append只是一次memcpy，放不下时直接丢弃
+template<int SIZE>
+class FixedBuffer : noncopyable
+{
+    public:
+        FixedBuffer()
+            : cur_(data_)
+        {
+        }
+
+        void append(const char *buf, size_t len) {
+            if(static_cast<size_t>(avail()) > len) {
+                memcpy(cur_, buf, len);
+                cur_ += len;
+            }
+        }
+
+        const char* data() const { return data_; }
+        int length() const { return static_cast<int>(cur_ - data_); }
+
+        // write to data_ directly
+        char* current() { return cur_; }
+        int avail() const { return static_cast<int>(end() - cur_); }
+        void add(size_t len) { cur_ += len; }
+
+        void reset() { cur_ = data_; }
+        void bzero() { memZero(data_, sizeof data_); }
+
+        string toString() const { return string(data_, length()); }
+
+    private:
+        const char* end() const { return data_ + sizeof data_; }
+
+        char data_[SIZE];
+        char *cur_;
+};
+
+} // namespace detail
+
+} // namespace bo_net
+
+#endif // BO_NET_BASE_FIXEDBUFFER_H
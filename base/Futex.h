@@ -0,0 +1,42 @@
+#ifndef BO_NET_BASE_FUTEX_H
+#define BO_NET_BASE_FUTEX_H
+
+#include <atomic>
+#include <errno.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * http://man7.org/linux/man-pages/man2/futex.2.html
+ * https://www.akkadia.org/drepper/futex.pdf
+ * futex只是一个"检查值 + 睡眠/唤醒"的系统调用，用户态的原子变量负责快路径，只有需要睡眠或者确实有人在睡眠时才进入内核
+*/
+
+namespace bo_net
+{
+
+namespace detail
+{
+
+// std::atomic<int>和int的内存布局相同，才可以把它的地址直接交给内核
+static_assert(sizeof(std::atomic<int>) == sizeof(int), "std::atomic<int> should be same size as int");
+
+// 如果*addr仍然等于expected就睡眠，直到被futexWake唤醒或者超时（timeout是相对时间，NULL表示一直等）
+// 返回0表示被唤醒，否则返回errno：EAGAIN(值已经变了)、ETIMEDOUT、EINTR，调用者需要自己重新检查条件
+inline int futexWait(std::atomic<int> *addr, int expected, const struct timespec *timeout = NULL) {
+    long ret = syscall(SYS_futex, reinterpret_cast<int*>(addr), FUTEX_WAIT_PRIVATE, expected, timeout, NULL, 0);
+    return ret == 0 ? 0 : errno;
+}
+
+// 最多唤醒n个睡眠在addr上的线程，返回实际唤醒的线程个数
+inline int futexWake(std::atomic<int> *addr, int n) {
+    return static_cast<int>(syscall(SYS_futex, reinterpret_cast<int*>(addr), FUTEX_WAKE_PRIVATE, n, NULL, NULL, 0));
+}
+
+} // namespace detail
+
+} // namespace bo_net
+
+#endif // BO_NET_BASE_FUTEX_H
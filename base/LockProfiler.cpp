@@ -0,0 +1,118 @@
+#include "LockProfiler.h"
+#include "Mutex.h"
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <vector>
+#include <stdio.h>
+
+using namespace bo_net;
+
+std::atomic<bool> LockProfiler::enabled_(false);
+
+namespace
+{
+
+// 注册表本身用一把不带名字的锁保护，它不会被统计，也就不会递归地注册自己
+struct Registry
+{
+  MutexLock mutex;
+  std::map<string, std::unique_ptr<LockStats> > stats GUARDED_BY(mutex);
+};
+
+// 带名字的全局锁可能在静态初始化阶段就注册，使用函数内的静态对象避免初始化顺序问题
+Registry& registry()
+{
+  static Registry* r = new Registry;  // 故意不析构，程序退出时其他静态对象里的锁仍可能访问它
+  return *r;
+}
+
+}  // namespace
+
+LockStats* LockProfiler::registerLock(const char* name)
+{
+  Registry& r = registry();
+  MutexLockGuard lock(r.mutex);
+  std::unique_ptr<LockStats>& stats = r.stats[name];
+  if (!stats)
+  {
+    stats.reset(new LockStats(name));
+  }
+  return stats.get();
+}
+
+void LockProfiler::reset()
+{
+  Registry& r = registry();
+  MutexLockGuard lock(r.mutex);
+  for (auto& item : r.stats)
+  {
+    LockStats* stats = item.second.get();
+    stats->acquisitions.store(0, std::memory_order_relaxed);
+    stats->contended.store(0, std::memory_order_relaxed);
+    stats->waitNanos.store(0, std::memory_order_relaxed);
+    stats->maxWaitNanos.store(0, std::memory_order_relaxed);
+    stats->holdNanos.store(0, std::memory_order_relaxed);
+  }
+}
+
+string LockProfiler::report(size_t topN)
+{
+  struct Row
+  {
+    const char* name;
+    int64_t acquisitions;
+    int64_t contended;
+    int64_t waitNanos;
+    int64_t maxWaitNanos;
+    int64_t holdNanos;
+  };
+
+  std::vector<Row> rows;
+  {
+    Registry& r = registry();
+    MutexLockGuard lock(r.mutex);
+    for (auto& item : r.stats)
+    {
+      const LockStats* stats = item.second.get();
+      Row row = { stats->name.c_str(),
+                  stats->acquisitions.load(std::memory_order_relaxed),
+                  stats->contended.load(std::memory_order_relaxed),
+                  stats->waitNanos.load(std::memory_order_relaxed),
+                  stats->maxWaitNanos.load(std::memory_order_relaxed),
+                  stats->holdNanos.load(std::memory_order_relaxed) };
+      rows.push_back(row);
+    }
+  }
+
+  std::sort(rows.begin(), rows.end(), [](const Row& lhs, const Row& rhs) {
+    return lhs.waitNanos > rhs.waitNanos;
+  });
+  if (rows.size() > topN)
+  {
+    rows.resize(topN);
+  }
+
+  string result;
+  char buf[256];
+  snprintf(buf, sizeof buf, "%-32s %12s %12s %8s %14s %12s %12s\n",
+           "name", "acquisitions", "contended", "ratio%", "total_wait_ms", "max_wait_us", "avg_hold_ns");
+  result += buf;
+  for (const Row& row : rows)
+  {
+    // 统计的名字在registerLock之后就不会再变，这里在锁外访问name是安全的
+    double ratio = row.acquisitions > 0 ? 100.0 * static_cast<double>(row.contended) / static_cast<double>(row.acquisitions) : 0.0;
+    int64_t avgHold = row.acquisitions > 0 ? row.holdNanos / row.acquisitions : 0;
+    snprintf(buf, sizeof buf, "%-32s %12lld %12lld %8.2f %14.3f %12.3f %12lld\n",
+             row.name,
+             static_cast<long long>(row.acquisitions),
+             static_cast<long long>(row.contended),
+             ratio,
+             static_cast<double>(row.waitNanos) / 1e6,
+             static_cast<double>(row.maxWaitNanos) / 1e3,
+             static_cast<long long>(avgHold));
+    result += buf;
+  }
+  return result;
+}
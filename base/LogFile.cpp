@@ -0,0 +1,159 @@
+#include "LogFile.h"
+#include "FileUtil.h"
+#include "Timestamp.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <unistd.h>
+
+using namespace bo_net;
+
+namespace
+{
+
+// 滚动和刷新只需要秒级精度，用coarse时钟即可
+time_t nowSeconds()
+{
+  return Timestamp::now(Timestamp::kRealtimeCoarse).secondsSinceEpoch();
+}
+
+string hostname()
+{
+  // HOST_NAME_MAX 64
+  // _POSIX_HOST_NAME_MAX 255
+  char buf[256];
+  if (::gethostname(buf, sizeof buf) == 0)
+  {
+    buf[sizeof(buf)-1] = '\0';
+    return buf;
+  }
+  else
+  {
+    return "unknownhost";
+  }
+}
+
+}  // namespace
+
+LogFile::LogFile(const string& basename,
+                 off_t rollSize,
+                 bool threadSafe,
+                 int flushInterval,
+                 int checkEveryN)
+  : basename_(basename),
+    rollSize_(rollSize),
+    flushInterval_(flushInterval),
+    checkEveryN_(checkEveryN),
+    count_(0),
+    mutex_(threadSafe ? new MutexLock : NULL),
+    startOfPeriod_(0),
+    lastRoll_(0),
+    lastFlush_(0)
+{
+  assert(basename.find('/') == string::npos);
+  rollFile();
+}
+
+LogFile::~LogFile() = default;
+
+void LogFile::append(const char* logline, int len)
+{
+  if (mutex_)
+  {
+    MutexLockGuard lock(*mutex_);
+    append_unlocked(logline, len);
+  }
+  else
+  {
+    append_unlocked(logline, len);
+  }
+}
+
+void LogFile::flush()
+{
+  if (mutex_)
+  {
+    MutexLockGuard lock(*mutex_);
+    file_->flush();
+  }
+  else
+  {
+    file_->flush();
+  }
+}
+
+void LogFile::append_unlocked(const char* logline, int len)
+{
+  file_->append(logline, len);
+
+  if (file_->writtenBytes() > rollSize_)
+  {
+    rollFile();
+  }
+  else
+  {
+    ++count_;
+    if (count_ >= checkEveryN_)
+    {
+      count_ = 0;
+      time_t now = nowSeconds();
+      time_t thisPeriod_ = now / kRollPerSeconds_ * kRollPerSeconds_;
+      if (thisPeriod_ != startOfPeriod_)
+      {
+        rollFile();
+      }
+      else if (now - lastFlush_ > flushInterval_)
+      {
+        lastFlush_ = now;
+        file_->flush();
+      }
+    }
+  }
+}
+
+bool LogFile::rollFile()
+{
+  time_t now = nowSeconds();
+  string filename = getLogFileName(basename_, now);
+  time_t start = now / kRollPerSeconds_ * kRollPerSeconds_;
+
+  // 文件名精确到秒，同一秒内不再滚动
+  if (now > lastRoll_)
+  {
+    lastRoll_ = now;
+    lastFlush_ = now;
+    startOfPeriod_ = start;
+    // 先析构旧文件（截断预分配的部分并解除映射），再打开新文件
+    file_.reset();
+    file_.reset(new FileUtil::MappedAppendFile(filename));
+    return true;
+  }
+  return false;
+}
+
+// basename.YYYYmmdd-HHMMSS.hostname.pid.log
+string LogFile::getLogFileName(const string& basename, time_t now)
+{
+  string filename;
+  filename.reserve(basename.size() + 64);
+  filename = basename;
+
+  Timestamp t = Timestamp::fromUnixTime(now);
+  Date::YearMonthDay ymd = t.date().yearMonthDay();
+  int secondsOfDay = t.secondsOfDay();
+  char timebuf[64];
+  snprintf(timebuf, sizeof timebuf, ".%04d%02d%02d-%02d%02d%02d.",
+           ymd.year, ymd.month, ymd.day,
+           secondsOfDay / 3600, secondsOfDay / 60 % 60, secondsOfDay % 60);
+  filename += timebuf;
+
+  filename += hostname();
+
+  char pidbuf[32];
+  snprintf(pidbuf, sizeof pidbuf, ".%d", ::getpid());
+  filename += pidbuf;
+
+  filename += ".log";
+
+  return filename;
+}
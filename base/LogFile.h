@@ -0,0 +1,62 @@
+#ifndef BO_NET_BASE_LOGFILE_H
+#define BO_NET_BASE_LOGFILE_H
+
+#include "Mutex.h"
+#include "Types.h"
+#include "noncopyable.h"
+
+#include <memory>
+#include <time.h>
+
+namespace bo_net
+{
+
+namespace FileUtil
+{
+class MappedAppendFile;
+}
+
+// 滚动日志文件：写入超过rollSize字节，或者跨过UTC零点时换一个新文件。
+// 底层通过MappedAppendFile写入，append没有系统调用，每flushInterval秒才发起一次异步回写。
+// 与AsyncLogging配合使用时，LogFile只在后端线程中被访问，可以把threadSafe设为false：
+//   LogFile file("server", 500 * 1000 * 1000, false);
+//   AsyncLogging log([&](const char *data, size_t len) { file.append(data, static_cast<int>(len)); },
+//                    [&]() { file.flush(); });
+class LogFile : noncopyable
+{
+    public:
+        LogFile(const string &basename,
+                off_t rollSize,
+                bool threadSafe = true,
+                int flushInterval = 3,
+                int checkEveryN = 1024);
+        ~LogFile();
+
+        void append(const char *logline, int len);
+        void flush();
+        bool rollFile();
+
+    private:
+        void append_unlocked(const char *logline, int len);
+
+        static string getLogFileName(const string &basename, time_t now);
+
+        const string basename_;
+        const off_t rollSize_;
+        const int flushInterval_;
+        const int checkEveryN_;
+
+        int count_;
+
+        std::unique_ptr<MutexLock> mutex_;
+        time_t startOfPeriod_;
+        time_t lastRoll_;
+        time_t lastFlush_;
+        std::unique_ptr<FileUtil::MappedAppendFile> file_;
+
+        const static int kRollPerSeconds_ = 60 * 60 * 24;
+};
+
+} // namespace bo_net
+
+#endif // BO_NET_BASE_LOGFILE_H
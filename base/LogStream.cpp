@@ -0,0 +1,199 @@
+#include "LogStream.h"
+#include "Timestamp.h"
+
+#include <algorithm>
+#include <limits>
+#include <type_traits>
+#include <stdio.h>
+
+using namespace bo_net;
+
+namespace bo_net
+{
+
+namespace detail
+{
+
+const char kDigitPairs[201] =
+  "00010203040506070809"
+  "10111213141516171819"
+  "20212223242526272829"
+  "30313233343536373839"
+  "40414243444546474849"
+  "50515253545556575859"
+  "60616263646566676869"
+  "70717273747576777879"
+  "80818283848586878889"
+  "90919293949596979899";
+
+const char kDigitsHex[] = "0123456789ABCDEF";
+
+// 先算出位数，再从低位往高位每次写两位，不需要最后再翻转
+template<typename T>
+size_t convert(char buf[], T value)
+{
+  typedef typename std::make_unsigned<T>::type U;
+  U u = static_cast<U>(value);
+  char* p = buf;
+  if (value < 0)
+  {
+    *p++ = '-';
+    u = static_cast<U>(0 - u);  // 对最小的负数也成立
+  }
+
+  int digits = 1;
+  for (U v = u; v >= 10; v /= 10)
+  {
+    ++digits;
+  }
+
+  char* q = p + digits;
+  while (u >= 100)
+  {
+    unsigned index = static_cast<unsigned>(u % 100) * 2;
+    u /= 100;
+    q -= 2;
+    q[0] = kDigitPairs[index];
+    q[1] = kDigitPairs[index + 1];
+  }
+  if (u >= 10)
+  {
+    unsigned index = static_cast<unsigned>(u) * 2;
+    q -= 2;
+    q[0] = kDigitPairs[index];
+    q[1] = kDigitPairs[index + 1];
+  }
+  else
+  {
+    *--q = static_cast<char>('0' + u);
+  }
+  return static_cast<size_t>(p - buf) + digits;
+}
+
+size_t convertHex(char buf[], uintptr_t value)
+{
+  uintptr_t i = value;
+  char* p = buf;
+
+  do
+  {
+    int lsd = static_cast<int>(i % 16);
+    i /= 16;
+    *p++ = kDigitsHex[lsd];
+  } while (i != 0);
+
+  std::reverse(buf, p);
+  return p - buf;
+}
+
+template size_t convert(char [], char);
+template size_t convert(char [], short);
+template size_t convert(char [], unsigned short);
+template size_t convert(char [], int);
+template size_t convert(char [], unsigned int);
+template size_t convert(char [], long);
+template size_t convert(char [], unsigned long);
+template size_t convert(char [], long long);
+template size_t convert(char [], unsigned long long);
+
+}  // namespace detail
+
+}  // namespace bo_net
+
+template<typename T>
+void LogStream::formatInteger(T v)
+{
+  if (buffer_.avail() >= kMaxNumericSize)
+  {
+    size_t len = detail::convert(buffer_.current(), v);
+    buffer_.add(len);
+  }
+}
+
+LogStream& LogStream::operator<<(short v)
+{
+  *this << static_cast<int>(v);
+  return *this;
+}
+
+LogStream& LogStream::operator<<(unsigned short v)
+{
+  *this << static_cast<unsigned int>(v);
+  return *this;
+}
+
+LogStream& LogStream::operator<<(int v)
+{
+  formatInteger(v);
+  return *this;
+}
+
+LogStream& LogStream::operator<<(unsigned int v)
+{
+  formatInteger(v);
+  return *this;
+}
+
+LogStream& LogStream::operator<<(long v)
+{
+  formatInteger(v);
+  return *this;
+}
+
+LogStream& LogStream::operator<<(unsigned long v)
+{
+  formatInteger(v);
+  return *this;
+}
+
+LogStream& LogStream::operator<<(long long v)
+{
+  formatInteger(v);
+  return *this;
+}
+
+LogStream& LogStream::operator<<(unsigned long long v)
+{
+  formatInteger(v);
+  return *this;
+}
+
+LogStream& LogStream::operator<<(const void* p)
+{
+  uintptr_t v = reinterpret_cast<uintptr_t>(p);
+  if (buffer_.avail() >= kMaxNumericSize)
+  {
+    char* buf = buffer_.current();
+    buf[0] = '0';
+    buf[1] = 'x';
+    size_t len = detail::convertHex(buf + 2, v);
+    buffer_.add(len + 2);
+  }
+  return *this;
+}
+
+// 日志里的浮点数大多是整数值（字节数、毫秒数），这种情况直接走整数转换；其他情况交给snprintf
+LogStream& LogStream::operator<<(double v)
+{
+  if (buffer_.avail() >= kMaxNumericSize)
+  {
+    const double kMaxExactInteger = 9007199254740992.0;  // 2^53，再大的整数double已经不能精确表示
+    if (v > -kMaxExactInteger && v < kMaxExactInteger && v == static_cast<double>(static_cast<int64_t>(v)))
+    {
+      formatInteger(static_cast<long long>(v));
+    }
+    else
+    {
+      int len = snprintf(buffer_.current(), kMaxNumericSize, "%.12g", v);
+      buffer_.add(len);
+    }
+  }
+  return *this;
+}
+
+LogStream& LogStream::operator<<(const Timestamp& t)
+{
+  size_t len = t.formatTo(buffer_.current(), buffer_.avail());
+  buffer_.add(len);
+  return *this;
+}
@@ -0,0 +1,114 @@
+#ifndef BO_NET_BASE_LOGSTREAM_H
+#define BO_NET_BASE_LOGSTREAM_H
+
+#include "FixedBuffer.h"
+#include "Types.h"
+#include "noncopyable.h"
+
+#include <string_view>
+
+namespace bo_net
+{
+
+class Timestamp;
+
+// 流式的格式化器，所有内容直接写进对象内部的定长缓冲区，每条消息没有任何堆内存分配；
+// 整数用查表的方式一次转换两位，比snprintf快得多。缓冲区放不下的内容直接丢弃
+class LogStream : noncopyable
+{
+    typedef LogStream self;
+
+    public:
+        typedef detail::FixedBuffer<detail::kSmallBuffer> Buffer;
+
+        self& operator<<(bool v) {
+            buffer_.append(v ? "1" : "0", 1);
+            return *this;
+        }
+
+        self& operator<<(short);
+        self& operator<<(unsigned short);
+        self& operator<<(int);
+        self& operator<<(unsigned int);
+        self& operator<<(long);
+        self& operator<<(unsigned long);
+        self& operator<<(long long);
+        self& operator<<(unsigned long long);
+
+        // 以0x开头的十六进制
+        self& operator<<(const void*);
+
+        self& operator<<(float v) {
+            *this << static_cast<double>(v);
+            return *this;
+        }
+        self& operator<<(double);
+
+        self& operator<<(char v) {
+            buffer_.append(&v, 1);
+            return *this;
+        }
+
+        self& operator<<(const char *str) {
+            if(str) {
+                buffer_.append(str, strlen(str));
+            }
+            else {
+                buffer_.append("(null)", 6);
+            }
+            return *this;
+        }
+
+        self& operator<<(const unsigned char *str) {
+            return operator<<(reinterpret_cast<const char*>(str));
+        }
+
+        self& operator<<(const string &v) {
+            buffer_.append(v.data(), v.size());
+            return *this;
+        }
+
+        self& operator<<(std::string_view v) {
+            buffer_.append(v.data(), v.size());
+            return *this;
+        }
+
+        self& operator<<(const Buffer &v) {
+            buffer_.append(v.data(), v.length());
+            return *this;
+        }
+
+        // 格式同Timestamp::formatTo，"YYYYMMDD HH:MM:SS.uuuuuu"
+        self& operator<<(const Timestamp &t);
+
+        void append(const char *data, int len) { buffer_.append(data, len); }
+        const Buffer& buffer() const { return buffer_; }
+        void resetBuffer() { buffer_.reset(); }
+
+    private:
+        template<typename T>
+        void formatInteger(T);
+
+        Buffer buffer_;
+
+        static const int kMaxNumericSize = 48;
+};
+
+namespace detail
+{
+
+// "00" "01" ... "99"，按value*2下标一次取出两位十进制数字，整数转换和Timestamp的格式化共用这一张表
+extern const char kDigitPairs[201];
+
+// 把整数value转换成十进制写入buf，不写'\0'，返回写入的字符数；buf至少要有kMaxNumericSize个字节
+template<typename T>
+size_t convert(char *buf, T value);
+
+// 十六进制，不带0x前缀
+size_t convertHex(char *buf, uintptr_t value);
+
+} // namespace detail
+
+} // namespace bo_net
+
+#endif // BO_NET_BASE_LOGSTREAM_H
@@ -0,0 +1,135 @@
+#ifndef BO_NET_BASE_MPSCQUEUE_H
+#define BO_NET_BASE_MPSCQUEUE_H
+
+#include "Futex.h"
+#include "Types.h"
+#include "noncopyable.h"
+
+#include <atomic>
+#include <assert.h>
+
+/**
+ * http://www.1024cores.net/home/lock-free-algorithms/queues/intrusive-mpsc-node-based-queue
+ * Dmitry Vyukov的侵入式MPSC队列：链表节点嵌在元素对象里，入队只是一次原子exchange加一次store，
+ * 不分配内存、不加锁，生产者之间也不会互相重试（wait-free）；出队只能在唯一的消费者线程中进行。
+ *
+ * 生产者exchange之后、把自己挂到前一个节点上之前的一瞬间，链表是断开的，这时tryPop()可能返回NULL，
+ * 即使队列里其实还有元素。消费者不能把NULL当作"以后也不会有了"，需要依靠生产者随后的唤醒再来取：
+ * 配合take()用put()，或者像EventLoop那样在push()之后自己发出唤醒
+*/
+
+namespace bo_net
+{
+
+// 嵌在元素里的链表节点。一个节点同一时刻只能在一个队列里
+struct MpscNode
+{
+    MpscNode()
+        : mpscNext(NULL)
+    {
+    }
+
+    std::atomic<MpscNode*> mpscNext;
+};
+
+// T必须以public方式继承MpscNode。队列不拥有元素，元素的生命周期由使用者管理
+template<typename T>
+class MpscQueue : noncopyable
+{
+    public:
+        MpscQueue()
+            : head_(&stub_),
+              tail_(&stub_),
+              sleeping_(0)
+        {
+        }
+
+        // 任何线程都可以调用，不唤醒消费者
+        void push(T *x) {
+            pushNode(static_cast<MpscNode*>(x));
+        }
+
+        // push之后，如果消费者正睡在take()里就用futex唤醒它
+        void put(T *x) {
+            pushNode(static_cast<MpscNode*>(x));
+            // 与take()中"先登记睡眠再检查队列"配对，两边都用seq_cst保证至少一方看到对方
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if(sleeping_.load(std::memory_order_relaxed) != 0 && sleeping_.exchange(0) != 0) {
+                detail::futexWake(&sleeping_, 1);
+            }
+        }
+
+        // 只能由消费者线程调用，队列为空（或者生产者正在入队的中途）时返回NULL
+        T* tryPop() {
+            MpscNode *tail = tail_;
+            MpscNode *next = tail->mpscNext.load(std::memory_order_acquire);
+            if(tail == &stub_) {
+                if(next == NULL) {
+                    return NULL;
+                }
+                tail_ = next;
+                tail = next;
+                next = next->mpscNext.load(std::memory_order_acquire);
+            }
+            if(next != NULL) {
+                tail_ = next;
+                return static_cast<T*>(tail);
+            }
+            if(tail != head_.load(std::memory_order_acquire)) {
+                return NULL;  // 有生产者正在入队，还没有把自己挂上来
+            }
+            // tail是最后一个节点，把stub放回队尾之后才能把tail取走
+            pushNode(&stub_);
+            next = tail->mpscNext.load(std::memory_order_acquire);
+            if(next != NULL) {
+                tail_ = next;
+                return static_cast<T*>(tail);
+            }
+            return NULL;
+        }
+
+        // 只能由消费者线程调用，队列为空时先自旋一小段时间，再睡在futex上等put()唤醒
+        T* take() {
+            for(int spin = 0; ; ++spin) {
+                if(T *x = tryPop()) {
+                    return x;
+                }
+                if(spin < kSpinCount) {
+                    cpuRelax();
+                    continue;
+                }
+                sleeping_.store(1, std::memory_order_seq_cst);
+                if(T *x = tryPop()) {
+                    sleeping_.store(0, std::memory_order_relaxed);
+                    return x;
+                }
+                detail::futexWait(&sleeping_, 1);
+                spin = 0;
+            }
+        }
+
+        // 只在消费者线程中是准确的
+        bool empty() const {
+            return tail_ == &stub_ && stub_.mpscNext.load(std::memory_order_acquire) == NULL;
+        }
+
+    private:
+        static const int kSpinCount = 64;
+
+        void pushNode(MpscNode *node) {
+            node->mpscNext.store(NULL, std::memory_order_relaxed);
+            MpscNode *prev = head_.exchange(node, std::memory_order_acq_rel);
+            prev->mpscNext.store(node, std::memory_order_release);
+        }
+
+        // head_只有生产者碰，tail_只有消费者碰。stub_两边都会写：队列空的时候生产者把自己挂在stub_.mpscNext上，
+        // 消费者取走最后一个元素时又把stub_重新入队，所以它也单独占一个cache line，不拖累消费者的tail_
+        alignas(kCacheLineSize) std::atomic<MpscNode*> head_;
+        alignas(kCacheLineSize) MpscNode *tail_;
+        alignas(kCacheLineSize) MpscNode stub_;
+        alignas(kCacheLineSize) std::atomic<int> sleeping_;
+};
+
+} // namespace bo_net
+
+#endif // BO_NET_BASE_MPSCQUEUE_H
@@ -0,0 +1,94 @@
+#include "Mutex.h"
+#include "Futex.h"
+#include "Types.h"
+
+#include <limits.h>
+
+using namespace bo_net;
+
+namespace
+{
+
+// 自适应锁的自旋上限：每轮自旋后pause的次数翻倍，最多kMaxBackoff次；总共自旋kSpinRounds轮，
+// 大约是几微秒的量级，超过这个时间说明持有者可能已经被调度出去了，继续自旋只会浪费CPU
+const int kSpinRounds = 8;
+const int kMaxBackoff = 64;
+
+// 票据锁前面每多排一个线程，就多pause这么多次；排队超过kFairSpinRounds轮之后去futex上睡眠
+const int kPausePerTicket = 16;
+const int kFairSpinRounds = 32;
+
+}  // namespace
+
+// https://www.akkadia.org/drepper/futex.pdf 中的mutex2
+void MutexLock::lockAdaptiveSlow()
+{
+  int backoff = 1;
+  for (int round = 0; round < kSpinRounds; ++round)
+  {
+    for (int i = 0; i < backoff; ++i)
+    {
+      cpuRelax();
+    }
+    if (backoff < kMaxBackoff)
+    {
+      backoff <<= 1;
+    }
+
+    // 先只读，看到锁空闲了再CAS，避免自旋时不停地让cache line在核之间来回失效
+    int expected = 0;
+    if (state_.load(std::memory_order_relaxed) == 0 &&
+        state_.compare_exchange_weak(expected, 1, std::memory_order_acquire))
+    {
+      return;
+    }
+  }
+
+  // 自旋失败，把状态改成2表示有人在等待，这样解锁的线程知道需要futexWake
+  int c = state_.exchange(2, std::memory_order_acquire);
+  while (c != 0)
+  {
+    detail::futexWait(&state_, 2);
+    c = state_.exchange(2, std::memory_order_acquire);
+  }
+}
+
+void MutexLock::unlockAdaptiveSlow()
+{
+  detail::futexWake(&state_, 1);
+}
+
+void MutexLock::lockFairSlow(int ticket)
+{
+  for (int round = 0; ; ++round)
+  {
+    int serving = nowServing_.load(std::memory_order_acquire);
+    if (serving == ticket)
+    {
+      return;
+    }
+
+    if (round < kFairSpinRounds)
+    {
+      // 按照前面排队的线程个数成比例地退避，离得越远等得越久
+      unsigned distance = static_cast<unsigned>(ticket) - static_cast<unsigned>(serving);
+      for (unsigned i = 0; i < distance * kPausePerTicket; ++i)
+      {
+        cpuRelax();
+      }
+    }
+    else
+    {
+      // 先登记再睡眠，与unlockInternal中"先推进nowServing_再检查waiters_"配对，不会丢失唤醒
+      waiters_.fetch_add(1, std::memory_order_seq_cst);
+      detail::futexWait(&nowServing_, serving);
+      waiters_.fetch_sub(1, std::memory_order_relaxed);
+    }
+  }
+}
+
+void MutexLock::unlockFairSlow()
+{
+  // 票据锁必须由指定的那个线程拿到锁，无法只唤醒"下一个"，因此唤醒全部睡眠者，让它们各自检查票号
+  detail::futexWake(&nowServing_, INT_MAX);
+}
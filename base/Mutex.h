@@ -2,8 +2,11 @@
 #define BO_NET_BASE_MUTEX_H
 
 #include "CurrentThread.h"
+#include "LockProfiler.h"
+#include "noncopyable.h"
 
 #include <boost/noncopyable.hpp>
+#include <atomic>
 #include <assert.h>
 #include <pthread.h>
 
@@ -114,21 +117,60 @@ namespace bo_net
 //   mutable MutexLock mutex_;
 //   std::vector<int> data_ GUARDED_BY(mutex_);
 // };
+//
+// 可以在构造时选择加锁策略，MutexLockGuard和Condition对三种策略的用法完全一样：
+//   mutable MutexLock mutex_{MutexLock::kAdaptive};
+//
+// 定义BO_NET_MUTEX_PROFILING编译时，带名字的锁会在LockProfiler打开后统计竞争情况：
+//   mutable MutexLock mutex_{"Foo::mutex_"};
+// 不定义该宏时名字被忽略，加锁路径上没有任何额外开销。
+// 这个宏只控制函数体，成员布局和成员函数集合不随它变化，打开和没打开统计的目标文件可以链接在一起
 class CAPABILITY("mutex") MutexLock : boost::noncopyable
 {
     public:
+        enum Policy
+        {
+            kPthread,   // 默认策略，直接使用pthread_mutex_t，竞争时马上进入futex睡眠
+            kAdaptive,  // 先带指数退避地自旋一小段时间，仍然拿不到锁再用futex睡眠，适合临界区只有几十纳秒的锁
+            kFair,      // 票据锁，按照到达的先后顺序获得锁，避免饥饿；排队过久同样会用futex睡眠
+        };
 
         MutexLock()
-            : holder_(0) // 初始化时，没有任何线程拥有锁
+            : policy_(kPthread),
+              holder_(0) // 初始化时，没有任何线程拥有锁
+        {
+            init();
+        }
+
+        explicit MutexLock(Policy policy)
+            : policy_(policy),
+              holder_(0)
         {
-            MCHECK(pthread_mutex_init(&mutex_, NULL)); // 初始化锁
+            init();
+        }
+
+        // name必须在锁的整个生命周期内有效，一般直接传字符串字面量
+        explicit MutexLock(const char *name, Policy policy = kPthread)
+            : policy_(policy),
+              holder_(0)
+        {
+            init();
+#ifdef BO_NET_MUTEX_PROFILING
+            stats_ = LockProfiler::registerLock(name);
+#else
+            (void) name;
+#endif
         }
 
         ~MutexLock() {
             assert(holder_ == 0); // 只有在当前没有任何线程持有锁的情况下，才可以销毁锁；否则程序必然设计的有问题，某一个线程仍然在访问锁保护的对象，但是另外一个线程却要析构锁对象
-            MCHECK(pthread_mutex_destroy(&mutex_));
+            if(policy_ == kPthread) {
+                MCHECK(pthread_mutex_destroy(&mutex_));
+            }
         }
 
+        Policy policy() const { return policy_; }
+
         bool isLockedByThisThread() const
         {
             return holder_ == CurrentThread::tid();
@@ -140,16 +182,23 @@ class CAPABILITY("mutex") MutexLock : boost::noncopyable
         }        
 
         void lock() ACQUIRE() {
-            MCHECK(pthread_mutex_lock(&mutex_));
+#ifdef BO_NET_MUTEX_PROFILING
+            if(__builtin_expect(stats_ != NULL, 0) && LockProfiler::enabled()) {
+                lockProfiled();
+            }
+            else
+#endif
+            lockInternal();
             assignHolder(); // 必须先加锁，然后才可以把当前线程的tid赋值给holder_
         }
 
         void unlock() RELEASE() {
             unassignHolder();  // 必须在持有锁的时候才可以修改holder_
-            MCHECK(pthread_mutex_unlock(&mutex_));
+            unlockInternal();
         }
 
         pthread_mutex_t* getPthreadMutex() {
+            assert(policy_ == kPthread);
             return &mutex_;   // 返回锁的地址，主要是给Condition类使用
         }
 
@@ -175,14 +224,116 @@ class CAPABILITY("mutex") MutexLock : boost::noncopyable
 
         void assignHolder() {
             holder_ = CurrentThread::tid(); // 把当前线程的tid赋值给holder_，这个函数在线程lock得到锁之后调用
+#ifdef BO_NET_MUTEX_PROFILING
+            // 持锁时间从拿到锁开始计算，Condition等待结束重新拿到锁时也从这里重新开始
+            if(__builtin_expect(stats_ != NULL, 0) && LockProfiler::enabled()) {
+                acquiredNanos_ = LockProfiler::nowNanos();
+            }
+#endif
         }
 
         void unassignHolder() {
             holder_ = 0;        // 将锁标记为未被任何线程持有，这个函数需要在线程释放锁之前调用
+#ifdef BO_NET_MUTEX_PROFILING
+            // 用acquiredNanos_而不是enabled()判断，持锁期间关闭统计也能正确结束这一次计时
+            if(acquiredNanos_ != 0) {
+                stats_->holdNanos.fetch_add(LockProfiler::nowNanos() - acquiredNanos_, std::memory_order_relaxed);
+                acquiredNanos_ = 0;
+            }
+#endif
+        }
+
+        // 先尝试一次，拿不到锁才算一次竞争，并统计等锁花了多长时间
+        void lockProfiled() {
+            stats_->acquisitions.fetch_add(1, std::memory_order_relaxed);
+            if(!tryLockInternal()) {
+                int64_t start = LockProfiler::nowNanos();
+                lockInternal();
+                stats_->recordWait(LockProfiler::nowNanos() - start);
+            }
+        }
+
+        bool tryLockInternal() {
+            if(policy_ == kPthread) {
+                return pthread_mutex_trylock(&mutex_) == 0;
+            }
+            else if(policy_ == kAdaptive) {
+                int expected = 0;
+                return state_.compare_exchange_strong(expected, 1, std::memory_order_acquire);
+            }
+            else {
+                // 只有当前没有人排队时才能拿到下一张票
+                int serving = nowServing_.load(std::memory_order_acquire);
+                int expected = serving;
+                return nextTicket_.compare_exchange_strong(expected, serving + 1, std::memory_order_acquire);
+            }
+        }
+
+        void init() {
+            if(policy_ == kPthread) {
+                MCHECK(pthread_mutex_init(&mutex_, NULL)); // 初始化锁
+            }
+            state_.store(0, std::memory_order_relaxed);
+            nextTicket_.store(0, std::memory_order_relaxed);
+            nowServing_.store(0, std::memory_order_relaxed);
+            waiters_.store(0, std::memory_order_relaxed);
+            stats_ = NULL;
+            acquiredNanos_ = 0;
+        }
+
+        // 只负责加锁/解锁，不修改holder_，Condition在等待前后也直接调用这两个函数
+        void lockInternal() {
+            if(policy_ == kPthread) {
+                MCHECK(pthread_mutex_lock(&mutex_));
+            }
+            else if(policy_ == kAdaptive) {
+                // 快路径：无竞争时一次CAS就拿到锁
+                int expected = 0;
+                if(!state_.compare_exchange_strong(expected, 1, std::memory_order_acquire)) {
+                    lockAdaptiveSlow();
+                }
+            }
+            else {
+                int ticket = nextTicket_.fetch_add(1, std::memory_order_relaxed);
+                if(nowServing_.load(std::memory_order_acquire) != ticket) {
+                    lockFairSlow(ticket);
+                }
+            }
+        }
+
+        void unlockInternal() {
+            if(policy_ == kPthread) {
+                MCHECK(pthread_mutex_unlock(&mutex_));
+            }
+            else if(policy_ == kAdaptive) {
+                // 状态为2说明可能有线程睡眠在futex上，只有这时才需要进入内核
+                if(state_.exchange(0, std::memory_order_release) == 2) {
+                    unlockAdaptiveSlow();
+                }
+            }
+            else {
+                nowServing_.fetch_add(1, std::memory_order_seq_cst);
+                if(waiters_.load(std::memory_order_seq_cst) > 0) {
+                    unlockFairSlow();
+                }
+            }
         }
 
-        pthread_mutex_t mutex_;
+        // 竞争时的慢路径，实现在Mutex.cpp中
+        void lockAdaptiveSlow();
+        void unlockAdaptiveSlow();
+        void lockFairSlow(int ticket);
+        void unlockFairSlow();
+
+        const Policy    policy_;
+        pthread_mutex_t mutex_;     // kPthread
+        std::atomic<int> state_;    // kAdaptive: 0没有上锁，1上锁且无人等待，2上锁且可能有人睡眠
+        std::atomic<int> nextTicket_; // kFair: 下一个到达的线程拿到的票号
+        std::atomic<int> nowServing_; // kFair: 当前可以进入临界区的票号
+        std::atomic<int> waiters_;    // kFair: 睡眠在nowServing_上的线程个数
         pid_t holder_;          // 标记锁当前被哪个线程持有，这个标记变量同样被锁保护着 
+        LockStats *stats_;      // 没有名字的锁或者没有定义BO_NET_MUTEX_PROFILING时为NULL，不参与统计
+        int64_t acquiredNanos_; // 本次拿到锁的时刻，0表示这一次没有在计时
 };
 
 // 使用RAII思想实现一个对上述互斥锁的封装类，使用此类来加锁，相比于直接使用lock和unlock更加安全
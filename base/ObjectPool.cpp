@@ -0,0 +1,344 @@
+#include "ObjectPool.h"
+#include "Mutex.h"
+
+#include <algorithm>
+#include <atomic>
+#include <vector>
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+using namespace bo_net;
+
+namespace
+{
+
+// size class：256字节以内按16字节一档，256到2048字节按128字节一档
+const size_t kSmallStep = 16;
+const size_t kSmallMax = 256;
+const size_t kLargeStep = 128;
+const int kNumSmallClasses = static_cast<int>(kSmallMax / kSmallStep);
+const int kNumClasses = kNumSmallClasses + static_cast<int>((SlabAllocator::kMaxSize - kSmallMax) / kLargeStep);
+
+// 每次向系统申请的slab大小，mmap出来的页在第一次被切分时才真正占用物理内存
+const size_t kSlabSize = 256 * 1024;
+
+// 线程缓存和中心池之间每次搬运的块数：小块一批多搬一些，大块少一些，一批大约32KB
+const size_t kBatchBytes = 32 * 1024;
+const size_t kMinBatch = 4;
+const size_t kMaxBatch = 64;
+
+inline int sizeClass(size_t size)
+{
+  if (size <= kSmallMax)
+  {
+    return size == 0 ? 0 : static_cast<int>((size + kSmallStep - 1) / kSmallStep) - 1;
+  }
+  return kNumSmallClasses + static_cast<int>((size - kSmallMax + kLargeStep - 1) / kLargeStep) - 1;
+}
+
+inline size_t classSize(int cls)
+{
+  if (cls < kNumSmallClasses)
+  {
+    return static_cast<size_t>(cls + 1) * kSmallStep;
+  }
+  return kSmallMax + static_cast<size_t>(cls - kNumSmallClasses + 1) * kLargeStep;
+}
+
+inline size_t batchSize(int cls)
+{
+  return std::min(kMaxBatch, std::max(kMinBatch, kBatchBytes / classSize(cls)));
+}
+
+struct FreeBlock
+{
+  FreeBlock* next;
+};
+
+std::atomic<size_t> g_reservedBytes(0);
+
+// 一个size class的中心池。线程缓存一批一批地存取，线程退出之后的零散释放单独挂在loose上
+struct alignas(kCacheLineSize) CentralFreeList
+{
+  CentralFreeList()
+    : mutex(MutexLock::kAdaptive),
+      loose(NULL),
+      looseCount(0),
+      cursor(NULL),
+      end(NULL)
+  {
+  }
+
+  // 取一批块，返回链表头，*count是实际取到的个数（至少一个）
+  FreeBlock* fetch(int cls, size_t* count)
+  {
+    MutexLockGuard lock(mutex);
+    if (!batches.empty())
+    {
+      FreeBlock* head = batches.back().first;
+      *count = batches.back().second;
+      batches.pop_back();
+      return head;
+    }
+    if (loose != NULL)
+    {
+      FreeBlock* head = loose;
+      *count = looseCount;
+      loose = NULL;
+      looseCount = 0;
+      return head;
+    }
+    return carve(cls, count);
+  }
+
+  // 归还以head开头、tail结尾的count个块
+  void release(FreeBlock* head, FreeBlock* tail, size_t count)
+  {
+    MutexLockGuard lock(mutex);
+    if (count > 1)
+    {
+      tail->next = NULL;
+      batches.push_back(std::make_pair(head, count));
+    }
+    else
+    {
+      tail->next = loose;
+      loose = head;
+      ++looseCount;
+    }
+  }
+
+  // 从当前slab切出一批新块，slab剩下的不够一批就再mmap一块
+  FreeBlock* carve(int cls, size_t* count) REQUIRES(mutex)
+  {
+    const size_t size = classSize(cls);
+    const size_t n = batchSize(cls);
+    if (static_cast<size_t>(end - cursor) < n * size)
+    {
+      void* slab = ::mmap(NULL, kSlabSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (slab == MAP_FAILED)
+      {
+        fprintf(stderr, "SlabAllocator: mmap %zu bytes failed: %s\n", kSlabSize, strerror(errno));
+        abort();
+      }
+      // 上一块slab剩下的尾巴不够一批，直接放弃，最多浪费一批的大小
+      cursor = static_cast<char*>(slab);
+      end = cursor + kSlabSize;
+      g_reservedBytes.fetch_add(kSlabSize, std::memory_order_relaxed);
+    }
+
+    FreeBlock* head = reinterpret_cast<FreeBlock*>(cursor);
+    for (size_t i = 0; i < n - 1; ++i)
+    {
+      reinterpret_cast<FreeBlock*>(cursor)->next = reinterpret_cast<FreeBlock*>(cursor + size);
+      cursor += size;
+    }
+    reinterpret_cast<FreeBlock*>(cursor)->next = NULL;
+    cursor += size;
+    *count = n;
+    return head;
+  }
+
+  MutexLock mutex;
+  std::vector<std::pair<FreeBlock*, size_t> > batches GUARDED_BY(mutex);
+  FreeBlock* loose GUARDED_BY(mutex);
+  size_t looseCount GUARDED_BY(mutex);
+  char* cursor GUARDED_BY(mutex);
+  char* end GUARDED_BY(mutex);
+};
+
+// 和LockProfiler的注册表一样故意不析构：其他静态对象析构时还可能释放池里的块
+CentralFreeList* centralLists()
+{
+  static CentralFreeList* lists = new CentralFreeList[kNumClasses];
+  return lists;
+}
+
+struct ThreadCache
+{
+  struct List
+  {
+    FreeBlock* head;
+    size_t length;
+    size_t batch;
+  };
+
+  ThreadCache();
+  ~ThreadCache();
+
+  void refill(int cls);
+  void releaseBatch(int cls);
+  void flush();
+
+  CentralFreeList* central;
+  List lists[kNumClasses];
+};
+
+// t_cache为NULL并且t_cacheDestroyed为true说明线程正在退出、缓存已经析构，
+// 这之后（比如其他thread_local对象的析构函数里）的分配和释放直接找中心池
+__thread ThreadCache* t_cache = NULL;
+__thread bool t_cacheDestroyed = false;
+
+ThreadCache::ThreadCache()
+  : central(centralLists())
+{
+  for (int cls = 0; cls < kNumClasses; ++cls)
+  {
+    lists[cls].head = NULL;
+    lists[cls].length = 0;
+    lists[cls].batch = batchSize(cls);
+  }
+}
+
+ThreadCache::~ThreadCache()
+{
+  flush();
+  t_cache = NULL;
+  t_cacheDestroyed = true;
+}
+
+void ThreadCache::refill(int cls)
+{
+  List& list = lists[cls];
+  assert(list.head == NULL);
+  size_t count = 0;
+  list.head = central[cls].fetch(cls, &count);
+  list.length = count;
+}
+
+// 缓存的块超过两批时还一批给中心池，留下一批应付接下来的分配
+void ThreadCache::releaseBatch(int cls)
+{
+  List& list = lists[cls];
+  FreeBlock* head = list.head;
+  FreeBlock* tail = head;
+  for (size_t i = 1; i < list.batch; ++i)
+  {
+    tail = tail->next;
+  }
+  list.head = tail->next;
+  list.length -= list.batch;
+  central[cls].release(head, tail, list.batch);
+}
+
+void ThreadCache::flush()
+{
+  for (int cls = 0; cls < kNumClasses; ++cls)
+  {
+    List& list = lists[cls];
+    while (list.head != NULL)
+    {
+      FreeBlock* head = list.head;
+      FreeBlock* tail = head;
+      size_t n = 1;
+      while (n < list.batch && tail->next != NULL)
+      {
+        tail = tail->next;
+        ++n;
+      }
+      list.head = tail->next;
+      central[cls].release(head, tail, n);
+    }
+    list.length = 0;
+  }
+}
+
+inline ThreadCache* threadCache()
+{
+  if (__builtin_expect(t_cache == NULL, 0))
+  {
+    if (t_cacheDestroyed)
+    {
+      return NULL;
+    }
+    // 第一次使用时构造，线程退出时析构并把缓存还给中心池
+    static thread_local ThreadCache cache;
+    t_cache = &cache;
+  }
+  return t_cache;
+}
+
+}  // namespace
+
+void* SlabAllocator::allocate(size_t size)
+{
+  if (size > kMaxSize)
+  {
+    return ::operator new(size);
+  }
+  const int cls = sizeClass(size);
+  ThreadCache* cache = threadCache();
+  if (cache == NULL)
+  {
+    CentralFreeList& central = centralLists()[cls];
+    size_t count = 0;
+    FreeBlock* head = central.fetch(cls, &count);
+    if (count > 1)
+    {
+      FreeBlock* rest = head->next;
+      FreeBlock* tail = rest;
+      while (tail->next != NULL)
+      {
+        tail = tail->next;
+      }
+      central.release(rest, tail, count - 1);
+    }
+    return head;
+  }
+
+  ThreadCache::List& list = cache->lists[cls];
+  if (list.head == NULL)
+  {
+    cache->refill(cls);
+  }
+  FreeBlock* block = list.head;
+  list.head = block->next;
+  --list.length;
+  return block;
+}
+
+void SlabAllocator::deallocate(void* p, size_t size)
+{
+  if (p == NULL)
+  {
+    return;
+  }
+  if (size > kMaxSize)
+  {
+    ::operator delete(p);
+    return;
+  }
+  const int cls = sizeClass(size);
+  FreeBlock* block = static_cast<FreeBlock*>(p);
+  ThreadCache* cache = threadCache();
+  if (cache == NULL)
+  {
+    centralLists()[cls].release(block, block, 1);
+    return;
+  }
+
+  ThreadCache::List& list = cache->lists[cls];
+  block->next = list.head;
+  list.head = block;
+  if (++list.length >= 2 * list.batch)
+  {
+    cache->releaseBatch(cls);
+  }
+}
+
+size_t SlabAllocator::reservedBytes()
+{
+  return g_reservedBytes.load(std::memory_order_relaxed);
+}
+
+void SlabAllocator::flushThreadCache()
+{
+  if (t_cache != NULL)
+  {
+    t_cache->flush();
+  }
+}
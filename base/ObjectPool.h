@@ -0,0 +1,137 @@
+#ifndef BO_NET_BASE_OBJECTPOOL_H
+#define BO_NET_BASE_OBJECTPOOL_H
+
+#include "Types.h"
+
+#include <memory>
+#include <new>
+#include <utility>
+#include <stddef.h>
+
+/**
+ * 小对象的slab分配器，思路来自tcmalloc的thread cache + central free list：
+ * 按大小分成若干个size class，每个线程对每个size class有一条自己的空闲链表，分配和释放在绝大多数时候
+ * 只是一次链表头的进出，不加锁；链表空了一次从中心池拿一批，攒多了一次还一批给中心池，
+ * 只有这两种情况才会去拿中心池对应size class的锁。
+ *
+ * 中心池从系统mmap整块的slab，按需一批一批地切分。slab不会还给系统，释放的块只会在池子里循环使用，
+ * 长时间运行时RSS稳定在峰值用量附近，不会因为malloc的碎片和arena之间的迁移而慢慢上涨
+*/
+
+namespace bo_net
+{
+
+class SlabAllocator
+{
+    public:
+        // 超过kMaxSize的请求直接交给::operator new
+        static const size_t kMaxSize = 2048;
+        // 所有块都至少按这个值对齐
+        static const size_t kAlignment = 16;
+
+        static void* allocate(size_t size);
+
+        // size必须和allocate时传入的相同。可以在任何线程中释放，块会进入释放它的线程的缓存
+        static void deallocate(void *p, size_t size);
+
+        // 已经向系统申请的slab总字节数，只增不减
+        static size_t reservedBytes();
+
+        // 把当前线程缓存的所有空闲块还给中心池。线程退出时会自动调用
+        static void flushThreadCache();
+};
+
+// 继承它的类，new/delete都走SlabAllocator。
+// sized operator delete拿到的是静态类型的大小，通过基类指针delete派生类对象时基类必须有虚析构函数
+class PoolAllocated
+{
+    public:
+        static void* operator new(size_t size) {
+            return SlabAllocator::allocate(size);
+        }
+
+        static void operator delete(void *p, size_t size) {
+            SlabAllocator::deallocate(p, size);
+        }
+};
+
+// 满足标准库Allocator要求的适配器，所有实例都是等价的，例如
+//   BlockingQueue<Task, PoolAllocator<Task> > queue;
+//   std::allocate_shared<Foo>(PoolAllocator<Foo>(), ...);  // 对象和控制块在同一个块里
+template<typename T>
+class PoolAllocator
+{
+    public:
+        typedef T value_type;
+
+        PoolAllocator() noexcept {}
+
+        template<typename U>
+        PoolAllocator(const PoolAllocator<U>&) noexcept {}
+
+        T* allocate(size_t n) {
+            static_assert(alignof(T) <= SlabAllocator::kAlignment, "PoolAllocator does not support over-aligned types");
+            if(n > static_cast<size_t>(-1) / sizeof(T)) {
+                throw std::bad_alloc();
+            }
+            return static_cast<T*>(SlabAllocator::allocate(n * sizeof(T)));
+        }
+
+        void deallocate(T *p, size_t n) noexcept {
+            SlabAllocator::deallocate(p, n * sizeof(T));
+        }
+
+        template<typename U>
+        bool operator==(const PoolAllocator<U>&) const noexcept { return true; }
+
+        template<typename U>
+        bool operator!=(const PoolAllocator<U>&) const noexcept { return false; }
+};
+
+// 类型化的对象池，给不方便继承PoolAllocated的类型（比如第三方类型）用
+template<typename T>
+class ObjectPool
+{
+    static_assert(alignof(T) <= SlabAllocator::kAlignment, "ObjectPool does not support over-aligned types");
+
+    public:
+        struct Deleter
+        {
+            void operator()(T *p) const { ObjectPool::destroy(p); }
+        };
+
+        typedef std::unique_ptr<T, Deleter> Ptr;
+
+        template<typename... Args>
+        static T* create(Args&&... args) {
+            void *p = SlabAllocator::allocate(sizeof(T));
+            try {
+                return new (p) T(std::forward<Args>(args)...);
+            }
+            catch(...) {
+                SlabAllocator::deallocate(p, sizeof(T));
+                throw;
+            }
+        }
+
+        static void destroy(T *p) {
+            if(p != NULL) {
+                p->~T();
+                SlabAllocator::deallocate(p, sizeof(T));
+            }
+        }
+
+        template<typename... Args>
+        static Ptr makeUnique(Args&&... args) {
+            return Ptr(create(std::forward<Args>(args)...));
+        }
+
+        template<typename... Args>
+        static std::shared_ptr<T> makeShared(Args&&... args) {
+            return std::allocate_shared<T>(PoolAllocator<T>(), std::forward<Args>(args)...);
+        }
+};
+
+} // namespace bo_net
+
+#endif // BO_NET_BASE_OBJECTPOOL_H
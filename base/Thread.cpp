@@ -0,0 +1,162 @@
+#include "Thread.h"
+#include "CurrentThread.h"
+
+#include <exception>
+#include <errno.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/prctl.h>
+
+namespace bo_net
+{
+
+namespace detail
+{
+
+// 新线程启动时需要的数据，由新线程负责释放
+struct ThreadData
+{
+  typedef Thread::ThreadFunc ThreadFunc;
+  ThreadFunc func_;
+  string name_;
+  pid_t* tid_;
+  const std::vector<int>* cpus_;
+  CountDownLatch* latch_;
+
+  ThreadData(ThreadFunc func,
+             const string& name,
+             pid_t* tid,
+             const std::vector<int>* cpus,
+             CountDownLatch* latch)
+    : func_(std::move(func)),
+      name_(name),
+      tid_(tid),
+      cpus_(cpus),
+      latch_(latch)
+  { }
+
+  void runInThread()
+  {
+    *tid_ = CurrentThread::tid();
+    tid_ = NULL;
+
+    CurrentThread::t_threadName = name_.empty() ? "boThread" : name_.c_str();
+    // 线程名最多15个字符，超出部分被内核截断，top -H和perf里看到的就是这个名字
+    ::prctl(PR_SET_NAME, CurrentThread::t_threadName);
+
+    if (!cpus_->empty())
+    {
+      cpu_set_t cpuset;
+      CPU_ZERO(&cpuset);
+      for (int cpu : *cpus_)
+      {
+        CPU_SET(cpu, &cpuset);
+      }
+      int err = ::pthread_setaffinity_np(::pthread_self(), sizeof cpuset, &cpuset);
+      if (err != 0)
+      {
+        fprintf(stderr, "Thread %s: pthread_setaffinity_np failed: %s\n",
+                CurrentThread::t_threadName, strerror(err));
+      }
+    }
+    cpus_ = NULL;
+
+    // 到这里tid、线程名、绑核都已经完成，通知start()返回
+    latch_->countDown();
+    latch_ = NULL;
+
+    try
+    {
+      func_();
+      CurrentThread::t_threadName = "finished";
+    }
+    catch (const std::exception& ex)
+    {
+      CurrentThread::t_threadName = "crashed";
+      fprintf(stderr, "exception caught in Thread %s\n", name_.c_str());
+      fprintf(stderr, "reason: %s\n", ex.what());
+      abort();
+    }
+    catch (...)
+    {
+      CurrentThread::t_threadName = "crashed";
+      fprintf(stderr, "unknown exception caught in Thread %s\n", name_.c_str());
+      throw; // rethrow
+    }
+  }
+};
+
+void* startThread(void* obj)
+{
+  ThreadData* data = static_cast<ThreadData*>(obj);
+  data->runInThread();
+  delete data;
+  return NULL;
+}
+
+}  // namespace detail
+
+}  // namespace bo_net
+
+using namespace bo_net;
+
+AtomicInt32 Thread::numCreated_;
+
+Thread::Thread(ThreadFunc func, const string& n)
+  : started_(false),
+    joined_(false),
+    pthreadId_(0),
+    tid_(0),
+    func_(std::move(func)),
+    name_(n),
+    latch_(1)
+{
+  setDefaultName();
+}
+
+Thread::~Thread()
+{
+  if (started_ && !joined_)
+  {
+    pthread_detach(pthreadId_);
+  }
+}
+
+void Thread::setDefaultName()
+{
+  int num = numCreated_.incrementAndGet();
+  if (name_.empty())
+  {
+    char buf[32];
+    snprintf(buf, sizeof buf, "Thread%d", num);
+    name_ = buf;
+  }
+}
+
+void Thread::start()
+{
+  assert(!started_);
+  started_ = true;
+  detail::ThreadData* data = new detail::ThreadData(func_, name_, &tid_, &cpus_, &latch_);
+  if (pthread_create(&pthreadId_, NULL, &detail::startThread, data))
+  {
+    started_ = false;
+    delete data;
+    fprintf(stderr, "Failed in pthread_create\n");
+  }
+  else
+  {
+    latch_.wait();
+    assert(tid_ > 0);
+  }
+}
+
+int Thread::join()
+{
+  assert(started_);
+  assert(!joined_);
+  joined_ = true;
+  return pthread_join(pthreadId_, NULL);
+}
@@ -0,0 +1,62 @@
+#ifndef BO_NET_BASE_THREAD_H
+#define BO_NET_BASE_THREAD_H
+
+#include "Atomic.h"
+#include "CountDownLatch.h"
+#include "Types.h"
+#include "noncopyable.h"
+
+#include <functional>
+#include <vector>
+#include <assert.h>
+#include <pthread.h>
+
+namespace bo_net
+{
+
+// pthread的一层封装：start()返回时，新线程已经缓存好自己的tid、设置好线程名、绑定好CPU，
+// 这一点通过CountDownLatch保证，因此start()之后马上调用tid()就可以拿到正确的值
+class Thread : noncopyable
+{
+    public:
+        typedef std::function<void ()> ThreadFunc;
+
+        explicit Thread(ThreadFunc func, const string &name = string());
+        // 没有join的线程在析构时detach
+        ~Thread();
+
+        // 把线程绑定到cpus中的这些核上，必须在start()之前调用；不调用则不绑核
+        void setCpuAffinity(const std::vector<int> &cpus) {
+            assert(!started_);
+            cpus_ = cpus;
+        }
+
+        void start();
+        int join(); // return pthread_join()
+
+        bool started() const { return started_; }
+        // pthread_t pthreadId() const { return pthreadId_; }
+        pid_t tid() const { return tid_; }
+        const string& name() const { return name_; }
+        const std::vector<int>& cpuAffinity() const { return cpus_; }
+
+        static int numCreated() { return numCreated_.get(); }
+
+    private:
+        void setDefaultName();
+
+        bool       started_;
+        bool       joined_;
+        pthread_t  pthreadId_;
+        pid_t      tid_;
+        ThreadFunc func_;
+        string     name_;
+        std::vector<int> cpus_;
+        CountDownLatch latch_;
+
+        static AtomicInt32 numCreated_;
+};
+
+} // namespace bo_net
+
+#endif // BO_NET_BASE_THREAD_H
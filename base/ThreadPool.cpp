@@ -0,0 +1,268 @@
+#include "ThreadPool.h"
+
+#include <exception>
+#include <stdio.h>
+#include <stdlib.h>
+
+using namespace bo_net;
+
+namespace
+{
+
+// 当前线程所属的线程池和它在池中的下标，用来判断run()是不是在池内线程中调用的
+__thread ThreadPool* t_pool = NULL;
+__thread size_t t_workerIndex = 0;
+__thread uint32_t t_randomState = 0;
+
+// xorshift32，挑选窃取对象用，不需要很好的随机性
+uint32_t nextRandom()
+{
+  uint32_t x = t_randomState;
+  if (x == 0)
+  {
+    x = static_cast<uint32_t>(CurrentThread::tid()) * 2654435761u + 1;
+  }
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  t_randomState = x;
+  return x;
+}
+
+void runTask(ThreadPool::Task* task, const string& poolName)
+{
+  try
+  {
+    (*task)();
+  }
+  catch (const std::exception& ex)
+  {
+    fprintf(stderr, "exception caught in ThreadPool %s\n", poolName.c_str());
+    fprintf(stderr, "reason: %s\n", ex.what());
+    abort();
+  }
+  catch (...)
+  {
+    fprintf(stderr, "unknown exception caught in ThreadPool %s\n", poolName.c_str());
+    throw; // rethrow
+  }
+  delete task;
+}
+
+}  // namespace
+
+ThreadPool::ThreadPool(const string& nameArg)
+  : mutex_(),
+    notEmpty_(mutex_),
+    notFull_(mutex_),
+    name_(nameArg),
+    maxQueueSize_(0),
+    running_(false),
+    queued_(0),
+    pending_(0),
+    idle_(0)
+{
+}
+
+ThreadPool::~ThreadPool()
+{
+  if (!workers_.empty())
+  {
+    stop();
+  }
+}
+
+void ThreadPool::start(int numThreads)
+{
+  assert(workers_.empty());
+  {
+    MutexLockGuard lock(mutex_);
+    // 没有工作线程时running_保持false，run()直接在调用者线程中执行任务
+    running_ = numThreads > 0;
+  }
+  workers_.reserve(numThreads);
+  // 先把所有worker都建好再启动线程，线程一启动就可能去窃取其他worker的deque
+  for (int i = 0; i < numThreads; ++i)
+  {
+    workers_.emplace_back(new Worker);
+  }
+  for (int i = 0; i < numThreads; ++i)
+  {
+    char id[32];
+    snprintf(id, sizeof id, "%d", i + 1);
+    workers_[i]->thread.reset(new Thread(std::bind(&ThreadPool::runInThread, this, static_cast<size_t>(i)), name_ + id));
+    workers_[i]->thread->start();
+  }
+  if (numThreads == 0 && threadInitCallback_)
+  {
+    threadInitCallback_();
+  }
+}
+
+void ThreadPool::stop()
+{
+  {
+    MutexLockGuard lock(mutex_);
+    running_ = false;
+    notEmpty_.notifyAll();
+    notFull_.notifyAll();
+  }
+  for (auto& worker : workers_)
+  {
+    worker->thread->join();
+  }
+  // 工作线程都已经退出，没有人再访问workers_；run()只在池内线程中访问它
+  workers_.clear();
+}
+
+size_t ThreadPool::queueSize() const
+{
+  MutexLockGuard lock(mutex_);
+  return queue_.size();
+}
+
+bool ThreadPool::isFull() const
+{
+  mutex_.assertLocked();
+  return maxQueueSize_ > 0 && queue_.size() >= maxQueueSize_;
+}
+
+void ThreadPool::run(Task task)
+{
+  if (t_pool == this)
+  {
+    // 池内线程提交：放进自己的deque，不加锁，也不受注入队列长度的限制（否则池内线程可能互相等待而死锁）。
+    // 提交者自己就是工作线程，它在pending_归零之前不会退出，任务一定会被执行
+    Task* t = new Task(std::move(task));
+    // 先增加计数再让任务可见，这样工作线程在pending_为0时睡眠是安全的
+    pending_.fetch_add(1, std::memory_order_seq_cst);
+    workers_[t_workerIndex]->deque.push(t);
+    wakeupIdleWorker();
+    return;
+  }
+
+  {
+    MutexLockGuard lock(mutex_);
+    while (isFull() && running_)
+    {
+      notFull_.wait();
+    }
+    // 必须和stop()修改running_在同一个锁里判断：stop()之后工作线程取完已有的任务就会退出，
+    // 这之后再放进注入队列的任务永远不会被执行，submit()返回的future也永远等不到结果
+    if (running_)
+    {
+      Task* t = new Task(std::move(task));
+      pending_.fetch_add(1, std::memory_order_seq_cst);
+      queue_.push_back(t);
+      queued_.fetch_add(1, std::memory_order_relaxed);
+      if (idle_.load(std::memory_order_seq_cst) > 0)
+      {
+        notEmpty_.notifyOne();
+      }
+      return;
+    }
+  }
+  // 没有工作线程，或者已经stop()
+  task();
+}
+
+void ThreadPool::wakeupIdleWorker()
+{
+  if (idle_.load(std::memory_order_seq_cst) > 0)
+  {
+    MutexLockGuard lock(mutex_);
+    notEmpty_.notifyOne();
+  }
+}
+
+ThreadPool::Task* ThreadPool::takeFromQueue()
+{
+  if (queued_.load(std::memory_order_relaxed) == 0)
+  {
+    return NULL;
+  }
+  MutexLockGuard lock(mutex_);
+  if (queue_.empty())
+  {
+    return NULL;
+  }
+  Task* task = queue_.front();
+  queue_.pop_front();
+  queued_.fetch_sub(1, std::memory_order_relaxed);
+  if (maxQueueSize_ > 0)
+  {
+    notFull_.notifyOne();
+  }
+  return task;
+}
+
+ThreadPool::Task* ThreadPool::steal(size_t index)
+{
+  size_t n = workers_.size();
+  if (n <= 1)
+  {
+    return NULL;
+  }
+  // 从一个随机的位置开始把其他线程轮一遍
+  size_t start = nextRandom() % n;
+  for (size_t i = 0; i < n; ++i)
+  {
+    size_t victim = (start + i) % n;
+    Task* task;
+    if (victim != index && workers_[victim]->deque.steal(task))
+    {
+      return task;
+    }
+  }
+  return NULL;
+}
+
+ThreadPool::Task* ThreadPool::take(size_t index)
+{
+  Task* task;
+  if (workers_[index]->deque.pop(task))
+  {
+    return task;
+  }
+  if ((task = takeFromQueue()) != NULL)
+  {
+    return task;
+  }
+  return steal(index);
+}
+
+void ThreadPool::runInThread(size_t index)
+{
+  t_pool = this;
+  t_workerIndex = index;
+  if (threadInitCallback_)
+  {
+    threadInitCallback_();
+  }
+
+  for (;;)
+  {
+    Task* task = take(index);
+    if (task != NULL)
+    {
+      pending_.fetch_sub(1, std::memory_order_relaxed);
+      runTask(task, name_);
+      continue;
+    }
+
+    // 先登记为空闲再检查有没有任务，与提交者"先增加pending_再检查idle_"配对，不会丢失唤醒。
+    // pending_不为0但是没有取到任务，说明任务刚提交还没有放进去，或者被别的线程抢走了，回去再找一次
+    MutexLockGuard lock(mutex_);
+    idle_.fetch_add(1, std::memory_order_seq_cst);
+    while (running_ && pending_.load(std::memory_order_seq_cst) == 0)
+    {
+      notEmpty_.wait();
+    }
+    idle_.fetch_sub(1, std::memory_order_relaxed);
+    if (!running_ && pending_.load(std::memory_order_seq_cst) == 0)
+    {
+      break;
+    }
+  }
+  t_pool = NULL;
+}
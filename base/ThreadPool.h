@@ -0,0 +1,94 @@
+#ifndef BO_NET_BASE_THREADPOOL_H
+#define BO_NET_BASE_THREADPOOL_H
+
+#include "Condition.h"
+#include "Mutex.h"
+#include "Thread.h"
+#include "Types.h"
+#include "WorkStealingDeque.h"
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace bo_net
+{
+
+// 工作窃取线程池：
+//   - 每个工作线程有一个自己的Chase-Lev deque，任务在池内线程中提交（比如任务再派生子任务）时直接放进本线程的deque，不需要加锁
+//   - 池外线程提交的任务放进一个全局注入队列，可以用setMaxQueueSize()限制长度，满了之后提交者阻塞，起到反压的作用
+//   - 工作线程按"自己的deque -> 注入队列 -> 随机挑一个其他线程窃取"的顺序找任务，都没有时睡眠在条件变量上
+class ThreadPool : boost::noncopyable
+{
+    public:
+        typedef std::function<void ()> Task;
+
+        explicit ThreadPool(const string &nameArg = string("ThreadPool"));
+        ~ThreadPool();
+
+        // Must be called before start().
+        // 注入队列的最大长度，0表示不限制
+        void setMaxQueueSize(int maxSize) { maxQueueSize_ = maxSize; }
+        void setThreadInitCallback(const Task &cb) { threadInitCallback_ = cb; }
+
+        void start(int numThreads);
+        // 不再接受新的任务（之后在池外提交的任务直接在调用者线程中执行），
+        // 等已经提交的任务全部执行完之后再退出所有工作线程
+        void stop();
+
+        const string& name() const { return name_; }
+
+        // 注入队列中的任务个数
+        size_t queueSize() const;
+
+        // Could block if maxQueueSize > 0
+        // 没有工作线程（numThreads为0或者已经stop）时直接在调用者线程中执行
+        void run(Task f);
+
+        // 提交一个有返回值的任务，任务抛出的异常会保存在future中
+        template<typename F>
+        std::future<typename std::invoke_result<F>::type> submit(F &&f) {
+            typedef typename std::invoke_result<F>::type Result;
+            std::shared_ptr<std::packaged_task<Result ()> > task =
+                std::make_shared<std::packaged_task<Result ()> >(std::forward<F>(f));
+            std::future<Result> result = task->get_future();
+            run([task]() { (*task)(); });
+            return result;
+        }
+
+    private:
+        struct Worker
+        {
+            WorkStealingDeque<Task*> deque;
+            std::unique_ptr<Thread>  thread;
+        };
+
+        bool isFull() const REQUIRES(mutex_);
+        void runInThread(size_t index);
+        Task* take(size_t index);
+        Task* takeFromQueue();
+        Task* steal(size_t index);
+        void wakeupIdleWorker();
+
+        mutable MutexLock mutex_;
+        Condition notEmpty_ GUARDED_BY(mutex_);
+        Condition notFull_ GUARDED_BY(mutex_);
+        string name_;
+        Task threadInitCallback_;
+        std::vector<std::unique_ptr<Worker> > workers_;
+        std::deque<Task*> queue_ GUARDED_BY(mutex_);
+        size_t maxQueueSize_;
+        bool running_ GUARDED_BY(mutex_);
+
+        std::atomic<size_t> queued_;   // queue_的长度，工作线程先看它，注入队列为空时不用加锁
+        std::atomic<int64_t> pending_; // 已经提交但还没有被取走的任务个数（包括注入队列和所有deque）
+        std::atomic<int> idle_;        // 正在睡眠或者准备睡眠的工作线程个数
+};
+
+} // namespace bo_net
+
+#endif // BO_NET_BASE_THREADPOOL_H
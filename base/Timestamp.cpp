@@ -1,7 +1,11 @@
 
 #include "Timestamp.h"  // include和在本文件直接声明函数与相关变量是一样的
+#include "LogStream.h"
+#include "TscClock.h"
 
+#include <atomic>
 #include <sys/time.h>
+#include <time.h>
 #include <stdio.h> // 标准IO库直接使用C语言的，C++的标准输入输出速度有点慢，可以通过取消与stdin和stdout的同步来增加cin/cout的速度
 
 
@@ -21,45 +25,255 @@ using namespace bo_net; // namesapce bo_net在各个功能的头文件中都有
 static_assert(sizeof(Timestamp) == sizeof(int64_t), "Timestamp should be same size as int64_t");  // 类对象的大小只包括成员变量，不包括静态成员和函数，他们仅仅是在类这个作用域内罢了；在有虚函数的情况下，类的第一个成员其实是虚函数表指针
 
 
+namespace
+{
+
+const int64_t kNanoSecondsPerMicroSecond = 1000;
+
+std::atomic<int> g_defaultClockSource(Timestamp::kRealtime);
+
+inline int64_t clockNanos(clockid_t clock)
+{
+  struct timespec ts;
+  clock_gettime(clock, &ts);  // 这几个时钟都由vDSO实现，不会真正进入内核
+  return static_cast<int64_t>(ts.tv_sec) * Timestamp::kMicroSecondsPerSecond * kNanoSecondsPerMicroSecond + ts.tv_nsec;
+}
+
+}  // namespace
+
 // 所谓的微秒解析度的时间戳，就是直接使用gettimeofday()函数获取到的时间精度可以达到微妙
 Timestamp Timestamp::now()
 {
-  struct timeval tv;
-  gettimeofday(&tv, NULL);  // time相关的函数中，获取时间点的常见函数除了gettimeofday，还有time、clock_gettime等；chrono库里面获取时间点的函数基本就靠system和steady两个时钟函数；另外可以通过chrono库计算出时间间隔，但是时间格式的转换都只能通过类C函数实现
-  int64_t seconds = tv.tv_sec;
-  return Timestamp(seconds * kMicroSecondsPerSecond + tv.tv_usec);
+  ClockSource source = static_cast<ClockSource>(g_defaultClockSource.load(std::memory_order_relaxed));
+  if (source == kRealtime)
+  {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);  // time相关的函数中，获取时间点的常见函数除了gettimeofday，还有time、clock_gettime等；chrono库里面获取时间点的函数基本就靠system和steady两个时钟函数；另外可以通过chrono库计算出时间间隔，但是时间格式的转换都只能通过类C函数实现
+    int64_t seconds = tv.tv_sec;
+    return Timestamp(seconds * kMicroSecondsPerSecond + tv.tv_usec);
+  }
+  return now(source);
 }
 
-string Timestamp::toString() const
+Timestamp Timestamp::now(ClockSource source)
 {
-  char buf[32] = {0};
-  int64_t seconds = microSecondsSinceEpoch_ / kMicroSecondsPerSecond;
-  int64_t microseconds = microSecondsSinceEpoch_ % kMicroSecondsPerSecond;
-  snprintf(buf, sizeof(buf), "%" PRId64 ".%06" PRId64 "", seconds, microseconds);
-  return buf;
+  return Timestamp(nowNanos(source) / kNanoSecondsPerMicroSecond);
 }
 
-// 把纪元时转换为tm结构体，再转换为格式化字符串：time() -> gmtime_r() -> snprintf()
-string Timestamp::toFormattedString(bool showMicroseconds) const
+int64_t Timestamp::nowNanos(ClockSource source)
+{
+  switch (source)
+  {
+    case kRealtimeCoarse:
+      return clockNanos(CLOCK_REALTIME_COARSE);
+    case kMonotonic:
+      return clockNanos(CLOCK_MONOTONIC);
+    case kMonotonicCoarse:
+      return clockNanos(CLOCK_MONOTONIC_COARSE);
+    case kTsc:
+      if (detail::TscClock::available())
+      {
+        return detail::TscClock::nowNanos();
+      }
+      return clockNanos(CLOCK_REALTIME);
+    case kRealtime:
+    default:
+      return clockNanos(CLOCK_REALTIME);
+  }
+}
+
+bool Timestamp::setDefaultClockSource(ClockSource source)
+{
+  if (source == kMonotonic || source == kMonotonicCoarse)
+  {
+    return false;
+  }
+  // 提前完成TSC的校准，避免第一次调用now()的线程承担这10ms
+  if (source == kTsc)
+  {
+    detail::TscClock::available();
+  }
+  g_defaultClockSource.store(source, std::memory_order_relaxed);
+  return true;
+}
+
+Timestamp::ClockSource Timestamp::defaultClockSource()
+{
+  return static_cast<ClockSource>(g_defaultClockSource.load(std::memory_order_relaxed));
+}
+
+namespace
+{
+
+inline char* write2Digits(char* p, int value)
+{
+  memcpy(p, detail::kDigitPairs + value * 2, 2);
+  return p + 2;
+}
+
+inline char* write4Digits(char* p, int value)
+{
+  p = write2Digits(p, value / 100);
+  return write2Digits(p, value % 100);
+}
+
+inline char* write6Digits(char* p, int value)
+{
+  p = write2Digits(p, value / 10000);
+  p = write2Digits(p, value / 100 % 100);
+  return write2Digits(p, value % 100);
+}
+
+// 向下取整的除法，保证1970年以前的时间戳拆出来的微秒部分也是非负数
+inline void splitSeconds(int64_t microSecondsSinceEpoch, int64_t* seconds, int* microseconds)
+{
+  int64_t sec = microSecondsSinceEpoch / Timestamp::kMicroSecondsPerSecond;
+  int64_t usec = microSecondsSinceEpoch % Timestamp::kMicroSecondsPerSecond;
+  if (usec < 0)
+  {
+    --sec;
+    usec += Timestamp::kMicroSecondsPerSecond;
+  }
+  *seconds = sec;
+  *microseconds = static_cast<int>(usec);
+}
+
+const size_t kSecondPrefixLength = 17;  // "YYYYMMDD HH:MM:SS"
+
+// 每个线程缓存上一次格式化的那一秒，同一秒内的多次格式化只需要改写微秒部分
+__thread int64_t t_cachedSecond = INT64_MIN;
+__thread char t_cachedPrefix[kSecondPrefixLength + 1];
+
+// 缓存失效时用Date做日历转换，不再调用gmtime_r（它需要加锁读取时区信息）。
+// 年份不在0..9999之间时前缀不是定长的，返回NULL，由调用者走snprintf的慢路径
+const char* secondPrefix(int64_t seconds)
 {
-  char buf[64] = {0}; // 必须初始化
-  time_t seconds = static_cast<time_t>(microSecondsSinceEpoch_ / kMicroSecondsPerSecond);
-  struct tm tm_time;             // python中同样叫tm
-  gmtime_r(&seconds, &tm_time);  // 把当前的纪元时间转化为一个时间结构体，这个函数返回的是世界协调时间
+  if (seconds != t_cachedSecond)
+  {
+    Timestamp t(seconds * Timestamp::kMicroSecondsPerSecond);
+    Date::YearMonthDay ymd = t.date().yearMonthDay();
+    int secondsOfDay = t.secondsOfDay();
+    if (ymd.year < 0 || ymd.year > 9999)
+    {
+      return NULL;
+    }
 
+    char* p = t_cachedPrefix;
+    p = write4Digits(p, ymd.year);
+    p = write2Digits(p, ymd.month);
+    p = write2Digits(p, ymd.day);
+    *p++ = ' ';
+    p = write2Digits(p, secondsOfDay / 3600);
+    *p++ = ':';
+    p = write2Digits(p, secondsOfDay / 60 % 60);
+    *p++ = ':';
+    p = write2Digits(p, secondsOfDay % 60);
+    *p = '\0';
+    t_cachedSecond = seconds;
+  }
+  return t_cachedPrefix;
+}
+
+size_t formatSlow(int64_t seconds, int microseconds, char* buf, size_t len, bool showMicroseconds)
+{
+  Timestamp t(seconds * Timestamp::kMicroSecondsPerSecond);
+  Date::YearMonthDay ymd = t.date().yearMonthDay();
+  int secondsOfDay = t.secondsOfDay();
+  int n;
   if (showMicroseconds)
   {
-    int microseconds = static_cast<int>(microSecondsSinceEpoch_ % kMicroSecondsPerSecond);
-    snprintf(buf, sizeof(buf), "%4d%02d%02d %02d:%02d:%02d.%06d",
-             tm_time.tm_year + 1900, tm_time.tm_mon + 1, tm_time.tm_mday,
-             tm_time.tm_hour, tm_time.tm_min, tm_time.tm_sec,
-             microseconds);
+    n = snprintf(buf, len, "%4d%02d%02d %02d:%02d:%02d.%06d",
+                 ymd.year, ymd.month, ymd.day,
+                 secondsOfDay / 3600, secondsOfDay / 60 % 60, secondsOfDay % 60,
+                 microseconds);
   }
   else
   {
-    snprintf(buf, sizeof(buf), "%4d%02d%02d %02d:%02d:%02d",
-             tm_time.tm_year + 1900, tm_time.tm_mon + 1, tm_time.tm_mday,
-             tm_time.tm_hour, tm_time.tm_min, tm_time.tm_sec);
+    n = snprintf(buf, len, "%4d%02d%02d %02d:%02d:%02d",
+                 ymd.year, ymd.month, ymd.day,
+                 secondsOfDay / 3600, secondsOfDay / 60 % 60, secondsOfDay % 60);
+  }
+  if (n < 0 || static_cast<size_t>(n) >= len)
+  {
+    return 0;
   }
-  return buf;
+  return static_cast<size_t>(n);
+}
+
+}  // namespace
+
+size_t Timestamp::toStringTo(char* buf, size_t len) const
+{
+  int64_t seconds;
+  int microseconds;
+  splitSeconds(microSecondsSinceEpoch_, &seconds, &microseconds);
+
+  // 先把秒数倒着写到临时区里，最多20个字符（含负号）
+  char digits[24];
+  char* end = digits + sizeof digits;
+  char* p = end;
+  uint64_t value = seconds < 0 ? 0 - static_cast<uint64_t>(seconds) : static_cast<uint64_t>(seconds);
+  do
+  {
+    *--p = static_cast<char>('0' + value % 10);
+    value /= 10;
+  } while (value != 0);
+  if (seconds < 0)
+  {
+    *--p = '-';
+  }
+
+  size_t secondsLength = static_cast<size_t>(end - p);
+  size_t total = secondsLength + 1 + 6;
+  if (total + 1 > len)
+  {
+    return 0;
+  }
+  memcpy(buf, p, secondsLength);
+  char* q = buf + secondsLength;
+  *q++ = '.';
+  q = write6Digits(q, microseconds);
+  *q = '\0';
+  return total;
+}
+
+size_t Timestamp::formatTo(char* buf, size_t len, bool showMicroseconds) const
+{
+  size_t total = showMicroseconds ? kSecondPrefixLength + 7 : kSecondPrefixLength;
+  if (total + 1 > len)
+  {
+    return 0;
+  }
+
+  int64_t seconds;
+  int microseconds;
+  splitSeconds(microSecondsSinceEpoch_, &seconds, &microseconds);
+  const char* prefix = secondPrefix(seconds);
+  if (prefix == NULL)
+  {
+    return formatSlow(seconds, microseconds, buf, len, showMicroseconds);
+  }
+  memcpy(buf, prefix, kSecondPrefixLength);
+  char* p = buf + kSecondPrefixLength;
+  if (showMicroseconds)
+  {
+    *p++ = '.';
+    p = write6Digits(p, microseconds);
+  }
+  *p = '\0';
+  return total;
+}
+
+string Timestamp::toString() const
+{
+  char buf[32];
+  size_t n = toStringTo(buf, sizeof buf);
+  return string(buf, n);
+}
+
+string Timestamp::toFormattedString(bool showMicroseconds) const
+{
+  char buf[32];
+  size_t n = formatTo(buf, sizeof buf, showMicroseconds);
+  return string(buf, n);
 }
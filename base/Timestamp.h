@@ -4,6 +4,7 @@
 # pragma once
 
 #include "copyable.h"
+#include "Date.h"
 #include "Types.h"
 
 namespace bo_net {
@@ -13,6 +14,16 @@ namespace bo_net {
 class Timestamp : public bo_net::copyable // 所有的命名空间在定义后可以直接使用，就像std
 {
     public:
+        // now()可以选择的时钟源，不同的用途对精度、开销和单调性的要求不一样
+        enum ClockSource
+        {
+            kRealtime,         // CLOCK_REALTIME，微秒精度的墙上时间，默认时钟源
+            kRealtimeCoarse,   // CLOCK_REALTIME_COARSE，精度是一个tick（1~4ms），但开销只有kRealtime的几分之一，适合日志
+            kMonotonic,        // CLOCK_MONOTONIC，不受NTP和手动修改系统时间影响，适合定时器和超时
+            kMonotonicCoarse,  // CLOCK_MONOTONIC_COARSE，低精度的单调时钟
+            kTsc,              // 基于rdtsc的墙上时间，开销最小，适合延迟测量；CPU不支持恒定TSC时退化为kRealtime
+        };
+
         // just construct a invalid Timestamp
         Timestamp():microSecondsSinceEpoch_(0) {}
 
@@ -37,6 +48,12 @@ class Timestamp : public bo_net::copyable // 所有的命名空间在定义后
         // 转化为标准的时间格式
         string toFormattedString(bool showMicroseconds = true) const;        
 
+        // 上面两个函数的无内存分配版本，给日志等热路径使用：把结果写入buf并以'\0'结尾，
+        // 返回写入的字符数（不含'\0'），buf放不下时返回0。
+        // formatTo每个线程缓存当前这一秒的"YYYYMMDD HH:MM:SS"前缀，同一秒内只需要改写微秒部分
+        size_t formatTo(char *buf, size_t len, bool showMicroseconds = true) const;
+        size_t toStringTo(char *buf, size_t len) const;
+
         // just for internal use
         int64_t microSecondsSinceEpoth() const {
             return microSecondsSinceEpoch_;
@@ -44,12 +61,33 @@ class Timestamp : public bo_net::copyable // 所有的命名空间在定义后
         time_t secondsSinceEpoch() const
         { return static_cast<time_t>(microSecondsSinceEpoch_ / kMicroSecondsPerSecond); }
 
+        // UTC日历日期和当天已经过去的秒数，用整数运算代替gmtime_r，日志滚动、按天统计都用这两个函数
+        Date date() const {
+            return Date::fromDaysSinceEpoch(floorDiv(microSecondsSinceEpoch_, kMicroSecondsPerDay));
+        }
+        int secondsOfDay() const {
+            return static_cast<int>((microSecondsSinceEpoch_ - floorDiv(microSecondsSinceEpoch_, kMicroSecondsPerDay) * kMicroSecondsPerDay) / kMicroSecondsPerSecond);
+        }
+
         
         // 下面几个函数都跟某个特定的对象无关，因此定义为静态成员函数
          
-        // Get time of now. 返回当前时间的微秒
+        // Get time of now. 返回当前时间的微秒，使用setDefaultClockSource()设置的时钟源
         static Timestamp now();
 
+        // 注意：两个单调时钟的起点是系统启动时刻而不是纪元，得到的Timestamp只能用来计算时间间隔和截止时间，
+        // 不能和墙上时间比较，也不能格式化成日历时间
+        static Timestamp now(ClockSource source);
+
+        // 纳秒精度的版本，返回值的起点与now(source)相同
+        static int64_t nowNanos(ClockSource source);
+
+        // 修改now()使用的时钟源，一般在程序启动时设置一次。now()的结果会被格式化成日历时间、和别的进程交换，
+        // 所以只接受墙上时钟（kRealtime、kRealtimeCoarse、kTsc）；传入单调时钟时不做修改并返回false，
+        // 单调时钟请显式调用now(source)
+        static bool setDefaultClockSource(ClockSource source);
+        static ClockSource defaultClockSource();
+
         //返回一个无效的 Timestamp 对象
         static Timestamp invalid()
         {
@@ -68,7 +106,14 @@ class Timestamp : public bo_net::copyable // 所有的命名空间在定义后
 
 
         static const int kMicroSecondsPerSecond = 1000 * 1000;
+        static const int kSecondsPerDay = 24 * 60 * 60;
+        static const int64_t kMicroSecondsPerDay = static_cast<int64_t>(kSecondsPerDay) * kMicroSecondsPerSecond;
     private:
+        // 向下取整的除法，1970年以前的时间也能算出正确的日期
+        static int64_t floorDiv(int64_t x, int64_t y) {
+            return x / y - (x % y < 0);
+        }
+
         int64_t microSecondsSinceEpoch_; // int64_t是long long int的别名
 };
 
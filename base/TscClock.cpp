@@ -0,0 +1,215 @@
+#include "TscClock.h"
+
+#include <atomic>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BO_NET_HAVE_TSC 1
+#endif
+
+using namespace bo_net;
+
+namespace
+{
+
+const int64_t kNanoSecondsPerSecond = 1000 * 1000 * 1000;
+const int64_t kCalibrateNanos = 10 * 1000 * 1000;   // 启动时用10ms测量TSC频率
+const int64_t kResyncNanos = kNanoSecondsPerSecond; // 每秒重新对齐一次墙上时间
+const int kMultShift = 32;                           // 纳秒 = (ticks * mult) >> 32
+
+int64_t clockNanos(clockid_t clock)
+{
+  struct timespec ts;
+  clock_gettime(clock, &ts);
+  return static_cast<int64_t>(ts.tv_sec) * kNanoSecondsPerSecond + ts.tv_nsec;
+}
+
+#ifdef BO_NET_HAVE_TSC
+
+inline uint64_t readTsc()
+{
+  return __rdtsc();
+}
+
+// 内核在/proc/cpuinfo中声明了这两个特性，TSC才能当作时钟用
+bool invariantTsc()
+{
+  FILE* fp = fopen("/proc/cpuinfo", "r");
+  if (fp == NULL)
+  {
+    return false;
+  }
+  bool constant = false;
+  bool nonstop = false;
+  char line[4096];
+  while (fgets(line, sizeof line, fp) != NULL)
+  {
+    if (strncmp(line, "flags", 5) == 0)
+    {
+      constant = strstr(line, " constant_tsc") != NULL;
+      nonstop = strstr(line, " nonstop_tsc") != NULL;
+      break;
+    }
+  }
+  fclose(fp);
+  return constant && nonstop;
+}
+
+// 同时读取TSC和某个系统时钟，取两次rdtsc间隔最短的那一次，减小被中断打扰带来的误差
+void samplePair(clockid_t clock, uint64_t* tsc, int64_t* nanos)
+{
+  uint64_t best = 0;
+  for (int i = 0; i < 5; ++i)
+  {
+    uint64_t before = readTsc();
+    int64_t ns = clockNanos(clock);
+    uint64_t after = readTsc();
+    if (i == 0 || after - before < best)
+    {
+      best = after - before;
+      *tsc = before + (after - before) / 2;
+      *nanos = ns;
+    }
+  }
+}
+
+// 纳秒 = 基准纳秒 + (tsc - 基准tsc) * mult >> kMultShift，这几个参数用seqlock保护，读者不加锁
+struct TscParams
+{
+  std::atomic<uint32_t> seq;
+  std::atomic<uint64_t> baseTsc;
+  std::atomic<int64_t>  baseNanos;
+  std::atomic<uint64_t> mult;
+  std::atomic<uint64_t> resyncTicks;
+  std::atomic<bool>     resyncing;
+
+  // 测量频率的起点，只在初始化和重新对齐时使用（重新对齐由resyncing保证同一时刻只有一个线程）
+  uint64_t calibTsc;
+  int64_t  calibRawNanos;
+};
+
+TscParams g_params;
+pthread_once_t g_once = PTHREAD_ONCE_INIT;
+bool g_available = false;
+
+void publish(uint64_t baseTsc, int64_t baseNanos, uint64_t mult)
+{
+  uint32_t seq = g_params.seq.load(std::memory_order_relaxed);
+  g_params.seq.store(seq + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  g_params.baseTsc.store(baseTsc, std::memory_order_relaxed);
+  g_params.baseNanos.store(baseNanos, std::memory_order_relaxed);
+  g_params.mult.store(mult, std::memory_order_relaxed);
+  g_params.seq.store(seq + 2, std::memory_order_release);
+}
+
+uint64_t computeMult(uint64_t ticks, int64_t nanos)
+{
+  return static_cast<uint64_t>((static_cast<unsigned __int128>(nanos) << kMultShift) / ticks);
+}
+
+void calibrate()
+{
+  if (!invariantTsc())
+  {
+    return;
+  }
+
+  uint64_t tsc0, tsc1;
+  int64_t raw0, raw1;
+  samplePair(CLOCK_MONOTONIC_RAW, &tsc0, &raw0);
+  do
+  {
+    samplePair(CLOCK_MONOTONIC_RAW, &tsc1, &raw1);
+  } while (raw1 - raw0 < kCalibrateNanos);
+
+  uint64_t mult = computeMult(tsc1 - tsc0, raw1 - raw0);
+  if (mult == 0)
+  {
+    return;
+  }
+  g_params.calibTsc = tsc0;
+  g_params.calibRawNanos = raw0;
+  g_params.resyncTicks.store((tsc1 - tsc0) * (kResyncNanos / kCalibrateNanos), std::memory_order_relaxed);
+  g_params.resyncing.store(false, std::memory_order_relaxed);
+
+  uint64_t baseTsc;
+  int64_t baseNanos;
+  samplePair(CLOCK_REALTIME, &baseTsc, &baseNanos);
+  publish(baseTsc, baseNanos, mult);
+  g_available = true;
+}
+
+// 以更长的时间跨度重新计算频率，并把基准对齐到当前的墙上时间（NTP的调整也会在这时被吸收）
+void resync()
+{
+  bool expected = false;
+  if (!g_params.resyncing.compare_exchange_strong(expected, true, std::memory_order_acquire))
+  {
+    return; // 别的线程正在对齐
+  }
+
+  uint64_t tsc;
+  int64_t raw;
+  samplePair(CLOCK_MONOTONIC_RAW, &tsc, &raw);
+  uint64_t mult = computeMult(tsc - g_params.calibTsc, raw - g_params.calibRawNanos);
+
+  uint64_t baseTsc;
+  int64_t baseNanos;
+  samplePair(CLOCK_REALTIME, &baseTsc, &baseNanos);
+  publish(baseTsc, baseNanos, mult);
+
+  g_params.resyncing.store(false, std::memory_order_release);
+}
+
+#endif  // BO_NET_HAVE_TSC
+
+}  // namespace
+
+bool detail::TscClock::available()
+{
+#ifdef BO_NET_HAVE_TSC
+  pthread_once(&g_once, &calibrate);
+  return g_available;
+#else
+  return false;
+#endif
+}
+
+int64_t detail::TscClock::nowNanos()
+{
+#ifdef BO_NET_HAVE_TSC
+  uint64_t tsc;
+  uint64_t baseTsc;
+  int64_t baseNanos;
+  uint64_t mult;
+  uint32_t seq;
+  do
+  {
+    seq = g_params.seq.load(std::memory_order_acquire);
+    baseTsc = g_params.baseTsc.load(std::memory_order_relaxed);
+    baseNanos = g_params.baseNanos.load(std::memory_order_relaxed);
+    mult = g_params.mult.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+  } while ((seq & 1) || seq != g_params.seq.load(std::memory_order_relaxed));
+
+  tsc = readTsc();
+  uint64_t delta = tsc - baseTsc;
+  // tsc可能比其他线程刚发布的基准稍小（不同核之间读数的微小差异），此时delta回绕成很大的数，按0处理
+  if (static_cast<int64_t>(delta) < 0)
+  {
+    return baseNanos;
+  }
+  if (__builtin_expect(delta > g_params.resyncTicks.load(std::memory_order_relaxed), 0))
+  {
+    resync();
+  }
+  return baseNanos + static_cast<int64_t>((static_cast<unsigned __int128>(delta) * mult) >> kMultShift);
+#else
+  return clockNanos(CLOCK_REALTIME);
+#endif
+}
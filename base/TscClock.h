@@ -0,0 +1,30 @@
+#ifndef BO_NET_BASE_TSCCLOCK_H
+#define BO_NET_BASE_TSCCLOCK_H
+
+#include <stdint.h>
+
+namespace bo_net
+{
+
+namespace detail
+{
+
+// 基于rdtsc的墙上时钟：第一次使用时用CLOCK_MONOTONIC_RAW测出TSC的频率，并以CLOCK_REALTIME为基准，
+// 之后每次取时间只需要一条rdtsc指令加一次乘法，不需要进入vDSO；每隔一秒左右重新对齐一次墙上时间，
+// 对齐时可能出现亚微秒级的跳变，因此需要严格单调的场合应该使用CLOCK_MONOTONIC
+//
+// 只有x86上CPU声明了constant_tsc和nonstop_tsc（频率恒定、深度睡眠时不停）时才可用，否则available()返回false
+class TscClock
+{
+    public:
+        static bool available();
+
+        // 纪元以来的纳秒数，调用前必须保证available()为true
+        static int64_t nowNanos();
+};
+
+} // namespace detail
+
+} // namespace bo_net
+
+#endif // BO_NET_BASE_TSCCLOCK_H
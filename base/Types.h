@@ -19,11 +19,23 @@ namespace bo_net
 {
     using std::string;
 
+    // 绝大多数x86/ARM服务器的cache line都是64字节，用来给频繁被多个线程写的变量做对齐和填充，避免false sharing
+    static const size_t kCacheLineSize = 64;
+
     // 将p指向的长度为n的内存区域所有字节设置为0
     // 一般只把inline函数或者static函数定义在头文件中
     inline void memZero(void *p, size_t n) {
         memset(p, 0, n);
     }
 
+    // 自旋等待时调用，x86上的pause指令可以降低自旋对超线程兄弟核的影响，同时避免退出自旋时的内存序冲突惩罚
+    inline void cpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#elif defined(__aarch64__)
+        asm volatile("yield" ::: "memory");
+#endif
+    }
+
 
 }
\ No newline at end of file
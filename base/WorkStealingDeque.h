@@ -0,0 +1,139 @@
+#ifndef BO_NET_BASE_WORKSTEALINGDEQUE_H
+#define BO_NET_BASE_WORKSTEALINGDEQUE_H
+
+#include "Types.h"
+
+#include <boost/noncopyable.hpp>
+#include <atomic>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+/**
+ * Chase-Lev work-stealing deque，内存序参考：
+ * https://fzn.fr/readings/ppopp13.pdf (Correct and Efficient Work-Stealing for Weak Memory Models)
+ * 拥有者线程在bottom一端push/pop（LIFO，缓存友好），其他线程在top一端steal（FIFO），
+ * 只有deque里只剩最后一个元素时拥有者和窃取者才需要用CAS竞争
+*/
+
+namespace bo_net
+{
+
+// T必须是可以平凡拷贝的类型（一般是指针），因为窃取者可能读到一个随后被别人拿走的槽位
+template<typename T>
+class WorkStealingDeque : boost::noncopyable
+{
+    static_assert(std::is_trivially_copyable<T>::value, "WorkStealingDeque requires trivially copyable T");
+
+    public:
+        explicit WorkStealingDeque(int64_t initialCapacity = 256)
+            : top_(0),
+              bottom_(0)
+        {
+            int64_t capacity = 1;
+            while(capacity < initialCapacity) {
+                capacity <<= 1;
+            }
+            Array *array = new Array(capacity);
+            arrays_.emplace_back(array);
+            array_.store(array, std::memory_order_relaxed);
+        }
+
+        // 只能由拥有者线程调用，空间不够时扩容为两倍
+        void push(T x) {
+            int64_t b = bottom_.load(std::memory_order_relaxed);
+            int64_t t = top_.load(std::memory_order_acquire);
+            Array *a = array_.load(std::memory_order_relaxed);
+            if(b - t > a->capacity - 1) {
+                a = grow(a, t, b);
+            }
+            a->put(b, x);
+            std::atomic_thread_fence(std::memory_order_release);
+            bottom_.store(b + 1, std::memory_order_relaxed);
+        }
+
+        // 只能由拥有者线程调用，取出最后push的元素，为空时返回false
+        bool pop(T &x) {
+            int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+            Array *a = array_.load(std::memory_order_relaxed);
+            bottom_.store(b, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            int64_t t = top_.load(std::memory_order_relaxed);
+
+            if(t > b) {
+                // 已经空了，恢复bottom
+                bottom_.store(b + 1, std::memory_order_relaxed);
+                return false;
+            }
+
+            x = a->get(b);
+            if(t == b) {
+                // 只剩最后一个元素，和窃取者竞争
+                bool won = top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+                bottom_.store(b + 1, std::memory_order_relaxed);
+                return won;
+            }
+            return true;
+        }
+
+        // 任意线程都可以调用，取出最早push的元素；为空或者与其他线程竞争失败时返回false
+        bool steal(T &x) {
+            int64_t t = top_.load(std::memory_order_acquire);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            int64_t b = bottom_.load(std::memory_order_acquire);
+            if(t >= b) {
+                return false;
+            }
+
+            Array *a = array_.load(std::memory_order_acquire);
+            x = a->get(t);
+            return top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+        }
+
+        // 并发修改时只是一个近似值
+        size_t size() const {
+            int64_t b = bottom_.load(std::memory_order_relaxed);
+            int64_t t = top_.load(std::memory_order_relaxed);
+            return b > t ? static_cast<size_t>(b - t) : 0;
+        }
+
+        bool empty() const { return size() == 0; }
+
+    private:
+        struct Array
+        {
+            explicit Array(int64_t cap)
+                : capacity(cap),
+                  mask(cap - 1),
+                  buffer(new std::atomic<T>[cap])
+            {
+            }
+
+            T get(int64_t i) const { return buffer[i & mask].load(std::memory_order_relaxed); }
+            void put(int64_t i, T x) { buffer[i & mask].store(x, std::memory_order_relaxed); }
+
+            const int64_t capacity;
+            const int64_t mask;
+            std::unique_ptr<std::atomic<T>[]> buffer;
+        };
+
+        Array* grow(Array *old, int64_t t, int64_t b) {
+            Array *array = new Array(old->capacity * 2);
+            for(int64_t i = t; i < b; ++i) {
+                array->put(i, old->get(i));
+            }
+            // 窃取者可能还在读旧数组，旧数组保留到deque析构时再释放
+            arrays_.emplace_back(array);
+            array_.store(array, std::memory_order_release);
+            return array;
+        }
+
+        alignas(kCacheLineSize) std::atomic<int64_t> top_;     // 窃取者修改
+        alignas(kCacheLineSize) std::atomic<int64_t> bottom_;  // 拥有者修改
+        std::atomic<Array*> array_;
+        std::vector<std::unique_ptr<Array> > arrays_;  // 只有拥有者线程访问
+};
+
+} // namespace bo_net
+
+#endif // BO_NET_BASE_WORKSTEALINGDEQUE_H
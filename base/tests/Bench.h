@@ -0,0 +1,266 @@
+#ifndef BO_NET_BASE_TESTS_BENCH_H
+#define BO_NET_BASE_TESTS_BENCH_H
+
+#include "base/Types.h"
+#include "base/noncopyable.h"
+
+#include <algorithm>
+#include <functional>
+#include <vector>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/**
+ * 基准测试用的小工具，只给tests目录下的*_bench使用：
+ * - 每个用例跑固定的操作次数而不是固定的时间，同样的参数每次跑的工作量完全相同，结果之间可以直接比较；
+ * - 每个用例重复--reps次，每次单独输出一行，同时给出各次吞吐量的中位数，避免被一次抖动误导；
+ * - 单次操作的延迟按固定间隔采样，输出p50/p90/p99/p999/max；
+ * - --json/--csv把所有结果写成文件，方便脚本对比两次提交之间的差异
+ *
+ * 命令行：--reps=N --iters=N --filter=子串 --json=文件 --csv=文件
+*/
+
+namespace bo_net
+{
+
+namespace bench
+{
+
+inline int64_t nowNanos() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+inline bool matchArg(const char *arg, const char *prefix) {
+    return strncmp(arg, prefix, strlen(prefix)) == 0;
+}
+
+struct Options
+{
+    Options()
+        : repetitions(3),
+          iterations(1000000)
+    {
+    }
+
+    // 不认识的参数直接报错退出，免得拼错了参数却以为生效了
+    static Options parse(int argc, char *argv[]) {
+        Options opt;
+        for(int i = 1; i < argc; ++i) {
+            const char *arg = argv[i];
+            if(matchArg(arg, "--reps=")) {
+                opt.repetitions = atoi(arg + strlen("--reps="));
+            }
+            else if(matchArg(arg, "--iters=")) {
+                opt.iterations = atoll(arg + strlen("--iters="));
+            }
+            else if(matchArg(arg, "--filter=")) {
+                opt.filter = arg + strlen("--filter=");
+            }
+            else if(matchArg(arg, "--json=")) {
+                opt.jsonPath = arg + strlen("--json=");
+            }
+            else if(matchArg(arg, "--csv=")) {
+                opt.csvPath = arg + strlen("--csv=");
+            }
+            else {
+                fprintf(stderr, "usage: %s [--reps=N] [--iters=N] [--filter=substr] [--json=file] [--csv=file]\n", argv[0]);
+                exit(2);
+            }
+        }
+        if(opt.repetitions < 1) {
+            opt.repetitions = 1;
+        }
+        if(opt.iterations < 1) {
+            opt.iterations = 1;
+        }
+        return opt;
+    }
+
+    bool selected(const string &name) const {
+        return filter.empty() || name.find(filter) != string::npos;
+    }
+
+    int     repetitions;
+    int64_t iterations;  // 每个用例所有线程加起来的操作次数
+    string  filter;
+    string  jsonPath;
+    string  csvPath;
+};
+
+// 单次操作的延迟样本，每个线程一个，结束后合并计算分位数
+class LatencySamples
+{
+    public:
+        // 每sampleEvery次操作记录一次，读时钟本身的开销不会把吞吐量拖得太低
+        explicit LatencySamples(int sampleEvery = 16)
+            : sampleEvery_(sampleEvery),
+              counter_(0)
+        {
+        }
+
+        bool shouldSample() {
+            return ++counter_ % sampleEvery_ == 0;
+        }
+
+        void add(int64_t nanos) { samples_.push_back(nanos); }
+
+        void reserve(size_t n) { samples_.reserve(n / sampleEvery_ + 1); }
+
+        void merge(const LatencySamples &other) {
+            samples_.insert(samples_.end(), other.samples_.begin(), other.samples_.end());
+        }
+
+        // q在[0, 1]之间，会打乱样本的顺序
+        int64_t percentile(double q) {
+            if(samples_.empty()) {
+                return 0;
+            }
+            size_t index = static_cast<size_t>(q * static_cast<double>(samples_.size() - 1));
+            std::nth_element(samples_.begin(), samples_.begin() + index, samples_.end());
+            return samples_[index];
+        }
+
+        int64_t max() const {
+            return samples_.empty() ? 0 : *std::max_element(samples_.begin(), samples_.end());
+        }
+
+    private:
+        int64_t sampleEvery_;
+        int64_t counter_;
+        std::vector<int64_t> samples_;
+};
+
+struct Result
+{
+    string  name;
+    int     threads;
+    int     repetition;
+    int64_t operations;
+    double  seconds;
+    int64_t p50;
+    int64_t p90;
+    int64_t p99;
+    int64_t p999;
+    int64_t max;
+
+    double opsPerSec() const { return seconds > 0 ? static_cast<double>(operations) / seconds : 0.0; }
+};
+
+// 一次运行：用例函数返回完成的操作数，把延迟样本合并进samples
+typedef std::function<int64_t (LatencySamples *samples)> RunFunc;
+
+class Runner : noncopyable
+{
+    public:
+        explicit Runner(const Options &opt)
+            : opt_(opt)
+        {
+            printf("%-40s %7s %4s %14s %9s %9s %9s %9s %11s\n",
+                   "benchmark", "threads", "rep", "ops/s", "p50_ns", "p90_ns", "p99_ns", "p999_ns", "max_ns");
+        }
+
+        ~Runner() {
+            writeJson();
+            writeCsv();
+        }
+
+        const Options& options() const { return opt_; }
+
+        void run(const string &name, int threads, const RunFunc &func) {
+            if(!opt_.selected(name)) {
+                return;
+            }
+            std::vector<double> throughput;
+            for(int rep = 0; rep < opt_.repetitions; ++rep) {
+                LatencySamples samples;
+                int64_t start = nowNanos();
+                int64_t ops = func(&samples);
+                int64_t elapsed = nowNanos() - start;
+
+                Result r;
+                r.name = name;
+                r.threads = threads;
+                r.repetition = rep;
+                r.operations = ops;
+                r.seconds = static_cast<double>(elapsed) / 1e9;
+                r.p50 = samples.percentile(0.50);
+                r.p90 = samples.percentile(0.90);
+                r.p99 = samples.percentile(0.99);
+                r.p999 = samples.percentile(0.999);
+                r.max = samples.max();
+                results_.push_back(r);
+                throughput.push_back(r.opsPerSec());
+                printf("%-40s %7d %4d %14.0f %9lld %9lld %9lld %9lld %11lld\n",
+                       name.c_str(), threads, rep, r.opsPerSec(),
+                       static_cast<long long>(r.p50), static_cast<long long>(r.p90),
+                       static_cast<long long>(r.p99), static_cast<long long>(r.p999),
+                       static_cast<long long>(r.max));
+            }
+            if(throughput.size() > 1) {
+                std::sort(throughput.begin(), throughput.end());
+                printf("%-40s %7d %4s %14.0f\n", name.c_str(), threads, "med", throughput[throughput.size() / 2]);
+            }
+            fflush(stdout);
+        }
+
+    private:
+        void writeJson() const {
+            if(opt_.jsonPath.empty()) {
+                return;
+            }
+            FILE *fp = fopen(opt_.jsonPath.c_str(), "w");
+            if(fp == NULL) {
+                fprintf(stderr, "cannot open %s: %s\n", opt_.jsonPath.c_str(), strerror(errno));
+                return;
+            }
+            fprintf(fp, "{\n  \"repetitions\": %d,\n  \"iterations\": %lld,\n  \"results\": [\n",
+                    opt_.repetitions, static_cast<long long>(opt_.iterations));
+            for(size_t i = 0; i < results_.size(); ++i) {
+                const Result &r = results_[i];
+                // 用例名字都是程序里写死的，不含需要转义的字符
+                fprintf(fp, "    {\"name\": \"%s\", \"threads\": %d, \"repetition\": %d, \"operations\": %lld, "
+                            "\"seconds\": %.6f, \"ops_per_sec\": %.1f, \"p50_ns\": %lld, \"p90_ns\": %lld, "
+                            "\"p99_ns\": %lld, \"p999_ns\": %lld, \"max_ns\": %lld}%s\n",
+                        r.name.c_str(), r.threads, r.repetition, static_cast<long long>(r.operations),
+                        r.seconds, r.opsPerSec(), static_cast<long long>(r.p50), static_cast<long long>(r.p90),
+                        static_cast<long long>(r.p99), static_cast<long long>(r.p999),
+                        static_cast<long long>(r.max), i + 1 < results_.size() ? "," : "");
+            }
+            fprintf(fp, "  ]\n}\n");
+            fclose(fp);
+        }
+
+        void writeCsv() const {
+            if(opt_.csvPath.empty()) {
+                return;
+            }
+            FILE *fp = fopen(opt_.csvPath.c_str(), "w");
+            if(fp == NULL) {
+                fprintf(stderr, "cannot open %s: %s\n", opt_.csvPath.c_str(), strerror(errno));
+                return;
+            }
+            fprintf(fp, "name,threads,repetition,operations,seconds,ops_per_sec,p50_ns,p90_ns,p99_ns,p999_ns,max_ns\n");
+            for(const Result &r : results_) {
+                fprintf(fp, "%s,%d,%d,%lld,%.6f,%.1f,%lld,%lld,%lld,%lld,%lld\n",
+                        r.name.c_str(), r.threads, r.repetition, static_cast<long long>(r.operations),
+                        r.seconds, r.opsPerSec(), static_cast<long long>(r.p50), static_cast<long long>(r.p90),
+                        static_cast<long long>(r.p99), static_cast<long long>(r.p999),
+                        static_cast<long long>(r.max));
+            }
+            fclose(fp);
+        }
+
+        Options opt_;
+        std::vector<Result> results_;
+};
+
+} // namespace bench
+
+} // namespace bo_net
+
+#endif // BO_NET_BASE_TESTS_BENCH_H
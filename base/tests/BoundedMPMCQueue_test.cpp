@@ -0,0 +1,136 @@
+// BoundedMPMCQueue的正确性测试：
+// - 容量向上取整到2的幂，tryPut在满时、tryTake在空时失败，单线程下先进先出；
+// - 析构时还留在队列里的元素会被析构；
+// - 多个生产者和消费者在很小的队列上put/take（频繁走挂起/唤醒的慢路径），每个元素恰好被取走一次，
+//   同一个消费者看到的同一个生产者的元素保持放入的顺序
+
+#include "base/BoundedMPMCQueue.h"
+#include "base/Thread.h"
+#include "base/tests/Check.h"
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <stdio.h>
+
+using namespace bo_net;
+
+namespace
+{
+
+void testTryPutTake()
+{
+  BoundedMPMCQueue<int> queue(5);
+  CHECK_EQ(queue.capacity(), 8);
+  CHECK(queue.empty());
+
+  int x = -1;
+  CHECK(!queue.tryTake(x));
+  for (int i = 0; i < 8; ++i)
+  {
+    CHECK(queue.tryPut(i));
+  }
+  CHECK(queue.full());
+  CHECK(!queue.tryPut(8));
+  CHECK_EQ(queue.size(), 8);
+
+  for (int i = 0; i < 8; ++i)
+  {
+    CHECK(queue.tryTake(x));
+    CHECK_EQ(x, i);
+  }
+  CHECK(!queue.tryTake(x));
+  CHECK(queue.empty());
+}
+
+void testDestroysRemaining()
+{
+  std::shared_ptr<int> item = std::make_shared<int>(0);
+  {
+    BoundedMPMCQueue<std::shared_ptr<int> > queue(4);
+    queue.put(item);
+    queue.put(item);
+    queue.put(item);
+    std::shared_ptr<int> taken = queue.take();
+    CHECK_EQ(item.use_count(), 4);
+  }
+  CHECK_EQ(item.use_count(), 1);
+}
+
+// 元素的高32位是生产者编号，低32位是该生产者内的序号
+void testConcurrent()
+{
+  const int kProducers = 4;
+  const int kConsumers = 4;
+  const int64_t kPerProducer = 50000;
+  const int64_t kTotal = kProducers * kPerProducer;
+  BoundedMPMCQueue<int64_t> queue(4);
+  std::unique_ptr<std::atomic<int>[]> seen(new std::atomic<int>[kTotal]);
+  for (int64_t i = 0; i < kTotal; ++i)
+  {
+    seen[i].store(0, std::memory_order_relaxed);
+  }
+
+  std::vector<std::unique_ptr<Thread> > threads;
+  for (int c = 0; c < kConsumers; ++c)
+  {
+    threads.emplace_back(new Thread([&] {
+      std::vector<int64_t> last(kProducers, -1);
+      for (;;)
+      {
+        int64_t x = queue.take();
+        if (x < 0)
+        {
+          break;
+        }
+        int producer = static_cast<int>(x >> 32);
+        int64_t sequence = x & 0xffffffff;
+        CHECK(producer < kProducers);
+        CHECK(sequence > last[producer]);
+        last[producer] = sequence;
+        CHECK_EQ(seen[producer * kPerProducer + sequence].fetch_add(1), 0);
+      }
+    }));
+  }
+  for (int p = 0; p < kProducers; ++p)
+  {
+    threads.emplace_back(new Thread([&queue, p, kPerProducer] {
+      for (int64_t i = 0; i < kPerProducer; ++i)
+      {
+        queue.put((static_cast<int64_t>(p) << 32) | i);
+      }
+    }));
+  }
+  for (auto& thr : threads)
+  {
+    thr->start();
+  }
+  for (int p = 0; p < kProducers; ++p)
+  {
+    threads[kConsumers + p]->join();
+  }
+  for (int c = 0; c < kConsumers; ++c)
+  {
+    queue.put(-1);
+  }
+  for (int c = 0; c < kConsumers; ++c)
+  {
+    threads[c]->join();
+  }
+
+  for (int64_t i = 0; i < kTotal; ++i)
+  {
+    CHECK_EQ(seen[i].load(), 1);
+  }
+  CHECK(queue.empty());
+}
+
+}  // namespace
+
+int main()
+{
+  testTryPutTake();
+  testDestroysRemaining();
+  testConcurrent();
+  printf("BoundedMPMCQueue_test passed\n");
+}
@@ -0,0 +1,31 @@
+#ifndef BO_NET_BASE_TESTS_CHECK_H
+#define BO_NET_BASE_TESTS_CHECK_H
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/**
+ * 正确性测试（tests目录下的*_test）用的检查宏。默认的Release构建定义了NDEBUG，assert不起作用，
+ * 测试里一律用CHECK：失败时打印位置和表达式，然后abort，ctest把它记为失败
+*/
+
+#define CHECK(cond)                                                           \
+    do {                                                                      \
+        if(!(cond)) {                                                         \
+            fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+            abort();                                                          \
+        }                                                                     \
+    } while(0)
+
+#define CHECK_EQ(a, b)                                                        \
+    do {                                                                      \
+        long long va_ = static_cast<long long>(a);                            \
+        long long vb_ = static_cast<long long>(b);                            \
+        if(va_ != vb_) {                                                      \
+            fprintf(stderr, "%s:%d: CHECK_EQ failed: %s == %s (%lld vs %lld)\n", \
+                    __FILE__, __LINE__, #a, #b, va_, vb_);                    \
+            abort();                                                          \
+        }                                                                     \
+    } while(0)
+
+#endif // BO_NET_BASE_TESTS_CHECK_H
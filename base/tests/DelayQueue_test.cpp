@@ -0,0 +1,259 @@
+// DelayQueue的正确性测试：
+// - 截止时间相同的元素按放入的顺序出队；
+// - 随机地放入、取消、取出，和一个排好序的参照模型比较，覆盖removeAt()填补之后上浮和下沉两种情况；
+// - 元素出队或者取消之后handle失效，slot被复用之后旧handle也不能取消新元素；
+// - leader正在按队首的截止时间等待时取消队首，take()拿到的是下一个元素，而且不早于它的截止时间；
+// - 多个消费者同时take()，每个元素恰好被取走一次，都不早于各自的截止时间
+
+#include "base/DelayQueue.h"
+#include "base/Thread.h"
+#include "base/tests/Check.h"
+
+#include <algorithm>
+#include <memory>
+#include <utility>
+#include <vector>
+#include <stdio.h>
+
+using namespace bo_net;
+
+namespace
+{
+
+unsigned nextRandom(unsigned* seed)
+{
+  *seed = *seed * 1103515245 + 12345;
+  return *seed >> 16;
+}
+
+void testEqualDeadlinesFifo()
+{
+  DelayQueue<int> queue;
+  Timestamp base = addTime(DelayQueue<int>::now(), -1.0);
+  // 三个截止时间交错放入，每个截止时间上的元素按放入顺序编号
+  for (int i = 0; i < 30; ++i)
+  {
+    queue.put(i, addTime(base, 0.001 * (i % 3)));
+  }
+  std::vector<int> out;
+  CHECK_EQ(queue.drainExpired(out), 30);
+  CHECK_EQ(out.size(), 30);
+  for (int i = 0; i < 30; ++i)
+  {
+    // 先是截止时间最早的i%3==0，再是1，再是2，各自保持放入顺序
+    CHECK_EQ(out[i], (i % 10) * 3 + i / 10);
+  }
+  CHECK(queue.empty());
+}
+
+// 参照模型：按(截止时间, 放入顺序)排好序的(截止时间偏移, 值)
+typedef std::pair<int, int> ModelEntry;
+
+void testRandomCancelAgainstModel(unsigned seed)
+{
+  DelayQueue<int> queue;
+  // 全部是已经过去的截止时间，drainExpired()可以立即取出
+  Timestamp base = addTime(DelayQueue<int>::now(), -10.0);
+  std::vector<std::pair<ModelEntry, DelayQueue<int>::Handle> > live;  // 按放入顺序
+  int nextValue = 0;
+
+  for (int round = 0; round < 2000; ++round)
+  {
+    unsigned op = nextRandom(&seed) % 10;
+    if (op < 6 || live.empty())
+    {
+      // 截止时间只有50种，大量重复，偏移越大越晚
+      int offset = static_cast<int>(nextRandom(&seed) % 50);
+      int value = nextValue++;
+      DelayQueue<int>::Handle h = queue.put(value, addTime(base, offset * 0.001));
+      live.push_back(std::make_pair(ModelEntry(offset, value), h));
+    }
+    else if (op < 9)
+    {
+      // 取消任意位置的元素：堆中间的元素被最后一个元素填补，可能上浮也可能下沉
+      size_t i = nextRandom(&seed) % live.size();
+      CHECK(queue.cancel(live[i].second));
+      CHECK(!queue.cancel(live[i].second));
+      live.erase(live.begin() + i);
+    }
+    else
+    {
+      size_t n = nextRandom(&seed) % 5 + 1;
+      std::vector<int> out;
+      size_t taken = queue.drainExpired(out, n);
+      CHECK_EQ(taken, std::min(n, live.size()));
+      // 模型中最早的taken个：偏移最小，相同偏移时放入最早（live本身就是放入顺序，稳定排序即可）
+      std::vector<std::pair<ModelEntry, DelayQueue<int>::Handle> > sorted(live);
+      std::stable_sort(sorted.begin(), sorted.end(),
+                       [](const std::pair<ModelEntry, DelayQueue<int>::Handle>& a,
+                          const std::pair<ModelEntry, DelayQueue<int>::Handle>& b) {
+                         return a.first.first < b.first.first;
+                       });
+      for (size_t i = 0; i < taken; ++i)
+      {
+        CHECK_EQ(out[i], sorted[i].first.second);
+        CHECK(!queue.cancel(sorted[i].second));
+        for (size_t j = 0; j < live.size(); ++j)
+        {
+          if (live[j].first.second == out[i])
+          {
+            live.erase(live.begin() + j);
+            break;
+          }
+        }
+      }
+    }
+    CHECK_EQ(queue.size(), live.size());
+  }
+
+  std::vector<int> out;
+  queue.drainExpired(out);
+  std::stable_sort(live.begin(), live.end(),
+                   [](const std::pair<ModelEntry, DelayQueue<int>::Handle>& a,
+                      const std::pair<ModelEntry, DelayQueue<int>::Handle>& b) {
+                     return a.first.first < b.first.first;
+                   });
+  CHECK_EQ(out.size(), live.size());
+  for (size_t i = 0; i < out.size(); ++i)
+  {
+    CHECK_EQ(out[i], live[i].first.second);
+  }
+}
+
+void testStaleHandle()
+{
+  DelayQueue<int> queue;
+  Timestamp past = addTime(DelayQueue<int>::now(), -1.0);
+  CHECK(!queue.cancel(DelayQueue<int>::Handle()));
+
+  DelayQueue<int>::Handle a = queue.put(1, past);
+  CHECK(a.valid());
+  std::vector<int> out;
+  CHECK_EQ(queue.drainExpired(out), 1);
+  // 已经出队
+  CHECK(!queue.cancel(a));
+
+  // 复用a的slot，旧handle的generation对不上
+  DelayQueue<int>::Handle b = queue.put(2, past);
+  CHECK(!queue.cancel(a));
+  CHECK_EQ(queue.size(), 1);
+  CHECK(queue.cancel(b));
+  CHECK(!queue.cancel(b));
+  CHECK(queue.empty());
+
+  DelayQueue<int>::Handle c = queue.put(3, past);
+  CHECK(!queue.cancel(a));
+  CHECK(!queue.cancel(b));
+  CHECK_EQ(queue.take(), 3);
+  CHECK(!queue.cancel(c));
+}
+
+void testCancelHeadWhileLeaderWaits()
+{
+  DelayQueue<int> queue;
+  Timestamp start = DelayQueue<int>::now();
+  Timestamp headWhen = addTime(start, 0.2);
+  Timestamp nextWhen = addTime(start, 0.4);
+  DelayQueue<int>::Handle head = queue.put(1, headWhen);
+  queue.put(2, nextWhen);
+
+  int taken = 0;
+  Timestamp takenAt;
+  Thread consumer([&] {
+    taken = queue.take();
+    takenAt = DelayQueue<int>::now();
+  });
+  consumer.start();
+  // 等消费者成为leader、按队首的截止时间睡下
+  CurrentThread::sleepUsec(50 * 1000);
+  CHECK(queue.cancel(head));
+  consumer.join();
+
+  CHECK_EQ(taken, 2);
+  CHECK(!(takenAt < nextWhen));
+  CHECK(timeDifference(takenAt, nextWhen) < 1.0);
+  CHECK(queue.empty());
+}
+
+void testLeaderFollowerConsumers()
+{
+  const int kConsumers = 4;
+  const int kItems = 400;
+  DelayQueue<int> queue;
+  std::unique_ptr<Timestamp[]> deadlines(new Timestamp[kItems]);
+  std::unique_ptr<int[]> takenCount(new int[kItems]());
+  int earlyTakes = 0;
+  MutexLock resultMutex;
+
+  std::vector<std::unique_ptr<Thread> > consumers;
+  for (int c = 0; c < kConsumers; ++c)
+  {
+    consumers.emplace_back(new Thread([&] {
+      for (;;)
+      {
+        int x = queue.take();
+        if (x < 0)
+        {
+          break;
+        }
+        Timestamp now = DelayQueue<int>::now();
+        MutexLockGuard lock(resultMutex);
+        ++takenCount[x];
+        if (now < deadlines[x])
+        {
+          ++earlyTakes;
+        }
+      }
+    }));
+    consumers.back()->start();
+  }
+
+  // 截止时间打乱之后放入，后放入的元素经常成为新的队首，需要leader重新计时
+  unsigned seed = 7;
+  Timestamp base = addTime(DelayQueue<int>::now(), 0.02);
+  std::vector<int> order(kItems);
+  for (int i = 0; i < kItems; ++i)
+  {
+    order[i] = i;
+  }
+  for (int i = kItems - 1; i > 0; --i)
+  {
+    std::swap(order[i], order[nextRandom(&seed) % (i + 1)]);
+  }
+  for (int i : order)
+  {
+    deadlines[i] = addTime(base, 0.0005 * i);
+    queue.put(i, deadlines[i]);
+  }
+  Timestamp last = addTime(base, 0.0005 * kItems);
+  for (int c = 0; c < kConsumers; ++c)
+  {
+    queue.put(-1, last);
+  }
+  for (auto& thr : consumers)
+  {
+    thr->join();
+  }
+
+  CHECK_EQ(earlyTakes, 0);
+  for (int i = 0; i < kItems; ++i)
+  {
+    CHECK_EQ(takenCount[i], 1);
+  }
+  CHECK(queue.empty());
+}
+
+}  // namespace
+
+int main()
+{
+  testEqualDeadlinesFifo();
+  for (unsigned seed = 1; seed <= 5; ++seed)
+  {
+    testRandomCancelAgainstModel(seed);
+  }
+  testStaleHandle();
+  testCancelHeadWhileLeaderWaits();
+  testLeaderFollowerConsumers();
+  printf("DelayQueue_test passed\n");
+}
@@ -0,0 +1,146 @@
+// MpscQueue的正确性测试：
+// - 单线程下push/tryPop先进先出，取空之后stub重新入队，队列可以反复用空再用；
+// - 多个生产者同时put()，消费者用take()取：每个元素恰好取到一次，同一个生产者的元素保持入队顺序；
+// - 消费者已经睡在take()的futex上之后，put()能把它叫醒；生产者时断时续地入队，消费者反复在自旋和睡眠之间切换
+
+#include "base/MpscQueue.h"
+#include "base/Thread.h"
+#include "base/tests/Check.h"
+
+#include <memory>
+#include <vector>
+#include <stdio.h>
+#include <unistd.h>
+
+using namespace bo_net;
+
+namespace
+{
+
+struct Item : public MpscNode
+{
+  int producer;
+  int seq;
+};
+
+void testSingleThread()
+{
+  MpscQueue<Item> queue;
+  Item items[8];
+  CHECK(queue.empty());
+  CHECK(queue.tryPop() == NULL);
+  for (int round = 0; round < 3; ++round)
+  {
+    for (int i = 0; i < 8; ++i)
+    {
+      items[i].seq = i;
+      queue.push(&items[i]);
+    }
+    CHECK(!queue.empty());
+    for (int i = 0; i < 8; ++i)
+    {
+      Item* x = queue.tryPop();
+      CHECK(x == &items[i]);
+    }
+    CHECK(queue.tryPop() == NULL);
+    CHECK(queue.empty());
+  }
+
+  // 只有一个元素时，取走它需要先把stub放回队尾
+  queue.push(&items[0]);
+  CHECK(queue.tryPop() == &items[0]);
+  queue.push(&items[1]);
+  queue.push(&items[2]);
+  CHECK(queue.tryPop() == &items[1]);
+  queue.push(&items[3]);
+  CHECK(queue.tryPop() == &items[2]);
+  CHECK(queue.tryPop() == &items[3]);
+  CHECK(queue.tryPop() == NULL);
+}
+
+// pauseEvery不为0时，生产者每入队这么多个元素就停一下，让消费者睡到futex上
+void testProducers(int numProducers, int perProducer, int pauseEvery)
+{
+  MpscQueue<Item> queue;
+  std::unique_ptr<Item[]> items(new Item[numProducers * perProducer]);
+  std::vector<std::unique_ptr<Thread> > producers;
+  for (int p = 0; p < numProducers; ++p)
+  {
+    producers.emplace_back(new Thread([&, p] {
+      for (int i = 0; i < perProducer; ++i)
+      {
+        Item* x = &items[p * perProducer + i];
+        x->producer = p;
+        x->seq = i;
+        queue.put(x);
+        if (pauseEvery != 0 && (i + 1) % pauseEvery == 0)
+        {
+          usleep(1000);
+        }
+      }
+    }));
+  }
+  for (auto& thr : producers)
+  {
+    thr->start();
+  }
+
+  std::vector<int> nextSeq(numProducers, 0);
+  const int total = numProducers * perProducer;
+  for (int n = 0; n < total; ++n)
+  {
+    Item* x = queue.take();
+    CHECK(x->producer >= 0 && x->producer < numProducers);
+    CHECK_EQ(x->seq, nextSeq[x->producer]);
+    ++nextSeq[x->producer];
+  }
+  for (auto& thr : producers)
+  {
+    thr->join();
+  }
+  for (int p = 0; p < numProducers; ++p)
+  {
+    CHECK_EQ(nextSeq[p], perProducer);
+  }
+  CHECK(queue.tryPop() == NULL);
+  CHECK(queue.empty());
+}
+
+// 消费者先睡下，生产者过一会儿才put()，一次一个，每次都要靠futex唤醒
+void testWakeSleepingConsumer()
+{
+  const int kRounds = 20;
+  MpscQueue<Item> queue;
+  Item items[kRounds];
+  int received = 0;
+  Thread consumer([&] {
+    for (int i = 0; i < kRounds; ++i)
+    {
+      Item* x = queue.take();
+      CHECK(x == &items[i]);
+      ++received;
+    }
+  });
+  consumer.start();
+  for (int i = 0; i < kRounds; ++i)
+  {
+    // 远远超过take()自旋的时间
+    usleep(2000);
+    queue.put(&items[i]);
+  }
+  consumer.join();
+  CHECK_EQ(received, kRounds);
+  CHECK(queue.empty());
+}
+
+}  // namespace
+
+int main()
+{
+  testSingleThread();
+  testProducers(1, 100000, 0);
+  testProducers(4, 50000, 0);
+  testProducers(8, 2000, 100);
+  testWakeSleepingConsumer();
+  printf("MpscQueue_test passed\n");
+}
@@ -0,0 +1,127 @@
+// MutexLock三种策略和Condition的正确性测试：
+// - 多个线程在锁保护下累加同一个计数器，结果不多不少；
+// - 两个线程用条件变量来回交接（乒乓），不丢唤醒；
+// - waitForSeconds/waitUntil超时返回true，等待时间不短于要求的时间，已经过去的截止时间立即返回
+
+#include "base/Condition.h"
+#include "base/Mutex.h"
+#include "base/Thread.h"
+#include "base/Timestamp.h"
+#include "base/tests/Check.h"
+
+#include <memory>
+#include <vector>
+#include <stdio.h>
+
+using namespace bo_net;
+
+namespace
+{
+
+const MutexLock::Policy kPolicies[] = { MutexLock::kPthread, MutexLock::kAdaptive, MutexLock::kFair };
+
+void testCounter(MutexLock::Policy policy)
+{
+  const int kThreads = 4;
+  const int kIncrements = 20000;
+  MutexLock mutex(policy);
+  int64_t counter = 0;
+
+  std::vector<std::unique_ptr<Thread> > threads;
+  for (int i = 0; i < kThreads; ++i)
+  {
+    threads.emplace_back(new Thread([&] {
+      for (int j = 0; j < kIncrements; ++j)
+      {
+        MutexLockGuard lock(mutex);
+        CHECK(mutex.isLockedByThisThread());
+        ++counter;
+      }
+    }));
+    threads.back()->start();
+  }
+  for (auto& thr : threads)
+  {
+    thr->join();
+  }
+  CHECK_EQ(counter, kThreads * kIncrements);
+}
+
+// turn为0时轮到主线程，为1时轮到另一个线程，每一方把turn交给对方之后等待
+void testPingPong(MutexLock::Policy policy)
+{
+  const int kRounds = 2000;
+  MutexLock mutex(policy);
+  Condition cond(mutex);
+  int turn = 0;
+  int rounds = 0;
+
+  Thread peer([&] {
+    for (int i = 0; i < kRounds; ++i)
+    {
+      MutexLockGuard lock(mutex);
+      while (turn != 1)
+      {
+        cond.wait();
+      }
+      CHECK(mutex.isLockedByThisThread());
+      ++rounds;
+      turn = 0;
+      cond.notifyOne();
+    }
+  });
+  peer.start();
+
+  for (int i = 0; i < kRounds; ++i)
+  {
+    MutexLockGuard lock(mutex);
+    while (turn != 0)
+    {
+      cond.wait();
+    }
+    ++rounds;
+    turn = 1;
+    cond.notifyOne();
+  }
+  peer.join();
+  CHECK_EQ(rounds, 2 * kRounds);
+}
+
+void testTimeout(MutexLock::Policy policy)
+{
+  MutexLock mutex(policy);
+  Condition cond(mutex);
+  MutexLockGuard lock(mutex);
+
+  Timestamp start = Timestamp::now(Timestamp::kMonotonic);
+  // 可能被虚假唤醒，循环到超时为止
+  while (!cond.waitForSeconds(0.05))
+  {
+  }
+  CHECK(timeDifference(Timestamp::now(Timestamp::kMonotonic), start) >= 0.05);
+  CHECK(mutex.isLockedByThisThread());
+
+  Timestamp deadline = addTime(Timestamp::now(Timestamp::kMonotonic), 0.03);
+  while (!cond.waitUntil(deadline))
+  {
+  }
+  CHECK(!(Timestamp::now(Timestamp::kMonotonic) < deadline));
+
+  // 截止时间已经过去
+  start = Timestamp::now(Timestamp::kMonotonic);
+  CHECK(cond.waitUntil(addTime(start, -1.0)));
+  CHECK(timeDifference(Timestamp::now(Timestamp::kMonotonic), start) < 0.5);
+}
+
+}  // namespace
+
+int main()
+{
+  for (MutexLock::Policy policy : kPolicies)
+  {
+    testCounter(policy);
+    testPingPong(policy);
+    testTimeout(policy);
+  }
+  printf("Mutex_test passed\n");
+}
@@ -0,0 +1,197 @@
+// 比较SlabAllocator和malloc在多线程下的分配/释放吞吐量，以及跨线程释放（生产者分配、消费者释放）的情况，
+// 同时输出测试前后的RSS，观察池子在反复分配释放之后是否稳定
+//
+// usage: ObjectPool_bench [ops_per_thread] [object_size]
+
+#include "base/BlockingQueue.h"
+#include "base/ObjectPool.h"
+#include "base/Thread.h"
+
+#include <memory>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+using namespace bo_net;
+
+namespace
+{
+
+int64_t monotonicNanos()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+long rssKB()
+{
+  long pages = 0;
+  long rss = 0;
+  FILE* fp = fopen("/proc/self/statm", "r");
+  if (fp != NULL)
+  {
+    if (fscanf(fp, "%ld %ld", &pages, &rss) != 2)
+    {
+      rss = 0;
+    }
+    fclose(fp);
+  }
+  return rss * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+struct MallocPolicy
+{
+  static const char* name() { return "malloc"; }
+  static void* allocate(size_t size) { return ::malloc(size); }
+  static void deallocate(void* p, size_t) { ::free(p); }
+};
+
+struct SlabPolicy
+{
+  static const char* name() { return "slab"; }
+  static void* allocate(size_t size) { return SlabAllocator::allocate(size); }
+  static void deallocate(void* p, size_t size) { SlabAllocator::deallocate(p, size); }
+};
+
+// 每个线程维护一个窗口，不停地释放最老的一个、分配一个新的，模拟连接、定时器这类对象的生命周期
+template<typename Policy>
+void churn(int ops, size_t size)
+{
+  const int kWindow = 1024;
+  std::vector<void*> window(kWindow, static_cast<void*>(NULL));
+  for (int i = 0; i < ops; ++i)
+  {
+    void*& slot = window[i % kWindow];
+    Policy::deallocate(slot, size);
+    slot = Policy::allocate(size);
+    *static_cast<char*>(slot) = static_cast<char>(i);
+  }
+  for (void* p : window)
+  {
+    Policy::deallocate(p, size);
+  }
+}
+
+template<typename Policy>
+void benchChurn(int threads, int ops, size_t size)
+{
+  std::vector<std::unique_ptr<Thread> > workers;
+  int64_t start = monotonicNanos();
+  for (int i = 0; i < threads; ++i)
+  {
+    workers.emplace_back(new Thread([ops, size] { churn<Policy>(ops, size); }));
+    workers.back()->start();
+  }
+  for (auto& t : workers)
+  {
+    t->join();
+  }
+  double seconds = static_cast<double>(monotonicNanos() - start) / 1e9;
+  printf("churn     %-7s threads %2d  size %5zu  %8.2f Mops/s  rss %8ld KB\n",
+         Policy::name(), threads, size, static_cast<double>(threads) * ops / seconds / 1e6, rssKB());
+}
+
+// 生产者分配、消费者释放：所有块都从生产者的缓存流向消费者的缓存，再成批回到中心池
+template<typename Policy>
+void benchCrossThread(int pairs, int ops, size_t size)
+{
+  std::vector<std::unique_ptr<BlockingQueue<void*> > > queues;
+  std::vector<std::unique_ptr<Thread> > workers;
+  int64_t start = monotonicNanos();
+  for (int i = 0; i < pairs; ++i)
+  {
+    queues.emplace_back(new BlockingQueue<void*>);
+    BlockingQueue<void*>* queue = queues.back().get();
+    workers.emplace_back(new Thread([queue, ops, size] {
+      std::vector<void*> batch;
+      for (int n = 0; n < ops; ++n)
+      {
+        batch.push_back(Policy::allocate(size));
+        if (batch.size() == 64)
+        {
+          queue->putBatch(std::move(batch));
+        }
+      }
+      queue->putBatch(std::move(batch));
+      queue->put(NULL);
+    }));
+    workers.emplace_back(new Thread([queue, size] {
+      std::vector<void*> batch;
+      for (;;)
+      {
+        batch.clear();
+        queue->takeBatch(256, batch);
+        for (void* p : batch)
+        {
+          if (p == NULL)
+          {
+            return;
+          }
+          Policy::deallocate(p, size);
+        }
+      }
+    }));
+  }
+  for (auto& t : workers)
+  {
+    t->start();
+  }
+  for (auto& t : workers)
+  {
+    t->join();
+  }
+  double seconds = static_cast<double>(monotonicNanos() - start) / 1e9;
+  printf("cross     %-7s pairs   %2d  size %5zu  %8.2f Mops/s  rss %8ld KB\n",
+         Policy::name(), pairs, size, static_cast<double>(pairs) * ops / seconds / 1e6, rssKB());
+}
+
+// BlockingQueue内部deque的分段：默认分配器和PoolAllocator
+template<typename Alloc>
+void benchQueue(const char* name, int ops)
+{
+  BlockingQueue<int64_t, Alloc> queue;
+  int64_t start = monotonicNanos();
+  Thread producer([&queue, ops] {
+    for (int i = 0; i < ops; ++i)
+    {
+      queue.put(i);
+    }
+  });
+  producer.start();
+  int64_t sum = 0;
+  for (int i = 0; i < ops; ++i)
+  {
+    sum += queue.take();
+  }
+  producer.join();
+  double seconds = static_cast<double>(monotonicNanos() - start) / 1e9;
+  printf("queue     %-14s       %8.2f Mops/s  (checksum %lld)\n",
+         name, ops / seconds / 1e6, static_cast<long long>(sum & 0xff));
+}
+
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+  int ops = argc > 1 ? atoi(argv[1]) : 2 * 1000 * 1000;
+  size_t size = argc > 2 ? static_cast<size_t>(atoi(argv[2])) : 96;
+
+  printf("rss at start %ld KB\n", rssKB());
+  const int kThreads[] = { 1, 2, 4, 8 };
+  for (int threads : kThreads)
+  {
+    benchChurn<MallocPolicy>(threads, ops, size);
+    benchChurn<SlabPolicy>(threads, ops, size);
+  }
+  for (int pairs : kThreads)
+  {
+    benchCrossThread<MallocPolicy>(pairs, ops, size);
+    benchCrossThread<SlabPolicy>(pairs, ops, size);
+  }
+  benchQueue<std::allocator<int64_t> >("std::allocator", ops);
+  benchQueue<PoolAllocator<int64_t> >("PoolAllocator", ops);
+  printf("slab reserved %zu KB\n", SlabAllocator::reservedBytes() / 1024);
+}
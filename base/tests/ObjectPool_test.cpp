@@ -0,0 +1,208 @@
+// SlabAllocator/ObjectPool的正确性测试：
+// - size class的边界：256和257、2048和2049分别落在哪一档，同一档内的块可以互相复用，超过kMaxSize的不占slab；
+// - 一个线程分配、另一个线程释放，两个线程退出时缓存都还给中心池，之后别的线程能全部复用，不再申请新的slab，
+//   也不会把同一个块分给两个人；
+// - 线程退出时缓存已经析构（t_cacheDestroyed），其他thread_local对象的析构函数里的分配和释放直接走中心池，
+//   这些块之后照样能被复用
+
+#include "base/ObjectPool.h"
+#include "base/Thread.h"
+#include "base/tests/Check.h"
+
+#include <set>
+#include <vector>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+using namespace bo_net;
+
+namespace
+{
+
+// 每次分配的块数。后面两个测试各用一个这个进程里别处没用过的size class，块大小选得让kBlocks个块
+// 差不多切满一块256KB的slab：中心池里只要少了一些块，重新分配kBlocks个就得再申请slab，reservedBytes()会变
+const int kBlocks = 1000;
+
+// 分配kBlocks个size字节的块，每个块填上自己的编号，全部分完之后检查没有被别人覆盖，也没有重复的地址
+void allocateAndVerify(size_t size, std::vector<void*>* blocks)
+{
+  std::set<void*> seen;
+  for (int i = 0; i < kBlocks; ++i)
+  {
+    void* p = SlabAllocator::allocate(size);
+    CHECK(p != NULL);
+    CHECK_EQ(reinterpret_cast<uintptr_t>(p) % SlabAllocator::kAlignment, 0);
+    CHECK(seen.insert(p).second);
+    memset(p, i & 0xff, size);
+    blocks->push_back(p);
+  }
+  for (int i = 0; i < kBlocks; ++i)
+  {
+    const unsigned char* bytes = static_cast<const unsigned char*>((*blocks)[i]);
+    CHECK_EQ(bytes[0], i & 0xff);
+    CHECK_EQ(bytes[size - 1], i & 0xff);
+  }
+}
+
+void freeAll(size_t size, std::vector<void*>* blocks)
+{
+  for (void* p : *blocks)
+  {
+    SlabAllocator::deallocate(p, size);
+  }
+  blocks->clear();
+}
+
+// 新线程里，同一档从中心池切出来的第一批块是连续的，相邻两块的距离就是这一档的大小
+size_t carvedStride(size_t size)
+{
+  size_t stride = 0;
+  Thread thread([&] {
+    char* a = static_cast<char*>(SlabAllocator::allocate(size));
+    char* b = static_cast<char*>(SlabAllocator::allocate(size));
+    stride = static_cast<size_t>(b - a);
+    SlabAllocator::deallocate(b, size);
+    SlabAllocator::deallocate(a, size);
+  });
+  thread.start();
+  thread.join();
+  return stride;
+}
+
+// 释放一个size字节的块之后马上分配other字节，线程缓存是后进先出的，同一档会拿回同一个块
+bool sameClass(size_t size, size_t other)
+{
+  void* p = SlabAllocator::allocate(size);
+  SlabAllocator::deallocate(p, size);
+  void* q = SlabAllocator::allocate(other);
+  SlabAllocator::deallocate(q, other);
+  return p == q;
+}
+
+void testSizeClassBoundaries()
+{
+  // 这几档在这个进程里还没有用过，第一批是刚切出来的
+  CHECK_EQ(carvedStride(256), 256);
+  CHECK_EQ(carvedStride(257), 384);
+  CHECK_EQ(carvedStride(2048), 2048);
+
+  CHECK(sameClass(256, 241));
+  CHECK(!sameClass(256, 257));
+  CHECK(sameClass(257, 384));
+  CHECK(!sameClass(257, 256));
+  CHECK(sameClass(2048, 1921));
+  CHECK(!sameClass(2048, 1920));
+
+  // 2049字节交给::operator new，不会再申请slab
+  const size_t reserved = SlabAllocator::reservedBytes();
+  std::vector<void*> blocks;
+  allocateAndVerify(2049, &blocks);
+  freeAll(2049, &blocks);
+  CHECK_EQ(SlabAllocator::reservedBytes(), reserved);
+}
+
+void testCrossThreadFree()
+{
+  // 一批136块，8批正好切完一块slab
+  const size_t kSize = 240;
+  std::vector<void*> blocks;
+  Thread producer([&] { allocateAndVerify(kSize, &blocks); });
+  producer.start();
+  producer.join();
+  const size_t reserved = SlabAllocator::reservedBytes();
+
+  // 在另一个线程里释放：块进入这个线程的缓存，攒够两批就还一批给中心池，剩下的在线程退出时还回去
+  Thread consumer([&] { freeAll(kSize, &blocks); });
+  consumer.start();
+  consumer.join();
+
+  std::vector<void*> again;
+  Thread reuser([&] {
+    allocateAndVerify(kSize, &again);
+    freeAll(kSize, &again);
+  });
+  reuser.start();
+  reuser.join();
+  CHECK_EQ(SlabAllocator::reservedBytes(), reserved);
+
+  // ObjectPool创建和销毁在不同线程，构造和析构都恰好一次
+  struct Counted
+  {
+    explicit Counted(int* live) : live_(live), payload() { ++*live_; }
+    ~Counted() { --*live_; }
+    int* live_;
+    char payload[200];
+  };
+  int live = 0;
+  std::vector<Counted*> objects;
+  Thread creator([&] {
+    for (int i = 0; i < kBlocks; ++i)
+    {
+      objects.push_back(ObjectPool<Counted>::create(&live));
+    }
+  });
+  creator.start();
+  creator.join();
+  CHECK_EQ(live, kBlocks);
+  Thread destroyer([&] {
+    for (Counted* p : objects)
+    {
+      ObjectPool<Counted>::destroy(p);
+    }
+  });
+  destroyer.start();
+  destroyer.join();
+  CHECK_EQ(live, 0);
+}
+
+bool g_lateReleased = false;
+
+// 在线程缓存之前构造，所以在它之后析构：析构函数运行时t_cache已经是NULL、t_cacheDestroyed为true
+struct LateReleaser
+{
+  ~LateReleaser()
+  {
+    freeAll(size, &blocks);
+    void* p = SlabAllocator::allocate(size);
+    SlabAllocator::deallocate(p, size);
+    g_lateReleased = true;
+  }
+
+  size_t size;
+  std::vector<void*> blocks;
+};
+
+thread_local LateReleaser t_lateReleaser;
+
+void testReleaseAfterCacheDestroyed()
+{
+  // 一批146块，7批之后slab里只剩一批
+  const size_t kSize = 224;
+  Thread thread([&] {
+    LateReleaser& releaser = t_lateReleaser;
+    releaser.size = kSize;
+    // 第一次分配才构造线程缓存
+    allocateAndVerify(kSize, &releaser.blocks);
+  });
+  thread.start();
+  thread.join();
+  CHECK(g_lateReleased);
+  const size_t reserved = SlabAllocator::reservedBytes();
+
+  // 那个线程的块全部零散地挂回了中心池，这里能全部拿回来
+  std::vector<void*> again;
+  allocateAndVerify(kSize, &again);
+  freeAll(kSize, &again);
+  CHECK_EQ(SlabAllocator::reservedBytes(), reserved);
+}
+
+}  // namespace
+
+int main()
+{
+  testSizeClassBoundaries();
+  testCrossThreadFree();
+  testReleaseAfterCacheDestroyed();
+  printf("ObjectPool_test passed\n");
+}
@@ -0,0 +1,430 @@
+// base里同步原语的基准测试：
+// - MutexLock三种策略和std::mutex在1/2/4/8个线程争用时的吞吐量和加锁延迟；
+// - BlockingQueue、BoundedBlockingQueue、BoundedMPMCQueue在1/2/8/32对生产者消费者共用一个队列时的吞吐量和端到端延迟；
+// - 1/2/8/32个生产者、一个消费者时，侵入式的MpscQueue和BlockingQueue的对比；
+// - takeBatchFor攒批（最多64个、最多等200微秒）时两种阻塞队列的吞吐量和端到端延迟；
+// - DelayQueue在1/2/8个消费者时的吞吐量和出队时刻比截止时间晚了多少，以及单线程放入再取消的开销；
+// - Timestamp各个时钟源每次调用的开销；
+// - BoundedMPMCQueue快路径上唤醒检查用的屏障：seq_cst fence、AsymmetricFence的light()/heavy()各自的开销，
+//   以及单线程tryPut+tryTake一对操作的耗时；
+// - AtomicInt64在多线程争用下自增的吞吐量
+//
+// usage: Primitives_bench [--reps=N] [--iters=N] [--filter=substr] [--json=file] [--csv=file]
+
+#include "base/AsymmetricFence.h"
+#include "base/Atomic.h"
+#include "base/BlockingQueue.h"
+#include "base/BoundedBlockingQueue.h"
+#include "base/BoundedMPMCQueue.h"
+#include "base/CountDownLatch.h"
+#include "base/DelayQueue.h"
+#include "base/MpscQueue.h"
+#include "base/Mutex.h"
+#include "base/Thread.h"
+#include "base/Timestamp.h"
+#include "base/tests/Bench.h"
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+using namespace bo_net;
+using namespace bo_net::bench;
+
+namespace
+{
+
+const int kThreadCounts[] = { 1, 2, 4, 8 };
+const int kPairCounts[] = { 1, 2, 8, 32 };
+const int kQueueCapacity = 1024;
+
+// 启动n个线程执行func(线程下标, 该线程的延迟样本)，所有线程就绪之后一起开始，结束后把样本合并到samples
+void runThreads(int n, const std::function<void(int, LatencySamples*)>& func, LatencySamples* samples)
+{
+  std::vector<LatencySamples> perThread(n);
+  std::vector<std::unique_ptr<Thread> > threads;
+  CountDownLatch ready(n);
+  CountDownLatch go(1);
+  for (int i = 0; i < n; ++i)
+  {
+    LatencySamples* s = &perThread[i];
+    threads.emplace_back(new Thread([i, s, &func, &ready, &go] {
+      ready.countDown();
+      go.wait();
+      func(i, s);
+    }));
+    threads.back()->start();
+  }
+  ready.wait();
+  go.countDown();
+  for (auto& t : threads)
+  {
+    t->join();
+  }
+  for (const LatencySamples& s : perThread)
+  {
+    samples->merge(s);
+  }
+}
+
+// 临界区只是一次自增，测的几乎全是锁本身的开销；延迟是从开始加锁到解锁完成
+template<typename Lock>
+void benchLock(Runner& runner, const string& name, const std::function<Lock*()>& factory)
+{
+  for (int threads : kThreadCounts)
+  {
+    runner.run("mutex/" + name, threads, [&](LatencySamples* samples) {
+      std::unique_ptr<Lock> lock(factory());
+      int64_t counter = 0;
+      const int64_t perThread = runner.options().iterations / threads;
+      runThreads(threads, [&](int, LatencySamples* s) {
+        s->reserve(perThread);
+        for (int64_t i = 0; i < perThread; ++i)
+        {
+          if (s->shouldSample())
+          {
+            int64_t start = nowNanos();
+            lock->lock();
+            ++counter;
+            lock->unlock();
+            s->add(nowNanos() - start);
+          }
+          else
+          {
+            lock->lock();
+            ++counter;
+            lock->unlock();
+          }
+        }
+      }, samples);
+      return counter;
+    });
+  }
+}
+
+// 所有生产者和消费者共用一个队列，元素就是入队时的时间，消费者据此计算端到端延迟
+template<typename Queue>
+void benchQueue(Runner& runner, const string& name, const std::function<Queue*()>& factory)
+{
+  for (int pairs : kPairCounts)
+  {
+    runner.run("queue/" + name, pairs * 2, [&](LatencySamples* samples) {
+      std::unique_ptr<Queue> queue(factory());
+      const int64_t perThread = runner.options().iterations / pairs;
+      runThreads(pairs * 2, [&](int index, LatencySamples* s) {
+        if (index < pairs)
+        {
+          for (int64_t i = 0; i < perThread; ++i)
+          {
+            queue->put(nowNanos());
+          }
+        }
+        else
+        {
+          s->reserve(perThread);
+          for (int64_t i = 0; i < perThread; ++i)
+          {
+            int64_t enqueued = queue->take();
+            if (s->shouldSample())
+            {
+              s->add(nowNanos() - enqueued);
+            }
+          }
+        }
+      }, samples);
+      return perThread * pairs;
+    });
+  }
+}
+
+struct TimedNode : MpscNode
+{
+  int64_t enqueued;
+};
+
+// 多个生产者一个消费者，MpscQueue的节点事先分配好，入队和出队都不分配内存
+void benchMpsc(Runner& runner)
+{
+  for (int producers : kPairCounts)
+  {
+    runner.run("mpsc/MpscQueue", producers + 1, [&](LatencySamples* samples) {
+      MpscQueue<TimedNode> queue;
+      const int64_t perThread = runner.options().iterations / producers;
+      std::vector<TimedNode> nodes(perThread * producers);
+      runThreads(producers + 1, [&](int index, LatencySamples* s) {
+        if (index < producers)
+        {
+          TimedNode* mine = &nodes[index * perThread];
+          for (int64_t i = 0; i < perThread; ++i)
+          {
+            mine[i].enqueued = nowNanos();
+            queue.put(&mine[i]);
+          }
+        }
+        else
+        {
+          s->reserve(perThread * producers);
+          for (int64_t i = 0; i < perThread * producers; ++i)
+          {
+            TimedNode* node = queue.take();
+            if (s->shouldSample())
+            {
+              s->add(nowNanos() - node->enqueued);
+            }
+          }
+        }
+      }, samples);
+      return perThread * producers;
+    });
+
+    runner.run("mpsc/BlockingQueue", producers + 1, [&](LatencySamples* samples) {
+      BlockingQueue<int64_t> queue;
+      const int64_t perThread = runner.options().iterations / producers;
+      runThreads(producers + 1, [&](int index, LatencySamples* s) {
+        if (index < producers)
+        {
+          for (int64_t i = 0; i < perThread; ++i)
+          {
+            queue.put(nowNanos());
+          }
+        }
+        else
+        {
+          s->reserve(perThread * producers);
+          for (int64_t i = 0; i < perThread * producers; ++i)
+          {
+            int64_t enqueued = queue.take();
+            if (s->shouldSample())
+            {
+              s->add(nowNanos() - enqueued);
+            }
+          }
+        }
+      }, samples);
+      return perThread * producers;
+    });
+  }
+}
+
+// 生产者逐个放入，一个消费者用takeBatchFor攒批取出，延迟上界是攒批的等待时间加上排队时间
+template<typename Queue>
+void benchBatchFor(Runner& runner, const string& name, const std::function<Queue*()>& factory)
+{
+  const size_t kMaxBatch = 64;
+  const double kBatchSeconds = 200e-6;
+  for (int producers : kPairCounts)
+  {
+    runner.run("batch/" + name, producers + 1, [&](LatencySamples* samples) {
+      std::unique_ptr<Queue> queue(factory());
+      const int64_t perThread = runner.options().iterations / producers;
+      runThreads(producers + 1, [&](int index, LatencySamples* s) {
+        if (index < producers)
+        {
+          for (int64_t i = 0; i < perThread; ++i)
+          {
+            queue->put(nowNanos());
+          }
+        }
+        else
+        {
+          s->reserve(perThread * producers);
+          std::vector<int64_t> batch;
+          batch.reserve(kMaxBatch);
+          for (int64_t got = 0; got < perThread * producers; )
+          {
+            batch.clear();
+            got += static_cast<int64_t>(queue->takeBatchFor(kMaxBatch, kBatchSeconds, batch));
+            int64_t now = nowNanos();
+            for (int64_t enqueued : batch)
+            {
+              if (s->shouldSample())
+              {
+                s->add(now - enqueued);
+              }
+            }
+          }
+        }
+      }, samples);
+      return perThread * producers;
+    });
+  }
+}
+
+// 一个生产者按顺序放入截止时间分散在未来kSpreadMicros微秒内的元素，消费者take之后记录比截止时间晚了多少
+void benchDelayQueue(Runner& runner)
+{
+  const int kConsumerCounts[] = { 1, 2, 8 };
+  const int64_t kSpreadMicros = 100;
+  for (int consumers : kConsumerCounts)
+  {
+    runner.run("delay/DelayQueue", consumers + 1, [&](LatencySamples* samples) {
+      DelayQueue<int64_t> queue;
+      const int64_t perThread = runner.options().iterations / consumers;
+      runThreads(consumers + 1, [&](int index, LatencySamples* s) {
+        if (index == consumers)
+        {
+          for (int64_t i = 0; i < perThread * consumers; ++i)
+          {
+            Timestamp when(DelayQueue<int64_t>::now().microSecondsSinceEpoth() + i % kSpreadMicros);
+            queue.put(when.microSecondsSinceEpoth(), when);
+          }
+        }
+        else
+        {
+          s->reserve(perThread);
+          for (int64_t i = 0; i < perThread; ++i)
+          {
+            int64_t when = queue.take();
+            if (s->shouldSample())
+            {
+              s->add(Timestamp::nowNanos(Timestamp::kMonotonic) - when * 1000);
+            }
+          }
+        }
+      }, samples);
+      return perThread * consumers;
+    });
+  }
+
+  // 队列里常驻kResident个元素，每次放入一个新元素再取消它，延迟是一对put/cancel的耗时
+  runner.run("delay/put+cancel", 1, [&](LatencySamples* samples) {
+    const int kResident = 4096;
+    DelayQueue<int64_t> queue;
+    Timestamp base = addTime(DelayQueue<int64_t>::now(), 3600.0);
+    for (int i = 0; i < kResident; ++i)
+    {
+      queue.put(i, Timestamp(base.microSecondsSinceEpoth() + i));
+    }
+    const int64_t iterations = runner.options().iterations;
+    samples->reserve(iterations);
+    for (int64_t i = 0; i < iterations; ++i)
+    {
+      Timestamp when(base.microSecondsSinceEpoth() + (i * 7919) % kResident);
+      int64_t start = samples->shouldSample() ? nowNanos() : 0;
+      queue.cancel(queue.put(i, when));
+      if (start != 0)
+      {
+        samples->add(nowNanos() - start);
+      }
+    }
+    return iterations;
+  });
+}
+
+// 每次采样连续调用kCallsPerSample次取平均，单次调用只有几十纳秒，和读时钟本身的开销在一个量级
+void benchTimestamp(Runner& runner, const string& name, const std::function<int64_t()>& now)
+{
+  const int kCallsPerSample = 16;
+  runner.run("timestamp/" + name, 1, [&](LatencySamples* samples) {
+    const int64_t rounds = runner.options().iterations / kCallsPerSample;
+    int64_t sink = 0;
+    for (int64_t r = 0; r < rounds; ++r)
+    {
+      int64_t start = nowNanos();
+      for (int i = 0; i < kCallsPerSample; ++i)
+      {
+        sink += now();
+      }
+      samples->add((nowNanos() - start) / kCallsPerSample);
+    }
+    // 防止编译器把调用优化掉
+    if (sink == 42)
+    {
+      printf("\n");
+    }
+    return rounds * kCallsPerSample;
+  });
+}
+
+// 和benchTimestamp一样，每次采样连续执行kCallsPerSample次取平均
+void benchFence(Runner& runner, const string& name, const std::function<void()>& fence)
+{
+  const int kCallsPerSample = 16;
+  runner.run("fence/" + name, 1, [&](LatencySamples* samples) {
+    const int64_t rounds = runner.options().iterations / kCallsPerSample;
+    for (int64_t r = 0; r < rounds; ++r)
+    {
+      int64_t start = nowNanos();
+      for (int i = 0; i < kCallsPerSample; ++i)
+      {
+        fence();
+      }
+      samples->add((nowNanos() - start) / kCallsPerSample);
+    }
+    return rounds * kCallsPerSample;
+  });
+}
+
+void benchAtomic(Runner& runner, const string& name, std::memory_order order)
+{
+  for (int threads : kThreadCounts)
+  {
+    runner.run("atomic/" + name, threads, [&](LatencySamples* samples) {
+      AtomicInt64 counter;
+      const int64_t perThread = runner.options().iterations / threads;
+      runThreads(threads, [&](int, LatencySamples* s) {
+        s->reserve(perThread);
+        for (int64_t i = 0; i < perThread; ++i)
+        {
+          if (s->shouldSample())
+          {
+            int64_t start = nowNanos();
+            counter.incrementAndGet(order);
+            s->add(nowNanos() - start);
+          }
+          else
+          {
+            counter.incrementAndGet(order);
+          }
+        }
+      }, samples);
+      return counter.get();
+    });
+  }
+}
+
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+  Runner runner(Options::parse(argc, argv));
+
+  benchLock<MutexLock>(runner, "MutexLock/pthread", [] { return new MutexLock(MutexLock::kPthread); });
+  benchLock<MutexLock>(runner, "MutexLock/adaptive", [] { return new MutexLock(MutexLock::kAdaptive); });
+  benchLock<MutexLock>(runner, "MutexLock/fair", [] { return new MutexLock(MutexLock::kFair); });
+  benchLock<std::mutex>(runner, "std::mutex", [] { return new std::mutex; });
+
+  benchQueue<BlockingQueue<int64_t> >(runner, "BlockingQueue",
+      [] { return new BlockingQueue<int64_t>; });
+  benchQueue<BoundedBlockingQueue<int64_t> >(runner, "BoundedBlockingQueue",
+      [] { return new BoundedBlockingQueue<int64_t>(kQueueCapacity); });
+  benchQueue<BoundedMPMCQueue<int64_t> >(runner, "BoundedMPMCQueue",
+      [] { return new BoundedMPMCQueue<int64_t>(kQueueCapacity); });
+  benchMpsc(runner);
+  benchBatchFor<BlockingQueue<int64_t> >(runner, "BlockingQueue",
+      [] { return new BlockingQueue<int64_t>; });
+  benchBatchFor<BoundedBlockingQueue<int64_t> >(runner, "BoundedBlockingQueue",
+      [] { return new BoundedBlockingQueue<int64_t>(kQueueCapacity); });
+  benchDelayQueue(runner);
+
+  benchTimestamp(runner, "now()", [] { return Timestamp::now().microSecondsSinceEpoth(); });
+  benchTimestamp(runner, "realtime", [] { return Timestamp::nowNanos(Timestamp::kRealtime); });
+  benchTimestamp(runner, "realtime_coarse", [] { return Timestamp::nowNanos(Timestamp::kRealtimeCoarse); });
+  benchTimestamp(runner, "monotonic", [] { return Timestamp::nowNanos(Timestamp::kMonotonic); });
+  benchTimestamp(runner, "monotonic_coarse", [] { return Timestamp::nowNanos(Timestamp::kMonotonicCoarse); });
+  benchTimestamp(runner, "tsc", [] { return Timestamp::nowNanos(Timestamp::kTsc); });
+
+  detail::AsymmetricFence::init();
+  benchFence(runner, "seq_cst", [] { std::atomic_thread_fence(std::memory_order_seq_cst); });
+  benchFence(runner, "AsymmetricFence::light", [] { detail::AsymmetricFence::light(); });
+  benchFence(runner, "AsymmetricFence::heavy", [] { detail::AsymmetricFence::heavy(); });
+  BoundedMPMCQueue<int64_t> mpmc(kQueueCapacity);
+  benchFence(runner, "BoundedMPMCQueue/tryPut+tryTake", [&mpmc] {
+    int64_t x = 0;
+    mpmc.tryPut(x);
+    mpmc.tryTake(x);
+  });
+
+  benchAtomic(runner, "AtomicInt64/seq_cst", std::memory_order_seq_cst);
+  benchAtomic(runner, "AtomicInt64/relaxed", std::memory_order_relaxed);
+}
@@ -0,0 +1,86 @@
+// 比较Timestamp各个时钟源每次调用的开销和分辨率，用来决定定时器、日志、延迟测量分别用哪个时钟源
+//
+// usage: Timestamp_bench [iterations]
+
+#include "base/Timestamp.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+using namespace bo_net;
+
+namespace
+{
+
+struct Source
+{
+  Timestamp::ClockSource source;
+  const char* name;
+};
+
+const Source kSources[] = {
+  { Timestamp::kRealtime,        "realtime" },
+  { Timestamp::kRealtimeCoarse,  "realtime_coarse" },
+  { Timestamp::kMonotonic,       "monotonic" },
+  { Timestamp::kMonotonicCoarse, "monotonic_coarse" },
+  { Timestamp::kTsc,             "tsc" },
+};
+
+int64_t monotonicNanos()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+// 连续调用，统计相邻两次读数不同的次数，估算实际的分辨率
+void bench(const Source& s, int iterations)
+{
+  Timestamp::nowNanos(s.source);  // 预热，tsc在这里完成校准
+
+  int64_t changes = 0;
+  int64_t last = Timestamp::nowNanos(s.source);
+  int64_t first = last;
+  int64_t start = monotonicNanos();
+  for (int i = 0; i < iterations; ++i)
+  {
+    int64_t now = Timestamp::nowNanos(s.source);
+    if (now != last)
+    {
+      ++changes;
+      last = now;
+    }
+  }
+  int64_t elapsed = monotonicNanos() - start;
+
+  double nsPerCall = static_cast<double>(elapsed) / iterations;
+  double resolutionNs = changes > 0 ? static_cast<double>(last - first) / static_cast<double>(changes) : 0.0;
+  printf("%-18s %10.2f ns/call   observed resolution %12.1f ns\n", s.name, nsPerCall, resolutionNs);
+}
+
+// Timestamp::now()默认走gettimeofday，单独测一下
+void benchNow(int iterations)
+{
+  int64_t sum = 0;
+  int64_t start = monotonicNanos();
+  for (int i = 0; i < iterations; ++i)
+  {
+    sum += Timestamp::now().microSecondsSinceEpoth();
+  }
+  int64_t elapsed = monotonicNanos() - start;
+  printf("%-18s %10.2f ns/call   (checksum %lld)\n", "now()",
+         static_cast<double>(elapsed) / iterations, static_cast<long long>(sum & 0xff));
+}
+
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+  int iterations = argc > 1 ? atoi(argv[1]) : 10 * 1000 * 1000;
+  benchNow(iterations);
+  for (const Source& s : kSources)
+  {
+    bench(s, iterations);
+  }
+}
@@ -0,0 +1,122 @@
+// WorkStealingDeque的正确性测试：
+// - 单线程下pop是后进先出，steal是先进先出，扩容之后元素不丢失；
+// - 拥有者一边push一边pop，几个窃取者同时steal，每个元素恰好被取走一次（重点是只剩最后一个元素时的竞争）
+
+#include "base/CountDownLatch.h"
+#include "base/Thread.h"
+#include "base/WorkStealingDeque.h"
+#include "base/tests/Check.h"
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <stdio.h>
+
+using namespace bo_net;
+
+namespace
+{
+
+void testSingleThread()
+{
+  // 初始容量4，push 1000个会扩容好几次
+  WorkStealingDeque<int64_t> deque(4);
+  int64_t x = -1;
+  CHECK(!deque.pop(x));
+  CHECK(!deque.steal(x));
+
+  for (int64_t i = 0; i < 1000; ++i)
+  {
+    deque.push(i);
+  }
+  CHECK_EQ(deque.size(), 1000);
+  for (int64_t i = 0; i < 500; ++i)
+  {
+    CHECK(deque.steal(x));
+    CHECK_EQ(x, i);
+  }
+  for (int64_t i = 999; i >= 500; --i)
+  {
+    CHECK(deque.pop(x));
+    CHECK_EQ(x, i);
+  }
+  CHECK(deque.empty());
+  CHECK(!deque.pop(x));
+  CHECK(!deque.steal(x));
+}
+
+void testConcurrentSteal()
+{
+  const int kStealers = 3;
+  const int64_t kItems = 200000;
+  WorkStealingDeque<int64_t> deque(16);
+  std::unique_ptr<std::atomic<int>[]> taken(new std::atomic<int>[kItems]);
+  for (int64_t i = 0; i < kItems; ++i)
+  {
+    taken[i].store(0, std::memory_order_relaxed);
+  }
+  std::atomic<int64_t> count(0);
+  std::atomic<bool> done(false);
+  CountDownLatch ready(kStealers);
+
+  std::vector<std::unique_ptr<Thread> > stealers;
+  for (int i = 0; i < kStealers; ++i)
+  {
+    stealers.emplace_back(new Thread([&] {
+      ready.countDown();
+      int64_t x;
+      while (!done.load(std::memory_order_acquire))
+      {
+        if (deque.steal(x))
+        {
+          CHECK_EQ(taken[x].fetch_add(1), 0);
+          count.fetch_add(1);
+        }
+      }
+    }));
+    stealers.back()->start();
+  }
+  ready.wait();
+
+  // 拥有者每push几个就pop一个，deque经常只剩一两个元素，和窃取者在同一个元素上竞争
+  int64_t x;
+  for (int64_t i = 0; i < kItems; ++i)
+  {
+    deque.push(i);
+    if (i % 3 == 0 && deque.pop(x))
+    {
+      CHECK_EQ(taken[x].fetch_add(1), 0);
+      count.fetch_add(1);
+    }
+  }
+  while (deque.pop(x))
+  {
+    CHECK_EQ(taken[x].fetch_add(1), 0);
+    count.fetch_add(1);
+  }
+  // 拥有者pop失败时deque可能还剩一个元素被窃取者拿着，等它们都取完
+  while (count.load() < kItems)
+  {
+    CurrentThread::sleepUsec(1000);
+  }
+  done.store(true, std::memory_order_release);
+  for (auto& thr : stealers)
+  {
+    thr->join();
+  }
+
+  CHECK_EQ(count.load(), kItems);
+  for (int64_t i = 0; i < kItems; ++i)
+  {
+    CHECK_EQ(taken[i].load(), 1);
+  }
+}
+
+}  // namespace
+
+int main()
+{
+  testSingleThread();
+  testConcurrentSteal();
+  printf("WorkStealingDeque_test passed\n");
+}
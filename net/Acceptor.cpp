@@ -0,0 +1,128 @@
+#include "net/Acceptor.h"
+#include "net/EventLoop.h"
+#include "net/InetAddress.h"
+#include "net/SocketsOps.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+using namespace bo_net;
+using namespace bo_net::net;
+
+namespace
+{
+// 一次可读事件最多accept这么多个连接：连接建立频繁时少走几轮epoll_wait，
+// 又不至于让一个监听socket占住loop太久，饿死已经建立的连接
+const int kMaxAcceptsPerEvent = 32;
+}  // namespace
+
+Acceptor::Acceptor(EventLoop* loop, const InetAddress& listenAddr, bool reuseport)
+  : loop_(loop),
+    acceptSocket_(sockets::createNonblockingOrDie(listenAddr.family())),
+    acceptChannel_(loop, acceptSocket_.fd()),
+    listening_(false),
+    idleFd_(::open("/dev/null", O_RDONLY | O_CLOEXEC))
+{
+  assert(idleFd_ >= 0);
+  acceptSocket_.setReuseAddr(true);
+  acceptSocket_.setReusePort(reuseport);
+  acceptSocket_.bindAddress(listenAddr);
+  acceptChannel_.setReadCallback(
+      std::bind(&Acceptor::handleRead, this));
+  acceptChannel_.setAcceptQueue(&acceptedFds_);
+}
+
+Acceptor::~Acceptor()
+{
+  acceptChannel_.disableAll();
+  acceptChannel_.remove();
+  for (int connfd : acceptedFds_)
+  {
+    sockets::close(connfd);
+  }
+  ::close(idleFd_);
+}
+
+InetAddress Acceptor::localAddress() const
+{
+  return InetAddress(sockets::getLocalAddr(acceptSocket_.fd()));
+}
+
+void Acceptor::listen()
+{
+  loop_->assertInLoopThread();
+  listening_ = true;
+  acceptSocket_.listen();
+  acceptChannel_.enableReading();
+}
+
+void Acceptor::handleRead()
+{
+  loop_->assertInLoopThread();
+  InetAddress peerAddr;
+  if (!acceptedFds_.empty() || acceptChannel_.hasReceived() || acceptChannel_.isReceiving())
+  {
+    // Poller已经accept好了，只需要取对端地址
+    std::vector<int> fds;
+    fds.swap(acceptedFds_);
+    for (int connfd : fds)
+    {
+      peerAddr = InetAddress(sockets::getPeerAddr(connfd));
+      if (newConnectionCallback_)
+      {
+        newConnectionCallback_(connfd, peerAddr);
+      }
+      else
+      {
+        sockets::close(connfd);
+      }
+    }
+    ssize_t n = 0;
+    int savedErrno = 0;
+    if (acceptChannel_.takeReceived(&n, &savedErrno) && n < 0)
+    {
+      handleAcceptError(savedErrno);
+    }
+    return;
+  }
+
+  for (int i = 0; i < kMaxAcceptsPerEvent; ++i)
+  {
+    int connfd = acceptSocket_.accept(&peerAddr);
+    if (connfd >= 0)
+    {
+      if (newConnectionCallback_)
+      {
+        newConnectionCallback_(connfd, peerAddr);
+      }
+      else
+      {
+        sockets::close(connfd);
+      }
+    }
+    else
+    {
+      handleAcceptError(errno);
+      break;
+    }
+  }
+}
+
+void Acceptor::handleAcceptError(int savedErrno)
+{
+  // Read the section named "The special problem of
+  // accept()ing when you can't" in libev's doc.
+  // By Marc Lehmann, author of libev.
+  if (savedErrno == EMFILE)
+  {
+    ::close(idleFd_);
+    idleFd_ = ::accept(acceptSocket_.fd(), NULL, NULL);
+    ::close(idleFd_);
+    idleFd_ = ::open("/dev/null", O_RDONLY | O_CLOEXEC);
+    fprintf(stderr, "Acceptor::handleRead: too many open files, connection dropped\n");
+  }
+}
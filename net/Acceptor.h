@@ -0,0 +1,61 @@
+#ifndef BO_NET_NET_ACCEPTOR_H
+#define BO_NET_NET_ACCEPTOR_H
+
+#include "base/noncopyable.h"
+#include "net/Channel.h"
+#include "net/InetAddress.h"
+#include "net/Socket.h"
+
+#include <functional>
+#include <vector>
+
+namespace bo_net
+{
+
+namespace net
+{
+
+class EventLoop;
+
+// Acceptor of incoming TCP connections.
+// 构造时就完成socket、bind，端口被占用时立即abort；listen()必须在loop所在的线程调用。
+// io_uring后端支持multishot accept时由Poller完成accept，新连接的fd放进acceptedFds_
+class Acceptor : noncopyable
+{
+    public:
+        typedef std::function<void (int sockfd, const InetAddress&)> NewConnectionCallback;
+
+        Acceptor(EventLoop *loop, const InetAddress &listenAddr, bool reuseport);
+        ~Acceptor();
+
+        void setNewConnectionCallback(const NewConnectionCallback &cb) {
+            newConnectionCallback_ = cb;
+        }
+
+        void listen();
+
+        bool listening() const { return listening_; }
+
+        EventLoop* getLoop() const { return loop_; }
+
+        // 监听socket实际绑定的地址，bind到0号端口时可以从这里拿到内核分配的端口
+        InetAddress localAddress() const;
+
+    private:
+        void handleRead();
+        void handleAcceptError(int savedErrno);
+
+        EventLoop *loop_;
+        Socket     acceptSocket_;
+        Channel    acceptChannel_;
+        NewConnectionCallback newConnectionCallback_;
+        bool       listening_;
+        int        idleFd_;
+        std::vector<int> acceptedFds_;
+};
+
+} // namespace net
+
+} // namespace bo_net
+
+#endif // BO_NET_NET_ACCEPTOR_H
@@ -0,0 +1,42 @@
+#include "net/Buffer.h"
+
+#include <errno.h>
+#include <sys/uio.h>
+
+using namespace bo_net;
+using namespace bo_net::net;
+
+const char Buffer::kCRLF[] = "\r\n";
+
+const size_t Buffer::kCheapPrepend;
+const size_t Buffer::kInitialSize;
+
+ssize_t Buffer::readFd(int fd, int* savedErrno)
+{
+  // 栈上的临时空间：Buffer剩余空间不够时，多出来的数据先读到这里，再append进Buffer。
+  // 这样每个连接的Buffer不需要预先开得很大，一次readv又能读到足够多的数据
+  char extrabuf[65536];
+  struct iovec vec[2];
+  const size_t writable = writableBytes();
+  vec[0].iov_base = begin() + writerIndex_;
+  vec[0].iov_len = writable;
+  vec[1].iov_base = extrabuf;
+  vec[1].iov_len = sizeof extrabuf;
+  // Buffer本身的空间已经不小于extrabuf时就不必再用它了，最多读writable字节
+  const int iovcnt = (writable < sizeof extrabuf) ? 2 : 1;
+  const ssize_t n = ::readv(fd, vec, iovcnt);
+  if (n < 0)
+  {
+    *savedErrno = errno;
+  }
+  else if (static_cast<size_t>(n) <= writable)
+  {
+    writerIndex_ += n;
+  }
+  else
+  {
+    writerIndex_ = buffer_.size();
+    append(extrabuf, n - writable);
+  }
+  return n;
+}
@@ -0,0 +1,339 @@
+#ifndef BO_NET_NET_BUFFER_H
+#define BO_NET_NET_BUFFER_H
+
+#include "base/Types.h"
+#include "base/copyable.h"
+#include "net/Endian.h"
+
+#include <algorithm>
+#include <string_view>
+#include <vector>
+#include <assert.h>
+#include <string.h>
+
+namespace bo_net
+{
+
+namespace net
+{
+
+/// 参考muduo的Buffer，底层是一块连续的内存：
+///
+/// +-------------------+------------------+------------------+
+/// | prependable bytes |  readable bytes  |  writable bytes  |
+/// |                   |     (CONTENT)    |                  |
+/// +-------------------+------------------+------------------+
+/// |                   |                  |                  |
+/// 0      <=      readerIndex   <=   writerIndex    <=     size
+///
+/// 前面预留kCheapPrepend字节，协议编码时可以在消息写完之后再把长度头prepend到前面，不需要移动消息体。
+/// 读写位置用下标而不是指针表示，vector扩容之后依然有效。
+///
+/// 每个连接有输入输出两个Buffer，空闲连接多的时候内存主要花在这里，所以初始容量只有1KB；
+/// readFd()借助栈上的64KB临时空间一次读空socket，Buffer只按实际收到的数据量增长，
+/// 突发流量过后可以调用shrink()把容量收缩回来
+class Buffer : public bo_net::copyable
+{
+    public:
+        static const size_t kCheapPrepend = 8;
+        static const size_t kInitialSize = 1024;
+
+        explicit Buffer(size_t initialSize = kInitialSize)
+            : buffer_(kCheapPrepend + initialSize),
+              readerIndex_(kCheapPrepend),
+              writerIndex_(kCheapPrepend)
+        {
+            assert(readableBytes() == 0);
+            assert(writableBytes() == initialSize);
+            assert(prependableBytes() == kCheapPrepend);
+        }
+
+        // 使用编译器生成的拷贝构造、赋值和析构函数
+
+        void swap(Buffer &rhs) {
+            buffer_.swap(rhs.buffer_);
+            std::swap(readerIndex_, rhs.readerIndex_);
+            std::swap(writerIndex_, rhs.writerIndex_);
+        }
+
+        size_t readableBytes() const {
+            return writerIndex_ - readerIndex_;
+        }
+
+        size_t writableBytes() const {
+            return buffer_.size() - writerIndex_;
+        }
+
+        size_t prependableBytes() const {
+            return readerIndex_;
+        }
+
+        const char* peek() const {
+            return begin() + readerIndex_;
+        }
+
+        const char* findCRLF() const {
+            return findCRLF(peek());
+        }
+
+        const char* findCRLF(const char *start) const {
+            assert(peek() <= start);
+            assert(start <= beginWrite());
+            const char *crlf = std::search(start, beginWrite(), kCRLF, kCRLF + 2);
+            return crlf == beginWrite() ? NULL : crlf;
+        }
+
+        const char* findEOL() const {
+            return findEOL(peek());
+        }
+
+        const char* findEOL(const char *start) const {
+            assert(peek() <= start);
+            assert(start <= beginWrite());
+            const void *eol = memchr(start, '\n', beginWrite() - start);
+            return static_cast<const char*>(eol);
+        }
+
+        // retrieve只移动读下标，不搬移数据，也不释放内存
+        void retrieve(size_t len) {
+            assert(len <= readableBytes());
+            if(len < readableBytes()) {
+                readerIndex_ += len;
+            }
+            else {
+                retrieveAll();
+            }
+        }
+
+        void retrieveUntil(const char *end) {
+            assert(peek() <= end);
+            assert(end <= beginWrite());
+            retrieve(end - peek());
+        }
+
+        void retrieveInt64() {
+            retrieve(sizeof(int64_t));
+        }
+
+        void retrieveInt32() {
+            retrieve(sizeof(int32_t));
+        }
+
+        void retrieveInt16() {
+            retrieve(sizeof(int16_t));
+        }
+
+        void retrieveInt8() {
+            retrieve(sizeof(int8_t));
+        }
+
+        // 数据全部取走之后两个下标回到起点，下次写入可以重新使用整块空间
+        void retrieveAll() {
+            readerIndex_ = kCheapPrepend;
+            writerIndex_ = kCheapPrepend;
+        }
+
+        string retrieveAllAsString() {
+            return retrieveAsString(readableBytes());
+        }
+
+        string retrieveAsString(size_t len) {
+            assert(len <= readableBytes());
+            string result(peek(), len);
+            retrieve(len);
+            return result;
+        }
+
+        std::string_view toStringView() const {
+            return std::string_view(peek(), readableBytes());
+        }
+
+        void append(std::string_view str) {
+            append(str.data(), str.size());
+        }
+
+        void append(const char *data, size_t len) {
+            ensureWritableBytes(len);
+            std::copy(data, data + len, beginWrite());
+            hasWritten(len);
+        }
+
+        void append(const void *data, size_t len) {
+            append(static_cast<const char*>(data), len);
+        }
+
+        void ensureWritableBytes(size_t len) {
+            if(writableBytes() < len) {
+                makeSpace(len);
+            }
+            assert(writableBytes() >= len);
+        }
+
+        char* beginWrite() {
+            return begin() + writerIndex_;
+        }
+
+        const char* beginWrite() const {
+            return begin() + writerIndex_;
+        }
+
+        void hasWritten(size_t len) {
+            assert(len <= writableBytes());
+            writerIndex_ += len;
+        }
+
+        void unwrite(size_t len) {
+            assert(len <= readableBytes());
+            writerIndex_ -= len;
+        }
+
+        // 以网络字节序追加整数
+        void appendInt64(int64_t x) {
+            int64_t be64 = sockets::hostToNetwork64(x);
+            append(&be64, sizeof be64);
+        }
+
+        void appendInt32(int32_t x) {
+            int32_t be32 = sockets::hostToNetwork32(x);
+            append(&be32, sizeof be32);
+        }
+
+        void appendInt16(int16_t x) {
+            int16_t be16 = sockets::hostToNetwork16(x);
+            append(&be16, sizeof be16);
+        }
+
+        void appendInt8(int8_t x) {
+            append(&x, sizeof x);
+        }
+
+        // 读出并取走一个网络字节序的整数，要求readableBytes() >= sizeof(intN_t)
+        int64_t readInt64() {
+            int64_t result = peekInt64();
+            retrieveInt64();
+            return result;
+        }
+
+        int32_t readInt32() {
+            int32_t result = peekInt32();
+            retrieveInt32();
+            return result;
+        }
+
+        int16_t readInt16() {
+            int16_t result = peekInt16();
+            retrieveInt16();
+            return result;
+        }
+
+        int8_t readInt8() {
+            int8_t result = peekInt8();
+            retrieveInt8();
+            return result;
+        }
+
+        int64_t peekInt64() const {
+            assert(readableBytes() >= sizeof(int64_t));
+            int64_t be64 = 0;
+            ::memcpy(&be64, peek(), sizeof be64);
+            return sockets::networkToHost64(be64);
+        }
+
+        int32_t peekInt32() const {
+            assert(readableBytes() >= sizeof(int32_t));
+            int32_t be32 = 0;
+            ::memcpy(&be32, peek(), sizeof be32);
+            return sockets::networkToHost32(be32);
+        }
+
+        int16_t peekInt16() const {
+            assert(readableBytes() >= sizeof(int16_t));
+            int16_t be16 = 0;
+            ::memcpy(&be16, peek(), sizeof be16);
+            return sockets::networkToHost16(be16);
+        }
+
+        int8_t peekInt8() const {
+            assert(readableBytes() >= sizeof(int8_t));
+            int8_t x = *peek();
+            return x;
+        }
+
+        // 在可读数据前面插入，用于消息编码完成之后补写长度头
+        void prependInt64(int64_t x) {
+            int64_t be64 = sockets::hostToNetwork64(x);
+            prepend(&be64, sizeof be64);
+        }
+
+        void prependInt32(int32_t x) {
+            int32_t be32 = sockets::hostToNetwork32(x);
+            prepend(&be32, sizeof be32);
+        }
+
+        void prependInt16(int16_t x) {
+            int16_t be16 = sockets::hostToNetwork16(x);
+            prepend(&be16, sizeof be16);
+        }
+
+        void prependInt8(int8_t x) {
+            prepend(&x, sizeof x);
+        }
+
+        void prepend(const void *data, size_t len) {
+            assert(len <= prependableBytes());
+            readerIndex_ -= len;
+            const char *d = static_cast<const char*>(data);
+            std::copy(d, d + len, begin() + readerIndex_);
+        }
+
+        // 把容量收缩到刚好容纳现有数据再加reserve字节，用于突发流量之后归还内存
+        void shrink(size_t reserve) {
+            Buffer other(readableBytes() + reserve);
+            other.append(toStringView());
+            swap(other);
+        }
+
+        size_t internalCapacity() const {
+            return buffer_.capacity();
+        }
+
+        // 直接从fd读数据到Buffer中，返回read的结果，出错时savedErrno保存errno
+        ssize_t readFd(int fd, int *savedErrno);
+
+    private:
+        char* begin() {
+            return &*buffer_.begin();
+        }
+
+        const char* begin() const {
+            return &*buffer_.begin();
+        }
+
+        void makeSpace(size_t len) {
+            if(writableBytes() + prependableBytes() < len + kCheapPrepend) {
+                // 总的空闲空间也不够，只能扩容
+                buffer_.resize(writerIndex_ + len);
+            }
+            else {
+                // 把可读数据搬到前面，复用已经被retrieve掉的空间
+                assert(kCheapPrepend < readerIndex_);
+                size_t readable = readableBytes();
+                std::copy(begin() + readerIndex_, begin() + writerIndex_, begin() + kCheapPrepend);
+                readerIndex_ = kCheapPrepend;
+                writerIndex_ = readerIndex_ + readable;
+                assert(readable == readableBytes());
+            }
+        }
+
+        std::vector<char> buffer_;
+        size_t readerIndex_;
+        size_t writerIndex_;
+
+        static const char kCRLF[];
+};
+
+} // namespace net
+
+} // namespace bo_net
+
+#endif // BO_NET_NET_BUFFER_H
@@ -0,0 +1,41 @@
+#ifndef BO_NET_NET_CALLBACKS_H
+#define BO_NET_NET_CALLBACKS_H
+
+#include "base/Timestamp.h"
+
+#include <functional>
+#include <memory>
+
+namespace bo_net
+{
+
+namespace net
+{
+
+// All client visible callbacks go here.
+
+class Buffer;
+class TcpConnection;
+typedef std::shared_ptr<TcpConnection> TcpConnectionPtr;
+typedef std::function<void()> TimerCallback;
+typedef std::function<void (const TcpConnectionPtr&)> ConnectionCallback;
+typedef std::function<void (const TcpConnectionPtr&)> CloseCallback;
+typedef std::function<void (const TcpConnectionPtr&)> WriteCompleteCallback;
+typedef std::function<void (const TcpConnectionPtr&, size_t)> HighWaterMarkCallback;
+typedef std::function<void (const TcpConnectionPtr&, size_t)> LowWaterMarkCallback;
+
+// the data has been read to (buf, len)
+typedef std::function<void (const TcpConnectionPtr&,
+                            Buffer*,
+                            Timestamp)> MessageCallback;
+
+void defaultConnectionCallback(const TcpConnectionPtr &conn);
+void defaultMessageCallback(const TcpConnectionPtr &conn,
+                            Buffer *buffer,
+                            Timestamp receiveTime);
+
+} // namespace net
+
+} // namespace bo_net
+
+#endif // BO_NET_NET_CALLBACKS_H
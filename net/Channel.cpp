@@ -0,0 +1,167 @@
+#include "net/Channel.h"
+#include "net/EventLoop.h"
+
+#include <assert.h>
+#include <poll.h>
+#include <stdio.h>
+#include <sys/epoll.h>
+
+using namespace bo_net;
+using namespace bo_net::net;
+
+// poll和epoll的事件位取值相同，Channel里直接使用，交给Poller时不需要转换
+static_assert(EPOLLIN == POLLIN && EPOLLPRI == POLLPRI && EPOLLOUT == POLLOUT &&
+              EPOLLRDHUP == POLLRDHUP && EPOLLERR == POLLERR && EPOLLHUP == POLLHUP,
+              "epoll uses same flag values as poll");
+
+const int Channel::kNoneEvent = 0;
+const int Channel::kReadEvent = POLLIN | POLLPRI;
+const int Channel::kWriteEvent = POLLOUT;
+const int Channel::kEdgeTriggered = EPOLLET;
+
+Channel::Channel(EventLoop* loop, int fd__)
+  : loop_(loop),
+    fd_(fd__),
+    events_(0),
+    revents_(0),
+    index_(-1),
+    addedToLoop_(false),
+    eventHandling_(false),
+    recvBuffer_(NULL),
+    acceptQueue_(NULL),
+    receivedBytes_(0),
+    receivedErrno_(0),
+    receivedEof_(false),
+    receiving_(false),
+    tied_(false)
+{
+}
+
+Channel::~Channel()
+{
+  assert(!eventHandling_);
+  assert(!addedToLoop_);
+  if (loop_->isInLoopThread())
+  {
+    assert(!loop_->hasChannel(this));
+  }
+}
+
+void Channel::tie(const std::shared_ptr<void>& obj)
+{
+  tie_ = obj;
+  tied_ = true;
+}
+
+void Channel::setEdgeTriggered(bool on)
+{
+  int events = on ? (events_ | kEdgeTriggered) : (events_ & ~kEdgeTriggered);
+  if (events != events_)
+  {
+    events_ = events;
+    if (addedToLoop_)
+    {
+      update();
+    }
+  }
+}
+
+void Channel::addReceived(ssize_t n)
+{
+  if (n > 0)
+  {
+    receivedBytes_ += static_cast<size_t>(n);
+  }
+  else if (n == 0)
+  {
+    receivedEof_ = true;
+  }
+  else
+  {
+    receivedErrno_ = static_cast<int>(-n);
+  }
+}
+
+bool Channel::takeReceived(ssize_t* n, int* savedErrno)
+{
+  // 先交出数据，再交出关闭或错误，和自己read()看到的顺序一致
+  if (receivedBytes_ > 0)
+  {
+    *n = static_cast<ssize_t>(receivedBytes_);
+    receivedBytes_ = 0;
+    return true;
+  }
+  if (receivedEof_)
+  {
+    receivedEof_ = false;
+    *n = 0;
+    return true;
+  }
+  if (receivedErrno_ != 0)
+  {
+    *savedErrno = receivedErrno_;
+    receivedErrno_ = 0;
+    *n = -1;
+    return true;
+  }
+  return false;
+}
+
+void Channel::update()
+{
+  addedToLoop_ = true;
+  loop_->updateChannel(this);
+}
+
+void Channel::remove()
+{
+  assert(isNoneEvent());
+  addedToLoop_ = false;
+  loop_->removeChannel(this);
+}
+
+void Channel::handleEvent(Timestamp receiveTime)
+{
+  std::shared_ptr<void> guard;
+  if (tied_)
+  {
+    guard = tie_.lock();
+    if (guard)
+    {
+      handleEventWithGuard(receiveTime);
+    }
+  }
+  else
+  {
+    handleEventWithGuard(receiveTime);
+  }
+}
+
+void Channel::handleEventWithGuard(Timestamp receiveTime)
+{
+  eventHandling_ = true;
+  if (revents_ & POLLNVAL)
+  {
+    fprintf(stderr, "Channel::handleEvent() fd = %d POLLNVAL\n", fd_);
+  }
+
+  // 对端关闭且没有数据可读了才算关闭，还有数据时先交给读回调，读到0再处理
+  if ((revents_ & POLLHUP) && !(revents_ & POLLIN))
+  {
+    if (closeCallback_) closeCallback_();
+  }
+
+  if (revents_ & (POLLERR | POLLNVAL))
+  {
+    if (errorCallback_) errorCallback_();
+  }
+  if (revents_ & (POLLIN | POLLPRI | POLLRDHUP))
+  {
+    if (readCallback_) readCallback_(receiveTime);
+  }
+  if (revents_ & POLLOUT)
+  {
+    if (writeCallback_) writeCallback_();
+  }
+  eventHandling_ = false;
+}
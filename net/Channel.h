@@ -0,0 +1,139 @@
+#ifndef BO_NET_NET_CHANNEL_H
+#define BO_NET_NET_CHANNEL_H
+
+#include "base/ObjectPool.h"
+#include "base/Timestamp.h"
+#include "base/noncopyable.h"
+
+#include <functional>
+#include <memory>
+#include <vector>
+#include <sys/types.h>
+
+namespace bo_net
+{
+
+namespace net
+{
+
+class Buffer;
+class EventLoop;
+
+// Channel把一个fd关心的事件和对应的回调绑在一起，它不拥有fd，析构时也不会关闭fd。
+// 每个Channel只属于一个EventLoop，所有成员函数都只能在该EventLoop所在的线程调用
+//
+// 默认是水平触发；setEdgeTriggered(true)之后该fd以边沿触发方式注册，回调必须一直读/写到EAGAIN为止，
+// 换来的是数据没有读完时不会在每一轮poll都被重复通知。
+// 每个连接一个Channel，随连接一起创建和销毁，所以从SlabAllocator分配
+class Channel : noncopyable, public PoolAllocated
+{
+    public:
+        typedef std::function<void()> EventCallback;
+        typedef std::function<void(Timestamp)> ReadEventCallback;
+
+        Channel(EventLoop *loop, int fd);
+        ~Channel();
+
+        // receiveTime是poll返回的时刻，同一轮的所有事件共用这一个值
+        void handleEvent(Timestamp receiveTime);
+
+        void setReadCallback(ReadEventCallback cb) {
+            readCallback_ = std::move(cb);
+        }
+
+        void setWriteCallback(EventCallback cb) {
+            writeCallback_ = std::move(cb);
+        }
+
+        void setCloseCallback(EventCallback cb) {
+            closeCallback_ = std::move(cb);
+        }
+
+        void setErrorCallback(EventCallback cb) {
+            errorCallback_ = std::move(cb);
+        }
+
+        // 把Channel和它的owner对象（通常是TcpConnection）绑定，handleEvent期间持有owner的强引用，
+        // 避免owner在回调执行到一半时被析构
+        void tie(const std::shared_ptr<void> &obj);
+
+        int fd() const { return fd_; }
+        int events() const { return events_; }
+        int revents() const { return revents_; }
+        void set_revents(int revt) { revents_ = revt; } // used by pollers
+        bool isNoneEvent() const { return (events_ & ~kEdgeTriggered) == kNoneEvent; }
+
+        void enableReading() { events_ |= kReadEvent; update(); }
+        void disableReading() { events_ &= ~kReadEvent; update(); }
+        void enableWriting() { events_ |= kWriteEvent; update(); }
+        void disableWriting() { events_ &= ~kWriteEvent; update(); }
+        void disableAll() { events_ &= kEdgeTriggered; update(); }
+        bool isWriting() const { return events_ & kWriteEvent; }
+        bool isReading() const { return events_ & kReadEvent; }
+
+        // 切换边沿/水平触发，已经注册到Poller中的fd会立即用新模式重新注册
+        void setEdgeTriggered(bool on);
+        bool isEdgeTriggered() const { return events_ & kEdgeTriggered; }
+
+        // 允许Poller在收到数据时直接追加到buf（io_uring后端的multishot recv），
+        // 读回调先用takeReceived()取走Poller代收的结果，没有代收时才自己读fd
+        void setRecvBuffer(Buffer *buf) { recvBuffer_ = buf; }
+        Buffer* recvBuffer() const { return recvBuffer_; }
+        // 依次返回代收的字节数、对端关闭(*n == 0)、错误(*n < 0，errno在*savedErrno里)，没有了返回false
+        bool takeReceived(ssize_t *n, int *savedErrno);
+        bool hasReceived() const { return receivedBytes_ > 0 || receivedEof_ || receivedErrno_ != 0; }
+        // 监听socket：允许Poller直接accept（io_uring后端的multishot accept），新连接的fd放进fds，
+        // accept出错时errno由takeReceived()交出
+        void setAcceptQueue(std::vector<int> *fds) { acceptQueue_ = fds; }
+        std::vector<int>* acceptQueue() const { return acceptQueue_; }
+
+        // for Poller
+        int index() const { return index_; }
+        void set_index(int idx) { index_ = idx; }
+        // n > 0是追加到recvBuffer()的字节数，0是对端关闭，< 0是-errno
+        void addReceived(ssize_t n);
+        // 内核里有替本Channel读数据的recv请求，这时读回调不能再自己读fd，否则会和还没取走的数据乱序
+        void setReceiving(bool on) { receiving_ = on; }
+        bool isReceiving() const { return receiving_; }
+
+        EventLoop* ownerLoop() { return loop_; }
+        void remove();
+
+    private:
+        void update();
+        void handleEventWithGuard(Timestamp receiveTime);
+
+        static const int kNoneEvent;
+        static const int kReadEvent;
+        static const int kWriteEvent;
+        static const int kEdgeTriggered;
+
+        EventLoop *loop_;
+        const int  fd_;
+        int        events_;
+        int        revents_;    // 本轮poll返回的事件
+        int        index_;      // 由Poller使用，EPollPoller中表示是否已经注册
+        bool       addedToLoop_;
+        bool       eventHandling_;
+
+        Buffer    *recvBuffer_;
+        std::vector<int> *acceptQueue_;
+        size_t     receivedBytes_;  // Poller代收、还没有被takeReceived()取走的字节数
+        int        receivedErrno_;
+        bool       receivedEof_;
+        bool       receiving_;
+
+        std::weak_ptr<void> tie_;
+        bool tied_;
+
+        ReadEventCallback readCallback_;
+        EventCallback     writeCallback_;
+        EventCallback     closeCallback_;
+        EventCallback     errorCallback_;
+};
+
+} // namespace net
+
+} // namespace bo_net
+
+#endif // BO_NET_NET_CHANNEL_H
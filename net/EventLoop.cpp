@@ -0,0 +1,321 @@
+#include "net/EventLoop.h"
+#include "base/ObjectPool.h"
+#include "net/Channel.h"
+#include "net/Poller.h"
+#include "net/TimerQueue.h"
+
+#include <algorithm>
+#include <assert.h>
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+using namespace bo_net;
+using namespace bo_net::net;
+
+namespace
+{
+__thread EventLoop* t_loopInThisThread = 0;
+
+const int kPollTimeMs = 10000;
+
+// queueInLoop把Functor包装成LoopTask，执行完或者被丢弃时释放自己
+class FunctorTask final : public LoopTask, public PoolAllocated
+{
+ public:
+  explicit FunctorTask(EventLoop::Functor cb)
+    : cb_(std::move(cb))
+  {
+  }
+
+  void run() override
+  {
+    cb_();
+    delete this;
+  }
+
+  void discard() override
+  {
+    delete this;
+  }
+
+ private:
+  EventLoop::Functor cb_;
+};
+
+int createEventfd()
+{
+  int evtfd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (evtfd < 0)
+  {
+    fprintf(stderr, "Failed in eventfd: %s\n", strerror(errno));
+    abort();
+  }
+  return evtfd;
+}
+
+// 对端已经关闭的连接上写数据会收到SIGPIPE，默认动作是终止进程，网络程序需要忽略它
+class IgnoreSigPipe
+{
+ public:
+  IgnoreSigPipe()
+  {
+    ::signal(SIGPIPE, SIG_IGN);
+  }
+};
+
+IgnoreSigPipe initObj;
+}  // namespace
+
+EventLoop* EventLoop::getEventLoopOfCurrentThread()
+{
+  return t_loopInThisThread;
+}
+
+EventLoop::EventLoop()
+  : EventLoop(Poller::defaultBackend())
+{
+}
+
+EventLoop::EventLoop(PollerBackend backend)
+  : looping_(false),
+    quit_(false),
+    eventHandling_(false),
+    callingPendingFunctors_(false),
+    iteration_(0),
+    threadId_(CurrentThread::tid()),
+    pollerBackend_(backend),
+    poller_(Poller::newPoller(this, &pollerBackend_)),
+    timerQueue_(new TimerQueue(this)),
+    wakeupFd_(createEventfd()),
+    wakeupChannel_(new Channel(this, wakeupFd_)),
+    wakeupPending_(false),
+    currentActiveChannel_(NULL),
+    pendingCount_(0)
+{
+  if (t_loopInThisThread)
+  {
+    fprintf(stderr, "Another EventLoop %p exists in this thread %d\n",
+            static_cast<void*>(t_loopInThisThread), threadId_);
+    abort();
+  }
+  else
+  {
+    t_loopInThisThread = this;
+  }
+  wakeupChannel_->setReadCallback(std::bind(&EventLoop::handleRead, this));
+  // we are always reading the wakeupfd
+  wakeupChannel_->enableReading();
+}
+
+EventLoop::~EventLoop()
+{
+  wakeupChannel_->disableAll();
+  wakeupChannel_->remove();
+  ::close(wakeupFd_);
+  while (LoopTask* task = pendingTasks_.tryPop())
+  {
+    task->discard();
+  }
+  t_loopInThisThread = NULL;
+}
+
+void EventLoop::loop()
+{
+  assert(!looping_);
+  assertInLoopThread();
+  looping_ = true;
+  quit_ = false;  // FIXME: what if someone calls quit() before loop() ?
+
+  while (!quit_)
+  {
+    activeChannels_.clear();
+    pollReturnTime_ = poller_->poll(kPollTimeMs, &activeChannels_);
+    ++iteration_;
+    eventHandling_ = true;
+    for (Channel* channel : activeChannels_)
+    {
+      currentActiveChannel_ = channel;
+      currentActiveChannel_->handleEvent(pollReturnTime_);
+    }
+    currentActiveChannel_ = NULL;
+    eventHandling_ = false;
+    doPendingFunctors();
+  }
+
+  looping_ = false;
+}
+
+void EventLoop::quit()
+{
+  quit_ = true;
+  // There is a chance that loop() just executes while(!quit_) and exits,
+  // then EventLoop destructs, then we are accessing an invalid object.
+  if (!isInLoopThread())
+  {
+    wakeup();
+  }
+}
+
+void EventLoop::runInLoop(Functor cb)
+{
+  if (isInLoopThread())
+  {
+    cb();
+  }
+  else
+  {
+    queueInLoop(std::move(cb));
+  }
+}
+
+void EventLoop::queueInLoop(Functor cb)
+{
+  post(new FunctorTask(std::move(cb)));
+}
+
+void EventLoop::post(LoopTask* task)
+{
+  // 先计数再入队，doPendingFunctors按计数取任务时不会多取
+  pendingCount_.fetch_add(1, std::memory_order_relaxed);
+  pendingTasks_.push(task);
+
+  // IO线程正在处理事件时，本轮结束后自然会执行doPendingFunctors，不需要唤醒；
+  // 正在执行doPendingFunctors时新加的任务要等下一轮，必须唤醒，否则会阻塞在poll上
+  if (!isInLoopThread() || callingPendingFunctors_)
+  {
+    if (!wakeupPending_.exchange(true))
+    {
+      wakeup();
+    }
+  }
+}
+
+TimerId EventLoop::runAt(Timestamp time, TimerCallback cb)
+{
+  return timerQueue_->addTimer(std::move(cb), time, 0.0);
+}
+
+TimerId EventLoop::runAfter(double delay, TimerCallback cb)
+{
+  Timestamp time(addTime(Timestamp::now(), delay));
+  return runAt(time, std::move(cb));
+}
+
+TimerId EventLoop::runEvery(double interval, TimerCallback cb)
+{
+  Timestamp time(addTime(Timestamp::now(), interval));
+  return timerQueue_->addTimer(std::move(cb), time, interval);
+}
+
+TimerId EventLoop::runAtCoarse(Timestamp time, TimerCallback cb)
+{
+  return timerQueue_->addCoarseTimer(std::move(cb), time, 0.0);
+}
+
+TimerId EventLoop::runAfterCoarse(double delay, TimerCallback cb)
+{
+  Timestamp time(addTime(Timestamp::now(), delay));
+  return runAtCoarse(time, std::move(cb));
+}
+
+TimerId EventLoop::runEveryCoarse(double interval, TimerCallback cb)
+{
+  Timestamp time(addTime(Timestamp::now(), interval));
+  return timerQueue_->addCoarseTimer(std::move(cb), time, interval);
+}
+
+void EventLoop::refresh(TimerId timerId, Timestamp time)
+{
+  timerQueue_->refresh(timerId, time);
+}
+
+void EventLoop::cancel(TimerId timerId)
+{
+  timerQueue_->cancel(timerId);
+}
+
+void EventLoop::updateChannel(Channel* channel)
+{
+  assert(channel->ownerLoop() == this);
+  assertInLoopThread();
+  poller_->updateChannel(channel);
+}
+
+void EventLoop::removeChannel(Channel* channel)
+{
+  assert(channel->ownerLoop() == this);
+  assertInLoopThread();
+  if (eventHandling_)
+  {
+    assert(currentActiveChannel_ == channel ||
+        std::find(activeChannels_.begin(), activeChannels_.end(), channel) == activeChannels_.end());
+  }
+  poller_->removeChannel(channel);
+}
+
+bool EventLoop::hasChannel(Channel* channel)
+{
+  assert(channel->ownerLoop() == this);
+  assertInLoopThread();
+  return poller_->hasChannel(channel);
+}
+
+void EventLoop::abortNotInLoopThread()
+{
+  fprintf(stderr, "EventLoop::abortNotInLoopThread - EventLoop %p was created in threadId_ = %d, current thread id = %d\n",
+          static_cast<void*>(this), threadId_, CurrentThread::tid());
+  abort();
+}
+
+void EventLoop::wakeup()
+{
+  uint64_t one = 1;
+  ssize_t n = ::write(wakeupFd_, &one, sizeof one);
+  if (n != sizeof one)
+  {
+    fprintf(stderr, "EventLoop::wakeup() writes %zd bytes instead of 8\n", n);
+  }
+}
+
+void EventLoop::handleRead()
+{
+  uint64_t one = 1;
+  ssize_t n = ::read(wakeupFd_, &one, sizeof one);
+  if (n != sizeof one)
+  {
+    fprintf(stderr, "EventLoop::handleRead() reads %zd bytes instead of 8\n", n);
+  }
+}
+
+void EventLoop::doPendingFunctors()
+{
+  callingPendingFunctors_ = true;
+
+  // 必须在取任务之前清除标志：清除之后才入队的任务一定会重新触发wakeup，
+  // 清除之前看到标志为true而没有wakeup的任务，一定已经挂在队列上，会被下面取走。
+  // 用exchange而不是store，读到生产者写入的true，保证能看到它在此之前挂上队列的节点
+  wakeupPending_.exchange(false);
+
+  // 只执行开始时已经在队列里的任务，执行过程中新投递的任务都会wakeup，留到下一轮，
+  // 其他线程不停地投递也不会让IO线程一直回不到poll。
+  // tryPop返回NULL说明某个生产者正在入队的中途，它入队之后会再wakeup，这里直接结束
+  size_t n = pendingCount_.load(std::memory_order_acquire);
+  size_t done = 0;
+  while (done < n)
+  {
+    LoopTask* task = pendingTasks_.tryPop();
+    if (task == NULL)
+    {
+      break;
+    }
+    ++done;
+    task->run();
+  }
+  pendingCount_.fetch_sub(done, std::memory_order_relaxed);
+  callingPendingFunctors_ = false;
+}
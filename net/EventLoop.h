@@ -0,0 +1,165 @@
+#ifndef BO_NET_NET_EVENTLOOP_H
+#define BO_NET_NET_EVENTLOOP_H
+
+#include "base/CurrentThread.h"
+#include "base/MpscQueue.h"
+#include "base/Timestamp.h"
+#include "base/noncopyable.h"
+#include "net/Callbacks.h"
+#include "net/TimerId.h"
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace bo_net
+{
+
+namespace net
+{
+
+class Channel;
+class Poller;
+class TimerQueue;
+
+// 投递给EventLoop执行的侵入式任务：队列节点嵌在任务对象里，EventLoop::post()不分配内存也不加锁。
+// 任务由投递者拥有，从post()开始到run()返回之前必须保持有效，并且不能重复投递；
+// run()返回之后任务就和EventLoop无关了，可以在run()里delete this，或者再次投递自己
+class LoopTask : public MpscNode
+{
+    public:
+        virtual void run() = 0;
+
+        // EventLoop析构时队列里还没有执行的任务会被调用discard()，默认什么也不做
+        virtual void discard() {}
+
+    protected:
+        ~LoopTask() {}
+};
+
+// Reactor，one loop per thread：创建EventLoop的线程就是它的IO线程，loop()必须在这个线程中调用。
+// 其他线程只能通过runInLoop/queueInLoop把任务转交给IO线程执行
+class EventLoop : noncopyable
+{
+    public:
+        typedef std::function<void()> Functor;
+
+        // IO多路复用的后端。kIoUring在内核不支持时自动退回到epoll，pollerBackend()返回实际使用的后端
+        enum PollerBackend
+        {
+            kEpoll,
+            kIoUring,
+        };
+
+        // 没有指定后端时使用kEpoll；设置了环境变量BO_NET_USE_IO_URING时默认使用kIoUring
+        EventLoop();
+        explicit EventLoop(PollerBackend backend);
+        ~EventLoop(); // force out-line dtor, for std::unique_ptr members.
+
+        // 一直循环直到quit()被调用，只能在创建EventLoop的线程中调用
+        void loop();
+
+        // 不是百分之百线程安全的：通过裸指针调用时EventLoop可能正在析构，最好通过shared_ptr<EventLoop>调用
+        void quit();
+
+        // poll返回的时刻，同一轮中所有的事件回调拿到的都是这个值，回调里不需要再调用Timestamp::now()
+        Timestamp pollReturnTime() const { return pollReturnTime_; }
+
+        int64_t iteration() const { return iteration_; }
+
+        PollerBackend pollerBackend() const { return pollerBackend_; }
+
+        // 在IO线程中立即执行cb；在其他线程调用时转交给queueInLoop，可以安全地跨线程调用
+        void runInLoop(Functor cb);
+
+        // 把cb放入队列，在本轮事件处理结束之后执行，可以安全地跨线程调用。
+        // cb会被包装成一个从SlabAllocator分配的LoopTask，再走post()的路径
+        void queueInLoop(Functor cb);
+
+        // 和queueInLoop相同的时机执行task->run()，可以安全地跨线程调用。
+        // 入队只是一次原子exchange，热点路径上可以把任务对象预先分配好反复投递，完全不分配内存
+        void post(LoopTask *task);
+
+        // 近似值
+        size_t queueSize() const { return pendingCount_.load(std::memory_order_relaxed); }
+
+        // timers，都可以跨线程调用
+
+        // 在time时刻执行cb
+        TimerId runAt(Timestamp time, TimerCallback cb);
+        // delay秒之后执行cb
+        TimerId runAfter(double delay, TimerCallback cb);
+        // 每隔interval秒执行一次cb
+        TimerId runEvery(double interval, TimerCallback cb);
+
+        // 粗粒度版本：定时器放在时间轮上，最多晚TimerQueue::kCoarseTickMs毫秒触发，
+        // 添加、取消、refresh都是O(1)，用于连接的空闲超时、读超时这类大量且经常被推迟的定时器
+        TimerId runAtCoarse(Timestamp time, TimerCallback cb);
+        TimerId runAfterCoarse(double delay, TimerCallback cb);
+        TimerId runEveryCoarse(double interval, TimerCallback cb);
+
+        // 把还没有触发的定时器改到time时刻触发，在IO线程中调用时不分配内存
+        void refresh(TimerId timerId, Timestamp time);
+
+        void cancel(TimerId timerId);
+
+        // internal usage
+        void wakeup();
+        void updateChannel(Channel *channel);
+        void removeChannel(Channel *channel);
+        bool hasChannel(Channel *channel);
+
+        void assertInLoopThread() {
+            if(!isInLoopThread()) {
+                abortNotInLoopThread();
+            }
+        }
+
+        bool isInLoopThread() const {
+            return threadId_ == CurrentThread::tid();
+        }
+
+        bool eventHandling() const { return eventHandling_; }
+
+        static EventLoop* getEventLoopOfCurrentThread();
+
+    private:
+        void abortNotInLoopThread();
+        void handleRead(); // waked up
+        void doPendingFunctors();
+
+        typedef std::vector<Channel*> ChannelList;
+
+        bool looping_; /* atomic */
+        std::atomic<bool> quit_;
+        bool eventHandling_; /* atomic */
+        bool callingPendingFunctors_; /* atomic */
+        int64_t iteration_;
+        const pid_t threadId_;
+        PollerBackend pollerBackend_;
+        Timestamp pollReturnTime_;
+        std::unique_ptr<Poller> poller_;
+        std::unique_ptr<TimerQueue> timerQueue_;
+        int wakeupFd_;
+        // unlike in TimerQueue, which is an internal class,
+        // we don't expose Channel to client.
+        std::unique_ptr<Channel> wakeupChannel_;
+
+        // 已经有一次wakeup写入eventfd、IO线程还没有开始处理这批任务时为true。
+        // 这期间其他线程的queueInLoop不需要再写eventfd，一批跨线程任务只花一次write系统调用
+        std::atomic<bool> wakeupPending_;
+
+        ChannelList activeChannels_;
+        Channel *currentActiveChannel_;
+
+        // 多个生产者线程、唯一的消费者是IO线程，正好是MPSC队列的场景
+        MpscQueue<LoopTask> pendingTasks_;
+        std::atomic<size_t> pendingCount_;
+};
+
+} // namespace net
+
+} // namespace bo_net
+
+#endif // BO_NET_NET_EVENTLOOP_H
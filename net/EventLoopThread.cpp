@@ -0,0 +1,77 @@
+#include "net/EventLoopThread.h"
+#include "net/EventLoop.h"
+#include "net/Poller.h"
+
+#include <assert.h>
+
+using namespace bo_net;
+using namespace bo_net::net;
+
+EventLoopThread::EventLoopThread(const ThreadInitCallback& cb,
+                                 const string& name)
+  : loop_(NULL),
+    exiting_(false),
+    thread_(std::bind(&EventLoopThread::threadFunc, this), name),
+    mutex_(),
+    latch_(1),
+    callback_(cb),
+    backend_(Poller::defaultBackend())
+{
+}
+
+EventLoopThread::~EventLoopThread()
+{
+  exiting_ = true;
+  EventLoop* loop = NULL;
+  {
+    MutexLockGuard lock(mutex_);
+    loop = loop_;
+  }
+  if (loop != NULL) // not 100% race-free, eg. threadFunc could be running callback_.
+  {
+    // still a tiny chance to call destructed object, if threadFunc exits just now.
+    // but when EventLoopThread destructs, usually programming is exiting anyway.
+    loop->quit();
+    thread_.join();
+  }
+}
+
+void EventLoopThread::start()
+{
+  assert(!thread_.started());
+  thread_.start();
+}
+
+EventLoop* EventLoopThread::waitForLoop()
+{
+  latch_.wait();
+  MutexLockGuard lock(mutex_);
+  return loop_;
+}
+
+EventLoop* EventLoopThread::startLoop()
+{
+  start();
+  return waitForLoop();
+}
+
+void EventLoopThread::threadFunc()
+{
+  EventLoop loop(backend_);
+
+  if (callback_)
+  {
+    callback_(&loop);
+  }
+
+  {
+    MutexLockGuard lock(mutex_);
+    loop_ = &loop;
+  }
+  latch_.countDown();
+
+  loop.loop();
+  //assert(exiting_);
+  MutexLockGuard lock(mutex_);
+  loop_ = NULL;
+}
@@ -0,0 +1,62 @@
+#ifndef BO_NET_NET_EVENTLOOPTHREAD_H
+#define BO_NET_NET_EVENTLOOPTHREAD_H
+
+#include "base/CountDownLatch.h"
+#include "base/Mutex.h"
+#include "base/Thread.h"
+#include "base/noncopyable.h"
+#include "net/EventLoop.h"
+
+#include <functional>
+#include <vector>
+
+namespace bo_net
+{
+
+namespace net
+{
+
+// 在一个新线程中创建并运行EventLoop
+class EventLoopThread : noncopyable
+{
+    public:
+        typedef std::function<void(EventLoop*)> ThreadInitCallback;
+
+        EventLoopThread(const ThreadInitCallback &cb = ThreadInitCallback(),
+                        const string &name = string());
+        ~EventLoopThread();
+
+        // 把IO线程绑定到这些CPU上，必须在start()之前调用
+        void setCpuAffinity(const std::vector<int> &cpus) {
+            thread_.setCpuAffinity(cpus);
+        }
+
+        // 新线程中的EventLoop使用的IO多路复用后端，必须在start()之前调用
+        void setPollerBackend(EventLoop::PollerBackend backend) { backend_ = backend; }
+
+        // 启动线程，不等待EventLoop创建完成。先start()所有线程再逐个waitForLoop()，可以并行地启动一组IO线程
+        void start();
+
+        // 等待EventLoop创建完成（ThreadInitCallback也已经执行完），返回新线程中的EventLoop
+        EventLoop* waitForLoop();
+
+        // start() + waitForLoop()
+        EventLoop* startLoop();
+
+    private:
+        void threadFunc();
+
+        EventLoop     *loop_ GUARDED_BY(mutex_);
+        bool           exiting_;
+        Thread         thread_;
+        MutexLock      mutex_;
+        CountDownLatch latch_;
+        ThreadInitCallback callback_;
+        EventLoop::PollerBackend backend_;
+};
+
+} // namespace net
+
+} // namespace bo_net
+
+#endif // BO_NET_NET_EVENTLOOPTHREAD_H
@@ -0,0 +1,101 @@
+#include "net/EventLoopThreadPool.h"
+#include "net/EventLoop.h"
+#include "net/EventLoopThread.h"
+#include "net/Poller.h"
+
+#include <assert.h>
+#include <stdio.h>
+
+using namespace bo_net;
+using namespace bo_net::net;
+
+EventLoopThreadPool::EventLoopThreadPool(EventLoop* baseLoop, const string& nameArg)
+  : baseLoop_(baseLoop),
+    name_(nameArg),
+    started_(false),
+    numThreads_(0),
+    next_(0),
+    backend_(Poller::defaultBackend())
+{
+}
+
+EventLoopThreadPool::~EventLoopThreadPool()
+{
+  // Don't delete loop, it's stack variable
+}
+
+void EventLoopThreadPool::start(const ThreadInitCallback& cb)
+{
+  assert(!started_);
+  baseLoop_->assertInLoopThread();
+
+  started_ = true;
+
+  for (int i = 0; i < numThreads_; ++i)
+  {
+    char buf[name_.size() + 32];
+    snprintf(buf, sizeof buf, "%s%d", name_.c_str(), i);
+    EventLoopThread* t = new EventLoopThread(cb, buf);
+    if (static_cast<size_t>(i) < cpuMap_.size() && !cpuMap_[i].empty())
+    {
+      t->setCpuAffinity(cpuMap_[i]);
+    }
+    t->setPollerBackend(backend_);
+    threads_.push_back(std::unique_ptr<EventLoopThread>(t));
+    t->start();
+  }
+  // 所有线程都已经在创建各自的EventLoop了，逐个等待，总的等待时间取决于最慢的那个线程
+  for (const std::unique_ptr<EventLoopThread>& t : threads_)
+  {
+    loops_.push_back(t->waitForLoop());
+  }
+  if (numThreads_ == 0 && cb)
+  {
+    cb(baseLoop_);
+  }
+}
+
+EventLoop* EventLoopThreadPool::getNextLoop()
+{
+  baseLoop_->assertInLoopThread();
+  assert(started_);
+  EventLoop* loop = baseLoop_;
+
+  if (!loops_.empty())
+  {
+    // round-robin
+    loop = loops_[next_];
+    ++next_;
+    if (static_cast<size_t>(next_) >= loops_.size())
+    {
+      next_ = 0;
+    }
+  }
+  return loop;
+}
+
+EventLoop* EventLoopThreadPool::getLoopForHash(size_t hashCode)
+{
+  baseLoop_->assertInLoopThread();
+  EventLoop* loop = baseLoop_;
+
+  if (!loops_.empty())
+  {
+    loop = loops_[hashCode % loops_.size()];
+  }
+  return loop;
+}
+
+std::vector<EventLoop*> EventLoopThreadPool::getAllLoops()
+{
+  baseLoop_->assertInLoopThread();
+  assert(started_);
+  if (loops_.empty())
+  {
+    return std::vector<EventLoop*>(1, baseLoop_);
+  }
+  else
+  {
+    return loops_;
+  }
+}
@@ -0,0 +1,72 @@
+#ifndef BO_NET_NET_EVENTLOOPTHREADPOOL_H
+#define BO_NET_NET_EVENTLOOPTHREADPOOL_H
+
+#include "base/Types.h"
+#include "base/noncopyable.h"
+#include "net/EventLoop.h"
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace bo_net
+{
+
+namespace net
+{
+
+class EventLoopThread;
+
+// 一组IO线程，每个线程一个EventLoop。numThreads为0时所有事情都在baseLoop中完成
+class EventLoopThreadPool : noncopyable
+{
+    public:
+        typedef std::function<void(EventLoop*)> ThreadInitCallback;
+        // cpuMap[i]是第i个IO线程要绑定的CPU列表，为空或者i超出范围表示不绑核
+        typedef std::vector<std::vector<int> > CpuMap;
+
+        EventLoopThreadPool(EventLoop *baseLoop, const string &nameArg);
+        ~EventLoopThreadPool();
+
+        void setThreadNum(int numThreads) { numThreads_ = numThreads; }
+
+        // 必须在start()之前调用
+        void setCpuMap(const CpuMap &cpuMap) { cpuMap_ = cpuMap; }
+
+        // 所有IO线程的EventLoop使用的后端，必须在start()之前调用，例如
+        // server.threadPool()->setPollerBackend(EventLoop::kIoUring)
+        void setPollerBackend(EventLoop::PollerBackend backend) { backend_ = backend; }
+
+        // 并行地启动所有IO线程，等它们的EventLoop都创建好了才返回
+        void start(const ThreadInitCallback &cb = ThreadInitCallback());
+
+        // valid after calling start()
+        // round-robin
+        EventLoop* getNextLoop();
+
+        // with the same hash code, it will always return the same EventLoop
+        EventLoop* getLoopForHash(size_t hashCode);
+
+        std::vector<EventLoop*> getAllLoops();
+
+        bool started() const { return started_; }
+
+        const string& name() const { return name_; }
+
+    private:
+        EventLoop *baseLoop_;
+        string     name_;
+        bool       started_;
+        int        numThreads_;
+        int        next_;
+        CpuMap     cpuMap_;
+        EventLoop::PollerBackend backend_;
+        std::vector<std::unique_ptr<EventLoopThread> > threads_;
+        std::vector<EventLoop*> loops_;
+};
+
+} // namespace net
+
+} // namespace bo_net
+
+#endif // BO_NET_NET_EVENTLOOPTHREADPOOL_H
@@ -0,0 +1,85 @@
+#include "net/InetAddress.h"
+#include "net/Endian.h"
+#include "net/SocketsOps.h"
+
+#include <assert.h>
+#include <stddef.h>
+
+using namespace bo_net;
+using namespace bo_net::net;
+
+namespace
+{
+// INADDR_ANY use (type)value casting.
+const in_addr_t kInaddrAny = INADDR_ANY;
+const in_addr_t kInaddrLoopback = INADDR_LOOPBACK;
+}  // namespace
+
+static_assert(sizeof(InetAddress) == sizeof(struct sockaddr_in6),
+              "InetAddress is same size as sockaddr_in6");
+static_assert(offsetof(sockaddr_in, sin_family) == 0, "sin_family offset 0");
+static_assert(offsetof(sockaddr_in6, sin6_family) == 0, "sin6_family offset 0");
+static_assert(offsetof(sockaddr_in, sin_port) == 2, "sin_port offset 2");
+static_assert(offsetof(sockaddr_in6, sin6_port) == 2, "sin6_port offset 2");
+
+InetAddress::InetAddress(uint16_t portArg, bool loopbackOnly, bool ipv6)
+{
+  static_assert(offsetof(InetAddress, addr6_) == 0, "addr6_ offset 0");
+  static_assert(offsetof(InetAddress, addr_) == 0, "addr_ offset 0");
+  if (ipv6)
+  {
+    memZero(&addr6_, sizeof addr6_);
+    addr6_.sin6_family = AF_INET6;
+    in6_addr ip = loopbackOnly ? in6addr_loopback : in6addr_any;
+    addr6_.sin6_addr = ip;
+    addr6_.sin6_port = sockets::hostToNetwork16(portArg);
+  }
+  else
+  {
+    memZero(&addr_, sizeof addr_);
+    addr_.sin_family = AF_INET;
+    in_addr_t ip = loopbackOnly ? kInaddrLoopback : kInaddrAny;
+    addr_.sin_addr.s_addr = sockets::hostToNetwork32(ip);
+    addr_.sin_port = sockets::hostToNetwork16(portArg);
+  }
+}
+
+InetAddress::InetAddress(std::string_view ip, uint16_t portArg, bool ipv6)
+{
+  string ipString(ip);
+  if (ipv6 || ip.find(':') != std::string_view::npos)
+  {
+    memZero(&addr6_, sizeof addr6_);
+    sockets::fromIpPort(ipString.c_str(), portArg, &addr6_);
+  }
+  else
+  {
+    memZero(&addr_, sizeof addr_);
+    sockets::fromIpPort(ipString.c_str(), portArg, &addr_);
+  }
+}
+
+string InetAddress::toIpPort() const
+{
+  char buf[64] = "";
+  sockets::toIpPort(buf, sizeof buf, getSockAddr());
+  return buf;
+}
+
+string InetAddress::toIp() const
+{
+  char buf[64] = "";
+  sockets::toIp(buf, sizeof buf, getSockAddr());
+  return buf;
+}
+
+uint32_t InetAddress::ipv4NetEndian() const
+{
+  assert(family() == AF_INET);
+  return addr_.sin_addr.s_addr;
+}
+
+uint16_t InetAddress::port() const
+{
+  return sockets::networkToHost16(portNetEndian());
+}
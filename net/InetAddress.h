@@ -0,0 +1,64 @@
+#ifndef BO_NET_NET_INETADDRESS_H
+#define BO_NET_NET_INETADDRESS_H
+
+#include "base/Types.h"
+#include "base/copyable.h"
+
+#include <netinet/in.h>
+#include <string_view>
+
+namespace bo_net
+{
+
+namespace net
+{
+
+namespace sockets
+{
+const struct sockaddr* sockaddr_cast(const struct sockaddr_in6 *addr);
+}
+
+// sockaddr_in / sockaddr_in6 的包装，POD类型，可以直接拷贝
+class InetAddress : public bo_net::copyable
+{
+    public:
+        // 监听用：绑定到port，loopbackOnly为true时只监听回环地址
+        explicit InetAddress(uint16_t port = 0, bool loopbackOnly = false, bool ipv6 = false);
+
+        // ip是点分十进制的IPv4地址或者IPv6地址，比如"1.2.3.4"、"::1"
+        InetAddress(std::string_view ip, uint16_t port, bool ipv6 = false);
+
+        explicit InetAddress(const struct sockaddr_in &addr)
+            : addr_(addr)
+        { }
+
+        explicit InetAddress(const struct sockaddr_in6 &addr)
+            : addr6_(addr)
+        { }
+
+        sa_family_t family() const { return addr_.sin_family; }
+        string toIp() const;
+        string toIpPort() const;
+        uint16_t port() const;
+
+        // default copy/assignment are Okay
+
+        const struct sockaddr* getSockAddr() const { return sockets::sockaddr_cast(&addr6_); }
+        void setSockAddrInet6(const struct sockaddr_in6 &addr6) { addr6_ = addr6; }
+
+        uint32_t ipv4NetEndian() const;
+        uint16_t portNetEndian() const { return addr_.sin_port; }
+
+    private:
+        union
+        {
+            struct sockaddr_in addr_;
+            struct sockaddr_in6 addr6_;
+        };
+};
+
+} // namespace net
+
+} // namespace bo_net
+
+#endif // BO_NET_NET_INETADDRESS_H
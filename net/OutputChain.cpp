@@ -0,0 +1,267 @@
+#include "net/OutputChain.h"
+
+#include <algorithm>
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <sys/ioctl.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+
+using namespace bo_net;
+using namespace bo_net::net;
+
+namespace
+{
+// 一次writev最多收集这么多个内存段，远小于IOV_MAX，iovec数组放在栈上
+const int kMaxIovecs = 64;
+// 小于这个长度的数据拷贝进新的自有Buffer时，至少按这个大小分配，后面的小块可以继续合并进来
+const size_t kMinOwnedBufferSize = 1024;
+}  // namespace
+
+OutputChain::OutputChain()
+  : head_(0),
+    bytes_(0),
+    stalledPipe_(-1)
+{
+}
+
+OutputChain::~OutputChain() = default;
+
+OutputChain::OutputChain(OutputChain&& rhs) noexcept
+  : segments_(std::move(rhs.segments_)),
+    head_(rhs.head_),
+    bytes_(rhs.bytes_),
+    stalledPipe_(rhs.stalledPipe_)
+{
+  rhs.segments_.clear();
+  rhs.head_ = 0;
+  rhs.bytes_ = 0;
+  rhs.stalledPipe_ = -1;
+}
+
+OutputChain& OutputChain::operator=(OutputChain&& rhs) noexcept
+{
+  segments_ = std::move(rhs.segments_);
+  head_ = rhs.head_;
+  bytes_ = rhs.bytes_;
+  stalledPipe_ = rhs.stalledPipe_;
+  rhs.segments_.clear();
+  rhs.head_ = 0;
+  rhs.bytes_ = 0;
+  rhs.stalledPipe_ = -1;
+  return *this;
+}
+
+void OutputChain::push(Segment&& seg)
+{
+  if (head_ > 0 && head_ * 2 >= segments_.size())
+  {
+    segments_.erase(segments_.begin(), segments_.begin() + head_);
+    head_ = 0;
+  }
+  bytes_ += seg.size();
+  segments_.push_back(std::move(seg));
+}
+
+void OutputChain::append(const char* data, size_t len)
+{
+  if (len == 0)
+  {
+    return;
+  }
+  if (head_ < segments_.size() && segments_.back().type == kOwned)
+  {
+    segments_.back().buffer->append(data, len);
+    bytes_ += len;
+    return;
+  }
+  Segment seg = { kOwned, std::unique_ptr<Buffer>(new Buffer(std::max(len, kMinOwnedBufferSize))),
+                  std::shared_ptr<const void>(), NULL, 0, -1, 0, false };
+  seg.buffer->append(data, len);
+  push(std::move(seg));
+}
+
+void OutputChain::append(Buffer* buf)
+{
+  if (buf->readableBytes() == 0)
+  {
+    return;
+  }
+  Segment seg = { kOwned, std::unique_ptr<Buffer>(new Buffer(0)),
+                  std::shared_ptr<const void>(), NULL, 0, -1, 0, false };
+  seg.buffer->swap(*buf);
+  push(std::move(seg));
+}
+
+void OutputChain::appendShared(std::shared_ptr<const void> owner, const char* data, size_t len)
+{
+  if (len == 0)
+  {
+    return;
+  }
+  Segment seg = { kShared, std::unique_ptr<Buffer>(), std::move(owner), data, len, -1, 0, false };
+  push(std::move(seg));
+}
+
+void OutputChain::appendFile(std::shared_ptr<const void> owner, int fd, off_t offset, size_t len)
+{
+  if (len == 0)
+  {
+    return;
+  }
+  struct stat st;
+  bool pipe = ::fstat(fd, &st) == 0 && S_ISFIFO(st.st_mode);
+  Segment seg = { kFile, std::unique_ptr<Buffer>(), std::move(owner), NULL, len, fd, offset, pipe };
+  push(std::move(seg));
+}
+
+void OutputChain::append(OutputChain&& other)
+{
+  for (size_t i = other.head_; i < other.segments_.size(); ++i)
+  {
+    push(std::move(other.segments_[i]));
+  }
+  other.clear();
+}
+
+void OutputChain::clear()
+{
+  segments_.clear();
+  head_ = 0;
+  bytes_ = 0;
+  stalledPipe_ = -1;
+}
+
+void OutputChain::consume(size_t n)
+{
+  assert(n <= bytes_);
+  bytes_ -= n;
+  while (n > 0)
+  {
+    assert(head_ < segments_.size());
+    Segment& seg = segments_[head_];
+    size_t size = seg.size();
+    if (n < size)
+    {
+      if (seg.type == kOwned)
+      {
+        seg.buffer->retrieve(n);
+      }
+      else
+      {
+        if (seg.type == kShared)
+        {
+          seg.data += n;
+        }
+        else
+        {
+          seg.offset += static_cast<off_t>(n);
+        }
+        seg.len -= n;
+      }
+      return;
+    }
+    n -= size;
+    // 尽早释放owner，共享的内存和文件不必等整个队列发完
+    seg = Segment();
+    ++head_;
+  }
+  if (head_ == segments_.size())
+  {
+    segments_.clear();
+    head_ = 0;
+  }
+}
+
+ssize_t OutputChain::writeMemory(int sockfd, int* savedErrno, bool* drained)
+{
+  struct iovec vec[kMaxIovecs];
+  int iovcnt = 0;
+  size_t total = 0;
+  for (size_t i = head_; i < segments_.size() && iovcnt < kMaxIovecs; ++i)
+  {
+    const Segment& seg = segments_[i];
+    if (seg.type == kFile)
+    {
+      break;
+    }
+    vec[iovcnt].iov_base = const_cast<char*>(seg.peek());
+    vec[iovcnt].iov_len = seg.size();
+    total += seg.size();
+    ++iovcnt;
+  }
+  ssize_t n = ::writev(sockfd, vec, iovcnt);
+  if (n < 0)
+  {
+    *savedErrno = errno;
+    return -1;
+  }
+  consume(n);
+  // 没有全部写出去，说明socket发送缓冲区已经满了
+  *drained = static_cast<size_t>(n) == total;
+  return n;
+}
+
+ssize_t OutputChain::writeFile(int sockfd, int* savedErrno, bool* drained)
+{
+  Segment& seg = segments_[head_];
+  ssize_t n;
+  if (seg.pipe)
+  {
+    n = ::splice(seg.fd, NULL, sockfd, NULL, seg.len, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+  }
+  else
+  {
+    off_t offset = seg.offset;
+    n = ::sendfile(sockfd, seg.fd, &offset, seg.len);
+  }
+  if (n < 0)
+  {
+    *savedErrno = errno;
+    // splice对两端都是非阻塞的，EAGAIN可能是socket满了，也可能是管道空了，看一下管道里还有没有数据
+    int avail = 0;
+    if (seg.pipe && errno == EAGAIN && ::ioctl(seg.fd, FIONREAD, &avail) == 0 && avail == 0)
+    {
+      stalledPipe_ = seg.fd;
+    }
+    return -1;
+  }
+  if (n == 0)
+  {
+    // 文件在发送过程中被截断了，或者管道的写端已经关闭，剩下的部分永远也发不出去，丢掉这一段
+    fprintf(stderr, "OutputChain::writeTo: fd %d ended with %zu bytes unsent\n", seg.fd, seg.len);
+    consume(seg.len);
+    *drained = true;
+    return 0;
+  }
+  size_t len = seg.len;
+  consume(n);
+  *drained = static_cast<size_t>(n) == len;
+  return n;
+}
+
+ssize_t OutputChain::writeTo(int sockfd, int* savedErrno)
+{
+  ssize_t written = 0;
+  bool drained = true;
+  stalledPipe_ = -1;
+  while (!empty() && drained)
+  {
+    ssize_t n = segments_[head_].type == kFile
+        ? writeFile(sockfd, savedErrno, &drained)
+        : writeMemory(sockfd, savedErrno, &drained);
+    if (n < 0)
+    {
+      if (*savedErrno == EAGAIN)
+      {
+        break;
+      }
+      return -1;
+    }
+    written += n;
+  }
+  return written;
+}
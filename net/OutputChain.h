@@ -0,0 +1,106 @@
+#ifndef BO_NET_NET_OUTPUTCHAIN_H
+#define BO_NET_NET_OUTPUTCHAIN_H
+
+#include "base/noncopyable.h"
+#include "net/Buffer.h"
+
+#include <memory>
+#include <vector>
+#include <sys/types.h>
+
+namespace bo_net
+{
+
+namespace net
+{
+
+// 连接的发送队列：一串按顺序发送的段，每一段是下面三种之一
+// - 自有的Buffer：小块数据拷贝进来，连续的小块合并到同一个Buffer里；
+// - 共享的内存片：只持有owner的引用计数和(data, len)，比如缓存中的响应体，多个连接共享同一份内存，不拷贝；
+// - 文件区间：(fd, offset, len)，发送时用sendfile（普通文件）或者splice（管道）在内核中直接搬运，不经过用户态。
+//
+// writeTo()把开头连续的内存段收集成一个iovec数组，一次writev发出去，遇到文件段再单独sendfile/splice。
+// 空的OutputChain不分配任何内存，空闲连接的发送队列没有额外开销
+//
+// 不是线程安全的，由TcpConnection在IO线程中使用
+class OutputChain : noncopyable
+{
+    public:
+        OutputChain();
+        ~OutputChain();
+
+        OutputChain(OutputChain &&rhs) noexcept;
+        OutputChain& operator=(OutputChain &&rhs) noexcept;
+
+        // 拷贝一份数据
+        void append(const char *data, size_t len);
+        void append(std::string_view data) { append(data.data(), data.size()); }
+
+        // 接管buf中的全部可读数据（交换底层内存，不拷贝），buf变为空
+        void append(Buffer *buf);
+
+        // 引用[data, data + len)，发送完之前一直持有owner，owner释放时这段内存不能再被修改
+        void appendShared(std::shared_ptr<const void> owner, const char *data, size_t len);
+
+        // 发送fd中从offset开始的len字节；fd是管道时忽略offset，从管道里读len字节。
+        // 发送完之前一直持有owner，fd的生命周期由调用者通过owner保证（比如owner的析构函数负责close）
+        void appendFile(std::shared_ptr<const void> owner, int fd, off_t offset, size_t len);
+
+        // 把other中的所有段按顺序移到末尾，other变为空
+        void append(OutputChain &&other);
+
+        // 还没有发送的字节数，包括文件段
+        size_t readableBytes() const { return bytes_; }
+        bool empty() const { return bytes_ == 0; }
+
+        // 尽可能多地写到sockfd，直到全部写完、socket发送缓冲区满了、或者队首的管道暂时没有数据为止。
+        // 返回写出的字节数；出错（EAGAIN除外）时返回-1，savedErrno保存errno
+        ssize_t writeTo(int sockfd, int *savedErrno);
+
+        // 上一次writeTo()是因为队首管道段的管道里暂时没有数据（写端还开着）才停下的，返回这个管道的fd，否则返回-1。
+        // 这时socket仍然可写，调用者应该停止关注socket的可写事件，改为等这个管道可读，否则会一直被唤醒空转
+        int stalledPipe() const { return stalledPipe_; }
+
+        void clear();
+
+    private:
+        enum Type { kOwned, kShared, kFile };
+
+        struct Segment
+        {
+            Type type;
+            std::unique_ptr<Buffer> buffer;       // kOwned
+            std::shared_ptr<const void> owner;    // kShared, kFile
+            const char *data;                     // kShared
+            size_t len;                           // kShared, kFile
+            int fd;                               // kFile
+            off_t offset;                         // kFile
+            bool pipe;                            // kFile
+
+            const char* peek() const {
+                return type == kOwned ? buffer->peek() : data;
+            }
+
+            size_t size() const {
+                return type == kOwned ? buffer->readableBytes() : len;
+            }
+        };
+
+        // 从队首开始去掉n个字节
+        void consume(size_t n);
+        void push(Segment &&seg);
+        ssize_t writeMemory(int sockfd, int *savedErrno, bool *drained);
+        ssize_t writeFile(int sockfd, int *savedErrno, bool *drained);
+
+        // 已经发完的段只是推进head_，不从vector头部删除，队列空了或者空洞超过一半时才整理
+        std::vector<Segment> segments_;
+        size_t head_;
+        size_t bytes_;
+        int stalledPipe_;
+};
+
+} // namespace net
+
+} // namespace bo_net
+
+#endif // BO_NET_NET_OUTPUTCHAIN_H
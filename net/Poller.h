@@ -0,0 +1,64 @@
+#ifndef BO_NET_NET_POLLER_H
+#define BO_NET_NET_POLLER_H
+
+#include "base/Timestamp.h"
+#include "base/noncopyable.h"
+#include "net/EventLoop.h"
+
+#include <map>
+#include <vector>
+
+namespace bo_net
+{
+
+namespace net
+{
+
+class Channel;
+
+// IO多路复用的抽象接口，EventLoop通过它等待事件，不关心底层是epoll还是别的机制。
+// Poller不拥有Channel，所有函数都只能在所属EventLoop的线程中调用
+class Poller : noncopyable
+{
+    public:
+        typedef std::vector<Channel*> ChannelList;
+
+        explicit Poller(EventLoop *loop);
+        virtual ~Poller();
+
+        // 等待事件，把就绪的Channel放进activeChannels，返回poll返回的时刻
+        virtual Timestamp poll(int timeoutMs, ChannelList *activeChannels) = 0;
+
+        // 添加或者修改Channel关心的事件
+        virtual void updateChannel(Channel *channel) = 0;
+
+        // Channel析构之前必须先从Poller中移除
+        virtual void removeChannel(Channel *channel) = 0;
+
+        virtual bool hasChannel(Channel *channel) const;
+
+        static Poller* newDefaultPoller(EventLoop *loop);
+
+        // 按*backend创建Poller；后端不可用时退回到epoll，并把*backend改成实际使用的后端
+        static Poller* newPoller(EventLoop *loop, EventLoop::PollerBackend *backend);
+
+        // 设置了环境变量BO_NET_USE_IO_URING时为kIoUring，否则为kEpoll
+        static EventLoop::PollerBackend defaultBackend();
+
+        void assertInLoopThread() const {
+            ownerLoop_->assertInLoopThread();
+        }
+
+    protected:
+        typedef std::map<int, Channel*> ChannelMap;
+        ChannelMap channels_;
+
+    private:
+        EventLoop *ownerLoop_;
+};
+
+} // namespace net
+
+} // namespace bo_net
+
+#endif // BO_NET_NET_POLLER_H
@@ -0,0 +1,86 @@
+#include "net/Socket.h"
+#include "net/InetAddress.h"
+#include "net/SocketsOps.h"
+
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdio.h>  // snprintf
+#include <stdlib.h>
+#include <string.h>
+
+using namespace bo_net;
+using namespace bo_net::net;
+
+Socket::~Socket()
+{
+  sockets::close(sockfd_);
+}
+
+bool Socket::getTcpInfo(struct tcp_info* tcpi) const
+{
+  socklen_t len = sizeof(*tcpi);
+  memZero(tcpi, len);
+  return ::getsockopt(sockfd_, SOL_TCP, TCP_INFO, tcpi, &len) == 0;
+}
+
+void Socket::bindAddress(const InetAddress& addr)
+{
+  sockets::bindOrDie(sockfd_, addr.getSockAddr());
+}
+
+void Socket::listen()
+{
+  sockets::listenOrDie(sockfd_);
+}
+
+int Socket::accept(InetAddress* peeraddr)
+{
+  struct sockaddr_in6 addr;
+  memZero(&addr, sizeof addr);
+  int connfd = sockets::accept(sockfd_, &addr);
+  if (connfd >= 0)
+  {
+    peeraddr->setSockAddrInet6(addr);
+  }
+  return connfd;
+}
+
+void Socket::shutdownWrite()
+{
+  sockets::shutdownWrite(sockfd_);
+}
+
+void Socket::setTcpNoDelay(bool on)
+{
+  int optval = on ? 1 : 0;
+  ::setsockopt(sockfd_, IPPROTO_TCP, TCP_NODELAY,
+               &optval, static_cast<socklen_t>(sizeof optval));
+}
+
+void Socket::setReuseAddr(bool on)
+{
+  int optval = on ? 1 : 0;
+  ::setsockopt(sockfd_, SOL_SOCKET, SO_REUSEADDR,
+               &optval, static_cast<socklen_t>(sizeof optval));
+}
+
+void Socket::setReusePort(bool on)
+{
+  int optval = on ? 1 : 0;
+  int ret = ::setsockopt(sockfd_, SOL_SOCKET, SO_REUSEPORT,
+                         &optval, static_cast<socklen_t>(sizeof optval));
+  if (ret < 0 && on)
+  {
+    // 每个loop一个监听socket的模式离不开SO_REUSEPORT，设置失败时后面的bind一定会失败，直接退出
+    fprintf(stderr, "SO_REUSEPORT failed: %s\n", strerror(errno));
+    abort();
+  }
+}
+
+void Socket::setKeepAlive(bool on)
+{
+  int optval = on ? 1 : 0;
+  ::setsockopt(sockfd_, SOL_SOCKET, SO_KEEPALIVE,
+               &optval, static_cast<socklen_t>(sizeof optval));
+}
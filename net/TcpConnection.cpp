@@ -0,0 +1,613 @@
+#include "net/TcpConnection.h"
+#include "net/Channel.h"
+#include "net/EventLoop.h"
+#include "net/Socket.h"
+#include "net/SocketsOps.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <netinet/tcp.h>
+#include <stdio.h>
+#include <string.h>
+
+using namespace bo_net;
+using namespace bo_net::net;
+
+void bo_net::net::defaultConnectionCallback(const TcpConnectionPtr&)
+{
+  // do not call conn->forceClose(), because some users want to register message callback only.
+}
+
+void bo_net::net::defaultMessageCallback(const TcpConnectionPtr&,
+                                         Buffer* buf,
+                                         Timestamp)
+{
+  buf->retrieveAll();
+}
+
+TcpConnection::TcpConnection(EventLoop* loop,
+                             const string& nameArg,
+                             int sockfd,
+                             const InetAddress& localAddr,
+                             const InetAddress& peerAddr)
+  : loop_(loop),
+    name_(nameArg),
+    state_(kConnecting),
+    reading_(true),
+    socket_(new Socket(sockfd)),
+    channel_(new Channel(loop, sockfd)),
+    localAddr_(localAddr),
+    peerAddr_(peerAddr),
+    highWaterMark_(64*1024*1024),
+    lowWaterMark_(0),
+    aboveHighWaterMark_(false)
+{
+  channel_->setReadCallback(
+      std::bind(&TcpConnection::handleRead, this, std::placeholders::_1));
+  channel_->setWriteCallback(
+      std::bind(&TcpConnection::handleWrite, this));
+  channel_->setCloseCallback(
+      std::bind(&TcpConnection::handleClose, this));
+  channel_->setErrorCallback(
+      std::bind(&TcpConnection::handleError, this));
+  channel_->setRecvBuffer(&inputBuffer_);
+  socket_->setKeepAlive(true);
+}
+
+TcpConnection::~TcpConnection()
+{
+  assert(state_ == kDisconnected);
+}
+
+bool TcpConnection::getTcpInfo(struct tcp_info* tcpi) const
+{
+  return socket_->getTcpInfo(tcpi);
+}
+
+string TcpConnection::getTcpInfoString() const
+{
+  char buf[1024];
+  buf[0] = '\0';
+  struct tcp_info tcpi;
+  if (socket_->getTcpInfo(&tcpi))
+  {
+    snprintf(buf, sizeof buf, "unrecovered=%u "
+             "rto=%u ato=%u snd_mss=%u rcv_mss=%u "
+             "lost=%u retrans=%u rtt=%u rttvar=%u "
+             "sshthresh=%u cwnd=%u total_retrans=%u",
+             tcpi.tcpi_retransmits,  // Number of unrecovered [RTO] timeouts
+             tcpi.tcpi_rto,          // Retransmit timeout in usec
+             tcpi.tcpi_ato,          // Predicted tick of soft clock in usec
+             tcpi.tcpi_snd_mss,
+             tcpi.tcpi_rcv_mss,
+             tcpi.tcpi_lost,         // Lost packets
+             tcpi.tcpi_retrans,      // Retransmitted packets out
+             tcpi.tcpi_rtt,          // Smoothed round trip time in usec
+             tcpi.tcpi_rttvar,       // Medium deviation
+             tcpi.tcpi_snd_ssthresh,
+             tcpi.tcpi_snd_cwnd,
+             tcpi.tcpi_total_retrans);  // Total retransmits for entire connection
+  }
+  return buf;
+}
+
+void TcpConnection::send(const void* data, size_t len)
+{
+  send(std::string_view(static_cast<const char*>(data), len));
+}
+
+void TcpConnection::send(std::string_view message)
+{
+  if (state_ == kConnected)
+  {
+    if (loop_->isInLoopThread())
+    {
+      sendInLoop(message);
+    }
+    else
+    {
+      // 跨线程发送时必须拷贝一份数据，调用者返回之后message可能就失效了
+      loop_->runInLoop(
+          [self = shared_from_this(), data = string(message)]() {
+            self->sendInLoop(data);
+          });
+    }
+  }
+}
+
+void TcpConnection::send(Buffer* buf)
+{
+  if (state_ == kConnected)
+  {
+    if (loop_->isInLoopThread())
+    {
+      sendInLoop(buf);
+    }
+    else
+    {
+      // 跨线程时交换进一个OutputChain带过去，不拷贝数据
+      OutputChain chain;
+      chain.append(buf);
+      send(std::move(chain));
+    }
+  }
+}
+
+void TcpConnection::send(const std::shared_ptr<const string>& message)
+{
+  sendShared(message, message->data(), message->size());
+}
+
+void TcpConnection::sendShared(std::shared_ptr<const void> owner, const char* data, size_t len)
+{
+  OutputChain chain;
+  chain.appendShared(std::move(owner), data, len);
+  send(std::move(chain));
+}
+
+void TcpConnection::sendFile(std::shared_ptr<const void> owner, int fd, off_t offset, size_t len)
+{
+  OutputChain chain;
+  chain.appendFile(std::move(owner), fd, offset, len);
+  send(std::move(chain));
+}
+
+void TcpConnection::send(OutputChain&& chain)
+{
+  if (state_ == kConnected)
+  {
+    if (loop_->isInLoopThread())
+    {
+      sendInLoop(chain);
+    }
+    else
+    {
+      // std::function要求可拷贝，用shared_ptr把只能移动的OutputChain带过去
+      std::shared_ptr<OutputChain> holder(new OutputChain(std::move(chain)));
+      loop_->runInLoop(
+          [self = shared_from_this(), holder]() {
+            self->sendInLoop(*holder);
+          });
+    }
+  }
+}
+
+void TcpConnection::sendInLoop(std::string_view message)
+{
+  sendInLoop(message.data(), message.size());
+}
+
+void TcpConnection::sendInLoop(const void* data, size_t len)
+{
+  loop_->assertInLoopThread();
+  ssize_t nwrote = 0;
+  size_t remaining = len;
+  bool faultError = false;
+  if (state_ == kDisconnected)
+  {
+    fprintf(stderr, "TcpConnection %s disconnected, give up writing\n", name_.c_str());
+    return;
+  }
+  // if no thing in output queue, try writing directly
+  if (!channel_->isWriting() && output_.empty())
+  {
+    nwrote = sockets::write(channel_->fd(), data, len);
+    if (nwrote >= 0)
+    {
+      remaining = len - nwrote;
+      if (remaining == 0 && writeCompleteCallback_)
+      {
+        loop_->queueInLoop(std::bind(writeCompleteCallback_, shared_from_this()));
+      }
+    }
+    else // nwrote < 0
+    {
+      nwrote = 0;
+      if (errno != EWOULDBLOCK)
+      {
+        fprintf(stderr, "TcpConnection::sendInLoop %s: %s\n", name_.c_str(), strerror(errno));
+        if (errno == EPIPE || errno == ECONNRESET) // FIXME: any others?
+        {
+          faultError = true;
+        }
+      }
+    }
+  }
+
+  assert(remaining <= len);
+  if (!faultError && remaining > 0)
+  {
+    size_t oldLen = output_.readableBytes();
+    output_.append(static_cast<const char*>(data)+nwrote, remaining);
+    outputGrew(oldLen);
+  }
+}
+
+void TcpConnection::sendInLoop(Buffer* buf)
+{
+  loop_->assertInLoopThread();
+  if (state_ == kDisconnected)
+  {
+    fprintf(stderr, "TcpConnection %s disconnected, give up writing\n", name_.c_str());
+    return;
+  }
+  if (buf->readableBytes() == 0)
+  {
+    return;
+  }
+  // 发送队列为空时直接write，echo、转发这类最常见的情况不分配任何内存；
+  // 只有没写完的部分才把buf的内存交换进发送队列
+  if (!channel_->isWriting() && output_.empty())
+  {
+    ssize_t nwrote = sockets::write(channel_->fd(), buf->peek(), buf->readableBytes());
+    if (nwrote >= 0)
+    {
+      buf->retrieve(nwrote);
+      if (buf->readableBytes() == 0)
+      {
+        if (writeCompleteCallback_)
+        {
+          loop_->queueInLoop(std::bind(writeCompleteCallback_, shared_from_this()));
+        }
+        return;
+      }
+    }
+    else if (errno != EWOULDBLOCK)
+    {
+      fprintf(stderr, "TcpConnection::sendInLoop %s: %s\n", name_.c_str(), strerror(errno));
+      if (errno == EPIPE || errno == ECONNRESET)
+      {
+        buf->retrieveAll();
+        return;
+      }
+    }
+  }
+
+  size_t oldLen = output_.readableBytes();
+  output_.append(buf);
+  outputGrew(oldLen);
+}
+
+void TcpConnection::sendInLoop(OutputChain& chain)
+{
+  loop_->assertInLoopThread();
+  if (state_ == kDisconnected)
+  {
+    fprintf(stderr, "TcpConnection %s disconnected, give up writing\n", name_.c_str());
+    return;
+  }
+  size_t oldLen = output_.readableBytes();
+  output_.append(std::move(chain));
+  // 已经在等可写事件的话，前面还有数据没发完，只能排在后面
+  if (!channel_->isWriting())
+  {
+    int savedErrno = 0;
+    ssize_t n = output_.writeTo(channel_->fd(), &savedErrno);
+    if (n < 0)
+    {
+      fprintf(stderr, "TcpConnection::sendInLoop %s: %s\n", name_.c_str(), strerror(savedErrno));
+      if (savedErrno == EPIPE || savedErrno == ECONNRESET)
+      {
+        output_.clear();
+        return;
+      }
+    }
+    if (output_.empty())
+    {
+      if (writeCompleteCallback_)
+      {
+        loop_->queueInLoop(std::bind(writeCompleteCallback_, shared_from_this()));
+      }
+      return;
+    }
+  }
+  outputGrew(oldLen);
+}
+
+void TcpConnection::outputGrew(size_t oldLen)
+{
+  size_t newLen = output_.readableBytes();
+  if (newLen >= highWaterMark_ && oldLen < highWaterMark_)
+  {
+    aboveHighWaterMark_ = true;
+    if (highWaterMarkCallback_)
+    {
+      loop_->queueInLoop(std::bind(highWaterMarkCallback_, shared_from_this(), newLen));
+    }
+  }
+  if (output_.stalledPipe() >= 0)
+  {
+    waitForPipe(output_.stalledPipe());
+  }
+  else if (!channel_->isWriting())
+  {
+    channel_->enableWriting();
+  }
+}
+
+void TcpConnection::waitForPipe(int pipefd)
+{
+  loop_->assertInLoopThread();
+  // socket是可写的，继续关注可写事件的话每一轮poll都会立即返回，而管道里没有数据可发
+  if (channel_->isWriting())
+  {
+    channel_->disableWriting();
+  }
+  if (pipeChannel_ && pipeChannel_->fd() != pipefd)
+  {
+    pipeChannel_->disableAll();
+    pipeChannel_->remove();
+    // 可能正在这个Channel自己的回调里，放到本轮事件处理之后再析构
+    std::shared_ptr<Channel> old(pipeChannel_.release());
+    loop_->queueInLoop([old]() {});
+  }
+  if (!pipeChannel_)
+  {
+    pipeChannel_.reset(new Channel(loop_, pipefd));
+    pipeChannel_->tie(shared_from_this());
+    pipeChannel_->setReadCallback(
+        std::bind(&TcpConnection::handlePipeReadable, this));
+    // 写端关闭时只有POLLHUP，同样交给handleWrite，splice读到0会丢掉这一段
+    pipeChannel_->setCloseCallback(
+        std::bind(&TcpConnection::handlePipeReadable, this));
+  }
+  if (!pipeChannel_->isReading())
+  {
+    pipeChannel_->enableReading();
+  }
+}
+
+void TcpConnection::handlePipeReadable()
+{
+  loop_->assertInLoopThread();
+  pipeChannel_->disableAll();
+  if (state_ == kConnected || state_ == kDisconnecting)
+  {
+    channel_->enableWriting();
+    handleWrite();
+  }
+}
+
+void TcpConnection::shutdown()
+{
+  // FIXME: use compare and swap
+  if (state_ == kConnected)
+  {
+    setState(kDisconnecting);
+    // FIXME: shared_from_this()?
+    loop_->runInLoop(std::bind(&TcpConnection::shutdownInLoop, this));
+  }
+}
+
+void TcpConnection::shutdownInLoop()
+{
+  loop_->assertInLoopThread();
+  // 等管道数据的时候没有关注可写事件，但是发送队列还没有空
+  if (!channel_->isWriting() && output_.empty())
+  {
+    // we are not writing
+    socket_->shutdownWrite();
+  }
+}
+
+void TcpConnection::forceClose()
+{
+  // FIXME: use compare and swap
+  if (state_ == kConnected || state_ == kDisconnecting)
+  {
+    setState(kDisconnecting);
+    loop_->queueInLoop(std::bind(&TcpConnection::forceCloseInLoop, shared_from_this()));
+  }
+}
+
+void TcpConnection::forceCloseWithDelay(double seconds)
+{
+  if (state_ == kConnected || state_ == kDisconnecting)
+  {
+    setState(kDisconnecting);
+    std::weak_ptr<TcpConnection> weak(shared_from_this());
+    loop_->runAfter(
+        seconds,
+        [weak]() {
+          // not forceCloseInLoop to avoid race condition
+          if (TcpConnectionPtr conn = weak.lock())
+          {
+            conn->forceClose();
+          }
+        });
+  }
+}
+
+void TcpConnection::forceCloseInLoop()
+{
+  loop_->assertInLoopThread();
+  if (state_ == kConnected || state_ == kDisconnecting)
+  {
+    // as if we received 0 byte in handleRead();
+    handleClose();
+  }
+}
+
+void TcpConnection::setTcpNoDelay(bool on)
+{
+  socket_->setTcpNoDelay(on);
+}
+
+void TcpConnection::startRead()
+{
+  loop_->runInLoop(std::bind(&TcpConnection::startReadInLoop, this));
+}
+
+void TcpConnection::startReadInLoop()
+{
+  loop_->assertInLoopThread();
+  if (!reading_ || !channel_->isReading())
+  {
+    channel_->enableReading();
+    reading_ = true;
+    // 停止读期间Poller代收的数据（和对端关闭）还留着，现在交给用户
+    if (channel_->hasReceived())
+    {
+      handleRead(Timestamp::now());
+    }
+  }
+}
+
+void TcpConnection::stopRead()
+{
+  loop_->runInLoop(std::bind(&TcpConnection::stopReadInLoop, this));
+}
+
+void TcpConnection::stopReadInLoop()
+{
+  loop_->assertInLoopThread();
+  if (reading_ || channel_->isReading())
+  {
+    channel_->disableReading();
+    reading_ = false;
+  }
+}
+
+void TcpConnection::connectEstablished()
+{
+  loop_->assertInLoopThread();
+  assert(state_ == kConnecting);
+  setState(kConnected);
+  channel_->tie(shared_from_this());
+  channel_->enableReading();
+
+  connectionCallback_(shared_from_this());
+}
+
+void TcpConnection::connectDestroyed()
+{
+  loop_->assertInLoopThread();
+  if (state_ == kConnected)
+  {
+    setState(kDisconnected);
+    channel_->disableAll();
+
+    connectionCallback_(shared_from_this());
+  }
+  channel_->remove();
+  if (pipeChannel_)
+  {
+    pipeChannel_->disableAll();
+    pipeChannel_->remove();
+  }
+}
+
+void TcpConnection::handleRead(Timestamp receiveTime)
+{
+  loop_->assertInLoopThread();
+  if (!reading_)
+  {
+    // io_uring后端stopRead()时只是提交取消，已经在路上的recv仍然会把数据追加到inputBuffer_。
+    // 先留在那里，startRead()之后再交给用户，和epoll一样停止读之后不会再回调messageCallback_
+    return;
+  }
+  int savedErrno = 0;
+  ssize_t n = 0;
+  // io_uring后端的数据已经由Poller追加到了inputBuffer_，否则自己读
+  bool received = channel_->takeReceived(&n, &savedErrno);
+  if (!received)
+  {
+    if (channel_->isReceiving())
+    {
+      return;
+    }
+    n = inputBuffer_.readFd(channel_->fd(), &savedErrno);
+  }
+  if (n > 0)
+  {
+    messageCallback_(shared_from_this(), &inputBuffer_, receiveTime);
+    // 代收时最后一批数据和对端关闭（或者出错）可能在同一轮里到达，数据交给用户之后接着处理
+    if (!received || state_ == kDisconnected || !channel_->takeReceived(&n, &savedErrno))
+    {
+      return;
+    }
+    assert(n <= 0);
+  }
+  if (n == 0)
+  {
+    handleClose();
+  }
+  else
+  {
+    errno = savedErrno;
+    if (savedErrno != EAGAIN)
+    {
+      fprintf(stderr, "TcpConnection::handleRead %s: %s\n", name_.c_str(), strerror(savedErrno));
+      handleError();
+    }
+  }
+}
+
+void TcpConnection::handleWrite()
+{
+  loop_->assertInLoopThread();
+  if (channel_->isWriting())
+  {
+    int savedErrno = 0;
+    ssize_t n = output_.writeTo(channel_->fd(), &savedErrno);
+    if (n >= 0)
+    {
+      if (aboveHighWaterMark_ && output_.readableBytes() <= lowWaterMark_)
+      {
+        aboveHighWaterMark_ = false;
+        if (lowWaterMarkCallback_)
+        {
+          loop_->queueInLoop(std::bind(lowWaterMarkCallback_, shared_from_this(), output_.readableBytes()));
+        }
+      }
+      if (output_.empty())
+      {
+        channel_->disableWriting();
+        if (writeCompleteCallback_)
+        {
+          loop_->queueInLoop(std::bind(writeCompleteCallback_, shared_from_this()));
+        }
+        if (state_ == kDisconnecting)
+        {
+          shutdownInLoop();
+        }
+      }
+      else if (output_.stalledPipe() >= 0)
+      {
+        waitForPipe(output_.stalledPipe());
+      }
+    }
+    else if (n < 0)
+    {
+      fprintf(stderr, "TcpConnection::handleWrite %s: %s\n", name_.c_str(), strerror(savedErrno));
+    }
+  }
+}
+
+void TcpConnection::handleClose()
+{
+  loop_->assertInLoopThread();
+  assert(state_ == kConnected || state_ == kDisconnecting);
+  // we don't close fd, leave it to dtor, so we can find leaks easily.
+  setState(kDisconnected);
+  channel_->disableAll();
+  if (pipeChannel_)
+  {
+    pipeChannel_->disableAll();
+  }
+
+  TcpConnectionPtr guardThis(shared_from_this());
+  connectionCallback_(guardThis);
+  // must be the last line
+  closeCallback_(guardThis);
+}
+
+void TcpConnection::handleError()
+{
+  int err = sockets::getSocketError(channel_->fd());
+  if (err != 0)
+  {
+    fprintf(stderr, "TcpConnection::handleError [%s] - SO_ERROR = %d %s\n",
+            name_.c_str(), err, strerror(err));
+  }
+}
@@ -0,0 +1,160 @@
+#ifndef BO_NET_NET_TCPCONNECTION_H
+#define BO_NET_NET_TCPCONNECTION_H
+
+#include "base/Types.h"
+#include "base/noncopyable.h"
+#include "net/Buffer.h"
+#include "net/Callbacks.h"
+#include "net/InetAddress.h"
+#include "net/OutputChain.h"
+
+#include <any>
+#include <memory>
+#include <string_view>
+
+// struct tcp_info is in <netinet/tcp.h>
+struct tcp_info;
+
+namespace bo_net
+{
+
+namespace net
+{
+
+class Channel;
+class EventLoop;
+class Socket;
+
+// TCP connection, for both client and server usage.
+// 连接的生命周期由shared_ptr管理，所有的IO都在所属的EventLoop线程中进行；send/shutdown可以跨线程调用
+class TcpConnection : noncopyable,
+                      public std::enable_shared_from_this<TcpConnection>
+{
+    public:
+        // Constructs a TcpConnection with a connected sockfd
+        //
+        // User should not create this object.
+        TcpConnection(EventLoop *loop,
+                      const string &name,
+                      int sockfd,
+                      const InetAddress &localAddr,
+                      const InetAddress &peerAddr);
+        ~TcpConnection();
+
+        EventLoop* getLoop() const { return loop_; }
+        const string& name() const { return name_; }
+        const InetAddress& localAddress() const { return localAddr_; }
+        const InetAddress& peerAddress() const { return peerAddr_; }
+        bool connected() const { return state_ == kConnected; }
+        bool disconnected() const { return state_ == kDisconnected; }
+        // return true if success.
+        bool getTcpInfo(struct tcp_info*) const;
+        string getTcpInfoString() const;
+
+        void send(const void *message, size_t len);
+        void send(std::string_view message);
+        void send(Buffer *message);  // this one will swap data，IO线程中发送队列为空时直接write，不分配内存
+
+        // 以下几个不拷贝数据：共享的内存片只增加引用计数，文件区间用sendfile/splice发送
+        void send(const std::shared_ptr<const string> &message);
+        void sendShared(std::shared_ptr<const void> owner, const char *data, size_t len);
+        // fd是管道时，管道暂时没有数据就等它可读再接着发，不会在socket的可写事件上空转
+        void sendFile(std::shared_ptr<const void> owner, int fd, off_t offset, size_t len);
+        // 一次发送多个段，比如"响应头 + 缓存中的响应体 + 尾部"，合并成一次writev
+        void send(OutputChain &&chain);
+        void shutdown(); // NOT thread safe, no simultaneous calling
+        void forceClose();
+        void forceCloseWithDelay(double seconds);
+        void setTcpNoDelay(bool on);
+        // reading or not
+        void startRead();
+        void stopRead();
+        bool isReading() const { return reading_; }; // NOT thread safe, may race with start/stopReadInLoop
+
+        void setContext(const std::any &context) { context_ = context; }
+
+        const std::any& getContext() const { return context_; }
+
+        std::any* getMutableContext() { return &context_; }
+
+        void setConnectionCallback(const ConnectionCallback &cb) { connectionCallback_ = cb; }
+
+        void setMessageCallback(const MessageCallback &cb) { messageCallback_ = cb; }
+
+        void setWriteCompleteCallback(const WriteCompleteCallback &cb) { writeCompleteCallback_ = cb; }
+
+        // 待发送的字节数（包括还没有发出的文件区间）从低于highWaterMark增长到不低于highWaterMark时回调一次
+        void setHighWaterMarkCallback(const HighWaterMarkCallback &cb, size_t highWaterMark) {
+            highWaterMarkCallback_ = cb; highWaterMark_ = highWaterMark;
+        }
+
+        // 越过高水位之后，待发送的字节数回落到不高于lowWaterMark时回调一次，通常在这里恢复读取或者生产
+        void setLowWaterMarkCallback(const LowWaterMarkCallback &cb, size_t lowWaterMark) {
+            lowWaterMarkCallback_ = cb; lowWaterMark_ = lowWaterMark;
+        }
+
+        // Advanced interface
+        Buffer* inputBuffer() { return &inputBuffer_; }
+
+        // 只能在IO线程中访问
+        OutputChain* outputChain() { return &output_; }
+
+        // Internal use only.
+        void setCloseCallback(const CloseCallback &cb) { closeCallback_ = cb; }
+
+        // called when TcpServer accepts a new connection
+        void connectEstablished();   // should be called only once
+        // called when TcpServer has removed me from its map
+        void connectDestroyed();  // should be called only once
+
+    private:
+        enum StateE { kDisconnected, kConnecting, kConnected, kDisconnecting };
+
+        void handleRead(Timestamp receiveTime);
+        void handleWrite();
+        void handleClose();
+        void handleError();
+        void sendInLoop(std::string_view message);
+        void sendInLoop(const void *message, size_t len);
+        void sendInLoop(Buffer *buf);
+        void sendInLoop(OutputChain &chain);
+        // 待发送的数据从oldLen增长之后检查高水位，需要时注册写事件
+        void outputGrew(size_t oldLen);
+        // 发送队列停在一个暂时没有数据的管道上：不再关注socket的可写事件，改为等管道可读
+        void waitForPipe(int pipefd);
+        void handlePipeReadable();
+        void shutdownInLoop();
+        void forceCloseInLoop();
+        void setState(StateE s) { state_ = s; }
+        void startReadInLoop();
+        void stopReadInLoop();
+
+        EventLoop *loop_;
+        const string name_;
+        StateE state_;  // FIXME: use atomic variable
+        bool reading_;
+        // we don't expose those classes to client.
+        std::unique_ptr<Socket> socket_;
+        std::unique_ptr<Channel> channel_;
+        std::unique_ptr<Channel> pipeChannel_;  // 发送队列卡在管道段上时关注管道的可读事件，没有用到时为空
+        const InetAddress localAddr_;
+        const InetAddress peerAddr_;
+        ConnectionCallback connectionCallback_;
+        MessageCallback messageCallback_;
+        WriteCompleteCallback writeCompleteCallback_;
+        HighWaterMarkCallback highWaterMarkCallback_;
+        LowWaterMarkCallback lowWaterMarkCallback_;
+        CloseCallback closeCallback_;
+        size_t highWaterMark_;
+        size_t lowWaterMark_;
+        bool aboveHighWaterMark_;
+        Buffer inputBuffer_;
+        OutputChain output_;
+        std::any context_;
+};
+
+} // namespace net
+
+} // namespace bo_net
+
+#endif // BO_NET_NET_TCPCONNECTION_H
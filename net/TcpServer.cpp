@@ -0,0 +1,181 @@
+#include "net/TcpServer.h"
+#include "base/CountDownLatch.h"
+#include "base/ObjectPool.h"
+#include "net/Acceptor.h"
+#include "net/EventLoop.h"
+#include "net/EventLoopThreadPool.h"
+#include "net/SocketsOps.h"
+
+#include <assert.h>
+#include <stdio.h>  // snprintf
+
+using namespace bo_net;
+using namespace bo_net::net;
+
+TcpServer::TcpServer(EventLoop* loop,
+                     const InetAddress& listenAddr,
+                     const string& nameArg,
+                     Option option)
+  : loop_(loop),
+    listenAddr_(listenAddr),
+    ipPort_(listenAddr.toIpPort()),
+    name_(nameArg),
+    option_(option),
+    threadPool_(new EventLoopThreadPool(loop, name_)),
+    connectionCallback_(defaultConnectionCallback),
+    messageCallback_(defaultMessageCallback)
+{
+  assert(loop != NULL);
+  if (option_ != kReusePortPerLoop)
+  {
+    acceptor_.reset(new Acceptor(loop, listenAddr, option_ == kReusePort));
+    acceptor_->setNewConnectionCallback(
+        std::bind(&TcpServer::newConnection, this, loop,
+                  std::placeholders::_1, std::placeholders::_2));
+  }
+}
+
+TcpServer::~TcpServer()
+{
+  loop_->assertInLoopThread();
+
+  // Acceptor的Channel只能在它自己的loop线程中注销，逐个转交过去并等待完成，之后IO线程池才会被析构
+  if (!loopAcceptors_.empty())
+  {
+    CountDownLatch latch(static_cast<int>(loopAcceptors_.size()));
+    for (std::unique_ptr<Acceptor>& acceptor : loopAcceptors_)
+    {
+      Acceptor* a = acceptor.release();
+      a->getLoop()->runInLoop([a, &latch]() {
+        delete a;
+        latch.countDown();
+      });
+    }
+    latch.wait();
+    loopAcceptors_.clear();
+  }
+
+  ConnectionMap connections;
+  {
+    MutexLockGuard lock(mutex_);
+    connections.swap(connections_);
+  }
+  for (auto& item : connections)
+  {
+    TcpConnectionPtr conn(item.second);
+    item.second.reset();
+    conn->getLoop()->runInLoop(
+      std::bind(&TcpConnection::connectDestroyed, conn));
+  }
+}
+
+void TcpServer::setThreadNum(int numThreads)
+{
+  assert(0 <= numThreads);
+  threadPool_->setThreadNum(numThreads);
+}
+
+void TcpServer::setCpuMap(const CpuMap& cpuMap)
+{
+  threadPool_->setCpuMap(cpuMap);
+}
+
+void TcpServer::setPollerBackend(EventLoop::PollerBackend backend)
+{
+  threadPool_->setPollerBackend(backend);
+}
+
+void TcpServer::start()
+{
+  if (started_.getAndSet(1) == 0)
+  {
+    threadPool_->start(threadInitCallback_);
+
+    if (option_ == kReusePortPerLoop)
+    {
+      // 在当前线程中创建并bind所有监听socket，端口被占用可以在start()中就暴露出来；
+      // listen和注册Channel交给各自的IO线程
+      std::vector<EventLoop*> ioLoops = threadPool_->getAllLoops();
+      CountDownLatch listened(static_cast<int>(ioLoops.size()));
+      // 监听0号端口时每个socket都会分到一个不同的临时端口，内核就没法在它们之间分发连接了：
+      // 第一个socket bind之后，其余的socket都bind到它分到的端口上
+      InetAddress bindAddr(listenAddr_);
+      for (EventLoop* ioLoop : ioLoops)
+      {
+        Acceptor* acceptor = new Acceptor(ioLoop, bindAddr, true);
+        if (bindAddr.port() == 0)
+        {
+          bindAddr = acceptor->localAddress();
+        }
+        acceptor->setNewConnectionCallback(
+            std::bind(&TcpServer::newConnection, this, ioLoop,
+                      std::placeholders::_1, std::placeholders::_2));
+        loopAcceptors_.push_back(std::unique_ptr<Acceptor>(acceptor));
+        ioLoop->runInLoop([acceptor, &listened] {
+          acceptor->listen();
+          listened.countDown();
+        });
+      }
+      // 等所有IO线程都listen了再返回，start()之后马上来的连接不会被拒绝。
+      // 没有IO线程时唯一的loop就是baseLoop，它可能还没有开始循环，不能等
+      if (ioLoops.size() != 1 || ioLoops[0] != loop_)
+      {
+        listened.wait();
+      }
+    }
+    else
+    {
+      assert(!acceptor_->listening());
+      loop_->runInLoop(
+          std::bind(&Acceptor::listen, acceptor_.get()));
+    }
+  }
+}
+
+size_t TcpServer::numConnections() const
+{
+  MutexLockGuard lock(mutex_);
+  return connections_.size();
+}
+
+void TcpServer::newConnection(EventLoop* acceptLoop, int sockfd, const InetAddress& peerAddr)
+{
+  acceptLoop->assertInLoopThread();
+  // 每个loop自己accept时连接就留在这个loop上；否则从线程池中轮流挑一个
+  EventLoop* ioLoop = option_ == kReusePortPerLoop ? acceptLoop : threadPool_->getNextLoop();
+  char buf[64];
+  snprintf(buf, sizeof buf, "-%s#%d", ipPort_.c_str(), nextConnId_.incrementAndGet());
+  string connName = name_ + buf;
+
+  InetAddress localAddr(sockets::getLocalAddr(sockfd));
+  // 连接对象和shared_ptr的控制块放在SlabAllocator的同一个块里，建立和销毁连接都不经过malloc
+  TcpConnectionPtr conn = ObjectPool<TcpConnection>::makeShared(ioLoop,
+                                                                connName,
+                                                                sockfd,
+                                                                localAddr,
+                                                                peerAddr);
+  {
+    MutexLockGuard lock(mutex_);
+    connections_[connName] = conn;
+  }
+  conn->setConnectionCallback(connectionCallback_);
+  conn->setMessageCallback(messageCallback_);
+  conn->setWriteCompleteCallback(writeCompleteCallback_);
+  conn->setCloseCallback(
+      std::bind(&TcpServer::removeConnection, this, std::placeholders::_1)); // FIXME: unsafe
+  ioLoop->runInLoop(std::bind(&TcpConnection::connectEstablished, conn));
+}
+
+void TcpServer::removeConnection(const TcpConnectionPtr& conn)
+{
+  size_t n = 0;
+  {
+    MutexLockGuard lock(mutex_);
+    n = connections_.erase(conn->name());
+  }
+  (void)n;
+  assert(n == 1);
+  EventLoop* ioLoop = conn->getLoop();
+  ioLoop->queueInLoop(
+      std::bind(&TcpConnection::connectDestroyed, conn));
+}
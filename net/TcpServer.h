@@ -0,0 +1,127 @@
+#ifndef BO_NET_NET_TCPSERVER_H
+#define BO_NET_NET_TCPSERVER_H
+
+#include "base/Atomic.h"
+#include "base/Mutex.h"
+#include "base/Types.h"
+#include "base/noncopyable.h"
+#include "net/EventLoop.h"
+#include "net/TcpConnection.h"
+
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace bo_net
+{
+
+namespace net
+{
+
+class Acceptor;
+class EventLoopThreadPool;
+
+// TCP server, supports single-threaded and thread-pool models.
+//
+// 三种接受连接的方式：
+// - kNoReusePort：一个Acceptor在baseLoop中accept，新连接轮流分给各个IO线程；
+// - kReusePort：同上，只是监听socket带上SO_REUSEPORT，可以和其他进程共享端口；
+// - kReusePortPerLoop：每个IO线程各自持有一个SO_REUSEPORT的监听socket，由内核把新连接分散到各个socket上，
+//   连接在accept它的IO线程中建立和处理，没有线程间的转交，baseLoop也不再是连接建立速率的瓶颈
+class TcpServer : noncopyable
+{
+    public:
+        typedef std::function<void(EventLoop*)> ThreadInitCallback;
+        typedef std::vector<std::vector<int> > CpuMap;
+        enum Option
+        {
+            kNoReusePort,
+            kReusePort,
+            kReusePortPerLoop,
+        };
+
+        TcpServer(EventLoop *loop,
+                  const InetAddress &listenAddr,
+                  const string &nameArg,
+                  Option option = kNoReusePort);
+        ~TcpServer();  // force out-line dtor, for std::unique_ptr members.
+
+        const string& ipPort() const { return ipPort_; }
+        const string& name() const { return name_; }
+        EventLoop* getLoop() const { return loop_; }
+
+        // Set the number of threads for handling input.
+        //
+        // Always accepts new connection in loop's thread.
+        // Must be called before @c start
+        // @param numThreads
+        // - 0 means all I/O in loop's thread, no thread will created.
+        //   this is the default value.
+        // - 1 means all I/O in another thread.
+        // - N means a thread pool with N threads, new connections
+        //   are assigned on a round-robin basis.
+        void setThreadNum(int numThreads);
+
+        // 第i个IO线程绑定到cpuMap[i]中的CPU上，必须在start()之前调用
+        void setCpuMap(const CpuMap &cpuMap);
+
+        // IO线程的EventLoop使用的后端（epoll或io_uring），必须在start()之前调用。baseLoop的后端由它的创建者决定
+        void setPollerBackend(EventLoop::PollerBackend backend);
+
+        void setThreadInitCallback(const ThreadInitCallback &cb) { threadInitCallback_ = cb; }
+
+        // valid after calling start()
+        std::shared_ptr<EventLoopThreadPool> threadPool() { return threadPool_; }
+
+        // Starts the server if it's not listening.
+        //
+        // It's harmless to call it multiple times.
+        // Thread safe.
+        void start();
+
+        // Set connection callback.
+        // Not thread safe.
+        void setConnectionCallback(const ConnectionCallback &cb) { connectionCallback_ = cb; }
+
+        // Set message callback.
+        // Not thread safe.
+        void setMessageCallback(const MessageCallback &cb) { messageCallback_ = cb; }
+
+        // Set write complete callback.
+        // Not thread safe.
+        void setWriteCompleteCallback(const WriteCompleteCallback &cb) { writeCompleteCallback_ = cb; }
+
+        size_t numConnections() const;
+
+    private:
+        // 在accept该连接的Acceptor所在的线程中调用
+        void newConnection(EventLoop *acceptLoop, int sockfd, const InetAddress &peerAddr);
+        // Thread safe.
+        void removeConnection(const TcpConnectionPtr &conn);
+
+        typedef std::map<string, TcpConnectionPtr> ConnectionMap;
+
+        EventLoop *loop_;  // the acceptor loop
+        const InetAddress listenAddr_;
+        const string ipPort_;
+        const string name_;
+        const Option option_;
+        std::unique_ptr<Acceptor> acceptor_; // kNoReusePort/kReusePort
+        std::vector<std::unique_ptr<Acceptor> > loopAcceptors_; // kReusePortPerLoop，每个IO线程一个
+        std::shared_ptr<EventLoopThreadPool> threadPool_;
+        ConnectionCallback connectionCallback_;
+        MessageCallback messageCallback_;
+        WriteCompleteCallback writeCompleteCallback_;
+        ThreadInitCallback threadInitCallback_;
+        AtomicInt32 started_;
+        AtomicInt32 nextConnId_;
+        // kReusePortPerLoop模式下多个IO线程同时增删连接，所以用锁保护，临界区只有一次map操作
+        mutable MutexLock mutex_;
+        ConnectionMap connections_ GUARDED_BY(mutex_);
+};
+
+} // namespace net
+
+} // namespace bo_net
+
+#endif // BO_NET_NET_TCPSERVER_H
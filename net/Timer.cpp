@@ -0,0 +1,18 @@
+#include "net/Timer.h"
+
+using namespace bo_net;
+using namespace bo_net::net;
+
+AtomicInt64 Timer::s_numCreated_;
+
+void Timer::restart(Timestamp now)
+{
+  if (repeat_)
+  {
+    expiration_ = addTime(now, interval_);
+  }
+  else
+  {
+    expiration_ = Timestamp::invalid();
+  }
+}
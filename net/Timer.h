@@ -0,0 +1,81 @@
+#ifndef BO_NET_NET_TIMER_H
+#define BO_NET_NET_TIMER_H
+
+#include "base/Atomic.h"
+#include "base/ObjectPool.h"
+#include "base/Timestamp.h"
+#include "base/noncopyable.h"
+#include "net/Callbacks.h"
+
+namespace bo_net
+{
+
+namespace net
+{
+
+// Internal class for timer event.
+// 精确定时器放在TimerQueue的有序集合里；粗粒度定时器挂在TimingWheel某个槽位的侵入式链表上，
+// next_/pprev_就是链表指针，这样从轮子上摘下或者换一个槽位都是O(1)的，也不需要额外分配链表节点。
+// 每个定时器都是单独new出来的，从SlabAllocator分配，大量短命的定时器不会和其他对象争抢malloc
+class Timer : noncopyable, public PoolAllocated
+{
+    public:
+        Timer(TimerCallback cb, Timestamp when, double interval, bool coarse)
+            : callback_(std::move(cb)),
+              expiration_(when),
+              interval_(interval),
+              repeat_(interval > 0.0),
+              coarse_(coarse),
+              running_(false),
+              canceled_(false),
+              sequence_(s_numCreated_.incrementAndGet()),
+              next_(NULL),
+              pprev_(NULL)
+        {
+        }
+
+        void run() const {
+            callback_();
+        }
+
+        Timestamp expiration() const { return expiration_; }
+        void setExpiration(Timestamp when) { expiration_ = when; }
+        bool repeat() const { return repeat_; }
+        bool coarse() const { return coarse_; }
+        int64_t sequence() const { return sequence_; }
+
+        // 到期回调执行期间为true，此时定时器既不在有序集合里也不在时间轮上
+        bool running() const { return running_; }
+        void setRunning(bool on) { running_ = on; }
+        bool canceled() const { return canceled_; }
+        void cancel() { canceled_ = true; }
+
+        void restart(Timestamp now);
+
+        static int64_t numCreated() { return s_numCreated_.get(); }
+
+    private:
+        friend class TimingWheel;
+
+        const TimerCallback callback_;
+        Timestamp    expiration_;
+        const double interval_;
+        const bool   repeat_;
+        const bool   coarse_;
+        bool         running_;
+        bool         canceled_;
+        const int64_t sequence_;
+
+        // 由TimingWheel使用，同Linux内核的hlist：pprev_指向前一个节点的next_（或者槽位的表头），
+        // 摘除节点时不需要知道它在哪个槽位
+        Timer  *next_;
+        Timer **pprev_;
+
+        static AtomicInt64 s_numCreated_;
+};
+
+} // namespace net
+
+} // namespace bo_net
+
+#endif // BO_NET_NET_TIMER_H
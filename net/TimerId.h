@@ -0,0 +1,47 @@
+#ifndef BO_NET_NET_TIMERID_H
+#define BO_NET_NET_TIMERID_H
+
+#include "base/copyable.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace bo_net
+{
+
+namespace net
+{
+
+class Timer;
+
+// An opaque identifier, for canceling Timer.
+// TimerQueue只用sequence_查找定时器，timer_仅供调试；定时器已经到期释放之后再cancel也是安全的
+class TimerId : public bo_net::copyable
+{
+    public:
+        TimerId()
+            : timer_(NULL),
+              sequence_(0)
+        {
+        }
+
+        TimerId(Timer *timer, int64_t seq)
+            : timer_(timer),
+              sequence_(seq)
+        {
+        }
+
+        // default copy-ctor, dtor and assignment are okay
+
+        friend class TimerQueue;
+
+    private:
+        Timer  *timer_;
+        int64_t sequence_;
+};
+
+} // namespace net
+
+} // namespace bo_net
+
+#endif // BO_NET_NET_TIMERID_H
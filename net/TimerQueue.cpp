@@ -0,0 +1,304 @@
+#include "net/TimerQueue.h"
+#include "net/EventLoop.h"
+#include "net/Timer.h"
+#include "net/TimerId.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+using namespace bo_net;
+using namespace bo_net::net;
+
+namespace
+{
+
+int createTimerfd()
+{
+  int timerfd = ::timerfd_create(CLOCK_MONOTONIC,
+                                 TFD_NONBLOCK | TFD_CLOEXEC);
+  if (timerfd < 0)
+  {
+    fprintf(stderr, "Failed in timerfd_create: %s\n", strerror(errno));
+    abort();
+  }
+  return timerfd;
+}
+
+struct timespec howMuchTimeFromNow(Timestamp when)
+{
+  int64_t microseconds = when.microSecondsSinceEpoth()
+                         - Timestamp::now().microSecondsSinceEpoth();
+  if (microseconds < 100)
+  {
+    microseconds = 100;
+  }
+  struct timespec ts;
+  ts.tv_sec = static_cast<time_t>(
+      microseconds / Timestamp::kMicroSecondsPerSecond);
+  ts.tv_nsec = static_cast<long>(
+      (microseconds % Timestamp::kMicroSecondsPerSecond) * 1000);
+  return ts;
+}
+
+void readTimerfd(int timerfd)
+{
+  uint64_t howmany;
+  ssize_t n = ::read(timerfd, &howmany, sizeof howmany);
+  if (n != sizeof howmany && errno != EAGAIN)
+  {
+    fprintf(stderr, "TimerQueue::handleRead() reads %zd bytes instead of 8\n", n);
+  }
+}
+
+}  // namespace
+
+TimerQueue::TimerQueue(EventLoop* loop)
+  : loop_(loop),
+    timerfd_(createTimerfd()),
+    timerfdChannel_(loop, timerfd_),
+    timers_(),
+    wheel_(static_cast<int64_t>(kCoarseTickMs) * 1000, Timestamp::now()),
+    armed_(Timestamp::invalid())
+{
+  timerfdChannel_.setReadCallback(
+      std::bind(&TimerQueue::handleRead, this));
+  // we are always reading the timerfd, we disarm it with timerfd_settime.
+  timerfdChannel_.enableReading();
+}
+
+TimerQueue::~TimerQueue()
+{
+  timerfdChannel_.disableAll();
+  timerfdChannel_.remove();
+  ::close(timerfd_);
+  // 有序集合和时间轮都不拥有定时器，所有定时器都在activeTimers_里
+  for (const ActiveTimerMap::value_type& item : activeTimers_)
+  {
+    delete item.second;
+  }
+}
+
+TimerId TimerQueue::addTimer(TimerCallback cb,
+                             Timestamp when,
+                             double interval)
+{
+  Timer* timer = new Timer(std::move(cb), when, interval, false);
+  loop_->runInLoop(
+      std::bind(&TimerQueue::addTimerInLoop, this, timer));
+  return TimerId(timer, timer->sequence());
+}
+
+TimerId TimerQueue::addCoarseTimer(TimerCallback cb,
+                                   Timestamp when,
+                                   double interval)
+{
+  Timer* timer = new Timer(std::move(cb), when, interval, true);
+  loop_->runInLoop(
+      std::bind(&TimerQueue::addTimerInLoop, this, timer));
+  return TimerId(timer, timer->sequence());
+}
+
+void TimerQueue::refresh(TimerId timerId, Timestamp when)
+{
+  // 在IO线程中直接修改，不经过runInLoop，避免每次推迟超时都构造一个std::function
+  if (loop_->isInLoopThread())
+  {
+    refreshInLoop(timerId, when);
+  }
+  else
+  {
+    loop_->queueInLoop(
+        std::bind(&TimerQueue::refreshInLoop, this, timerId, when));
+  }
+}
+
+void TimerQueue::cancel(TimerId timerId)
+{
+  if (loop_->isInLoopThread())
+  {
+    cancelInLoop(timerId);
+  }
+  else
+  {
+    loop_->queueInLoop(
+        std::bind(&TimerQueue::cancelInLoop, this, timerId));
+  }
+}
+
+void TimerQueue::addTimerInLoop(Timer* timer)
+{
+  loop_->assertInLoopThread();
+  activeTimers_[timer->sequence()] = timer;
+  insert(timer);
+}
+
+void TimerQueue::cancelInLoop(TimerId timerId)
+{
+  loop_->assertInLoopThread();
+  ActiveTimerMap::iterator it = activeTimers_.find(timerId.sequence_);
+  if (it == activeTimers_.end())
+  {
+    return;
+  }
+  Timer* timer = it->second;
+  activeTimers_.erase(it);
+  if (timer->running())
+  {
+    // 定时器自己的回调里取消自己（比如取消一个重复定时器），回调结束之后在reset()里释放
+    timer->cancel();
+  }
+  else
+  {
+    unlink(timer);
+    delete timer;
+  }
+}
+
+void TimerQueue::refreshInLoop(TimerId timerId, Timestamp when)
+{
+  loop_->assertInLoopThread();
+  ActiveTimerMap::iterator it = activeTimers_.find(timerId.sequence_);
+  if (it == activeTimers_.end())
+  {
+    return;
+  }
+  Timer* timer = it->second;
+  if (timer->running())
+  {
+    // 定时器在本轮到期的这一批里（自己的回调正在执行，或者排在后面还没有执行）：
+    // 还没执行的会被handleRead()跳过，reset()看到到期时间在将来，会按新的到期时间重新放入
+    timer->setExpiration(when);
+    return;
+  }
+  unlink(timer);
+  timer->setExpiration(when);
+  insert(timer);
+}
+
+void TimerQueue::handleRead()
+{
+  loop_->assertInLoopThread();
+  Timestamp now(Timestamp::now());
+  readTimerfd(timerfd_);
+  armed_ = Timestamp::invalid();
+
+  expired_.clear();
+  // 到期时间相同的定时器按指针排序，用最大的指针值作为哨兵，取出所有到期时间<= now的定时器
+  Entry sentry(now, reinterpret_cast<Timer*>(UINTPTR_MAX));
+  TimerList::iterator end = timers_.lower_bound(sentry);
+  for (TimerList::iterator it = timers_.begin(); it != end; ++it)
+  {
+    expired_.push_back(it->second);
+  }
+  timers_.erase(timers_.begin(), end);
+  wheel_.advance(now, &expired_);
+
+  for (Timer* timer : expired_)
+  {
+    timer->setRunning(true);
+  }
+  for (Timer* timer : expired_)
+  {
+    // 前面的回调可能已经取消了后面的定时器，或者把它refresh到了将来：
+    // 后一种情况这次不能执行，reset()看到到期时间在将来，会按新的到期时间重新放入
+    if (!timer->canceled() && !(now < timer->expiration()))
+    {
+      timer->run();
+    }
+  }
+  reset(now);
+}
+
+void TimerQueue::reset(Timestamp now)
+{
+  for (Timer* timer : expired_)
+  {
+    timer->setRunning(false);
+    if (timer->canceled())
+    {
+      // 已经从activeTimers_中删掉了
+      delete timer;
+    }
+    else if (now < timer->expiration())
+    {
+      // 回调中被refresh到了将来的某个时刻
+      insert(timer);
+    }
+    else if (timer->repeat())
+    {
+      timer->restart(now);
+      insert(timer);
+    }
+    else
+    {
+      activeTimers_.erase(timer->sequence());
+      delete timer;
+    }
+  }
+  expired_.clear();
+
+  Timestamp nextExpire = wheel_.nextExpiration();
+  if (!timers_.empty() && (!nextExpire.valid() || timers_.begin()->first < nextExpire))
+  {
+    nextExpire = timers_.begin()->first;
+  }
+  if (nextExpire.valid())
+  {
+    armTimerfd(nextExpire);
+  }
+}
+
+void TimerQueue::insert(Timer* timer)
+{
+  loop_->assertInLoopThread();
+  Timestamp when;
+  if (timer->coarse())
+  {
+    wheel_.add(timer);
+    when = wheel_.roundUp(timer->expiration());
+  }
+  else
+  {
+    when = timer->expiration();
+    std::pair<TimerList::iterator, bool> result = timers_.insert(Entry(when, timer));
+    assert(result.second); (void)result;
+  }
+  armTimerfd(when);
+}
+
+void TimerQueue::unlink(Timer* timer)
+{
+  if (timer->coarse())
+  {
+    wheel_.remove(timer);
+  }
+  else
+  {
+    size_t n = timers_.erase(Entry(timer->expiration(), timer));
+    assert(n == 1); (void)n;
+  }
+}
+
+void TimerQueue::armTimerfd(Timestamp when)
+{
+  // 只会把timerfd往前调；定时器被取消或者推迟之后timerfd可能白白触发一次，handleRead()会按新的最早时间重新设置
+  if (armed_.valid() && !(when < armed_))
+  {
+    return;
+  }
+  armed_ = when;
+  struct itimerspec newValue;
+  memZero(&newValue, sizeof newValue);
+  newValue.it_value = howMuchTimeFromNow(when);
+  int ret = ::timerfd_settime(timerfd_, 0, &newValue, NULL);
+  if (ret)
+  {
+    fprintf(stderr, "timerfd_settime() failed: %s\n", strerror(errno));
+  }
+}
@@ -0,0 +1,85 @@
+#ifndef BO_NET_NET_TIMERQUEUE_H
+#define BO_NET_NET_TIMERQUEUE_H
+
+#include "base/Timestamp.h"
+#include "base/noncopyable.h"
+#include "net/Callbacks.h"
+#include "net/Channel.h"
+#include "net/TimingWheel.h"
+
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+namespace bo_net
+{
+
+namespace net
+{
+
+class EventLoop;
+class Timer;
+class TimerId;
+
+// 定时器队列，所有到期时间都用Timestamp表示，整个队列共用一个timerfd，按最早的到期时间设置它。
+//
+// 定时器分两种：
+// - 精确定时器放在按到期时间排序的std::set里，增删是O(log n)，准时触发；
+// - 粗粒度定时器放在TimingWheel上，增删改都是O(1)，触发时间向上取整到kCoarseTickMs毫秒。
+//   连接的空闲超时每收到一次数据就要推迟一次，用refresh()在原来的定时器上修改到期时间，不需要cancel再add
+//
+// 对外接口可以跨线程调用，实际的修改都在IO线程中执行
+class TimerQueue : noncopyable
+{
+    public:
+        // 粗粒度定时器的tick
+        static const int kCoarseTickMs = 10;
+
+        explicit TimerQueue(EventLoop *loop);
+        ~TimerQueue();
+
+        // 在when时刻执行cb，interval > 0.0时每隔interval秒重复执行
+        TimerId addTimer(TimerCallback cb, Timestamp when, double interval);
+
+        // 同addTimer，但是放在时间轮上，最多晚kCoarseTickMs毫秒触发
+        TimerId addCoarseTimer(TimerCallback cb, Timestamp when, double interval);
+
+        // 把还没有到期的定时器改到when时刻触发，定时器已经到期释放或者被取消时什么也不做
+        void refresh(TimerId timerId, Timestamp when);
+
+        void cancel(TimerId timerId);
+
+    private:
+        typedef std::pair<Timestamp, Timer*> Entry;
+        typedef std::set<Entry> TimerList;
+        typedef std::unordered_map<int64_t, Timer*> ActiveTimerMap;
+
+        void addTimerInLoop(Timer *timer);
+        void cancelInLoop(TimerId timerId);
+        void refreshInLoop(TimerId timerId, Timestamp when);
+        // called when timerfd alarms
+        void handleRead();
+
+        // 把定时器放入有序集合或者时间轮，必要时提前timerfd
+        void insert(Timer *timer);
+        void unlink(Timer *timer);
+        void reset(Timestamp now);
+        void armTimerfd(Timestamp when);
+
+        EventLoop *loop_;
+        const int timerfd_;
+        Channel   timerfdChannel_;
+        // Timer list sorted by expiration
+        TimerList   timers_;
+        TimingWheel wheel_;
+        // 所有还没有被释放的定时器，sequence -> Timer，cancel/refresh用它O(1)地找到定时器
+        ActiveTimerMap activeTimers_;
+        std::vector<Timer*> expired_;
+        Timestamp armed_;   // timerfd当前被设置的到期时刻，没有设置时为invalid
+};
+
+} // namespace net
+
+} // namespace bo_net
+
+#endif // BO_NET_NET_TIMERQUEUE_H
@@ -0,0 +1,168 @@
+#include "net/TimingWheel.h"
+#include "net/Timer.h"
+
+#include <assert.h>
+
+using namespace bo_net;
+using namespace bo_net::net;
+
+TimingWheel::TimingWheel(int64_t tickMicroSeconds, Timestamp now)
+  : tickMicroSeconds_(tickMicroSeconds),
+    currentTick_(0),
+    size_(0)
+{
+  assert(tickMicroSeconds > 0);
+  currentTick_ = floorTick(now);
+  memZero(root_, sizeof root_);
+  memZero(levels_, sizeof levels_);
+}
+
+Timer** TimingWheel::slotFor(int64_t expires)
+{
+  int64_t idx = expires - currentTick_;
+  if (idx < 0)
+  {
+    // 已经过期的定时器放进当前槽位，下一次advance就会触发
+    return &root_[currentTick_ & (kRootSize - 1)];
+  }
+  if (idx < kRootSize)
+  {
+    return &root_[expires & (kRootSize - 1)];
+  }
+  if (idx > kMaxTicks)
+  {
+    // 超出时间轮的范围，先放在最高层能表示的最远处，降级时会按真正的到期时间重新分配
+    expires = currentTick_ + kMaxTicks;
+  }
+  int shift = kRootBits;
+  for (int level = 0; level < kLevels; ++level)
+  {
+    if (idx < (static_cast<int64_t>(1) << (shift + kLevelBits)) || level == kLevels - 1)
+    {
+      return &levels_[level][(expires >> shift) & (kLevelSize - 1)];
+    }
+    shift += kLevelBits;
+  }
+  assert(false);
+  return NULL;
+}
+
+void TimingWheel::link(Timer** head, Timer* timer)
+{
+  timer->next_ = *head;
+  if (*head)
+  {
+    (*head)->pprev_ = &timer->next_;
+  }
+  *head = timer;
+  timer->pprev_ = head;
+}
+
+void TimingWheel::add(Timer* timer)
+{
+  assert(timer->pprev_ == NULL);
+  if (size_ == 0)
+  {
+    // 空闲期间没有人调用advance，currentTick_停在上一次的位置；不先跟上当前时间的话，
+    // nextExpiration()会落在过去，下一次advance要把空闲期间的每个tick都走一遍
+    int64_t nowTick = floorTick(Timestamp::now());
+    if (nowTick > currentTick_)
+    {
+      currentTick_ = nowTick;
+    }
+  }
+  link(slotFor(ceilTick(timer->expiration())), timer);
+  ++size_;
+}
+
+void TimingWheel::remove(Timer* timer)
+{
+  assert(timer->pprev_ != NULL);
+  *timer->pprev_ = timer->next_;
+  if (timer->next_)
+  {
+    timer->next_->pprev_ = timer->pprev_;
+  }
+  timer->next_ = NULL;
+  timer->pprev_ = NULL;
+  --size_;
+}
+
+int TimingWheel::cascade(int level, int index)
+{
+  Timer* timer = levels_[level][index];
+  levels_[level][index] = NULL;
+  while (timer)
+  {
+    Timer* next = timer->next_;
+    timer->next_ = NULL;
+    timer->pprev_ = NULL;
+    link(slotFor(ceilTick(timer->expiration())), timer);
+    timer = next;
+  }
+  return index;
+}
+
+void TimingWheel::advance(Timestamp now, std::vector<Timer*>* expired)
+{
+  const int64_t nowTick = floorTick(now);
+  while (currentTick_ <= nowTick)
+  {
+    if (size_ == 0)
+    {
+      // 轮上没有定时器时直接跳到now，定时器的位置都是相对currentTick_计算的，跳过去不影响正确性
+      currentTick_ = nowTick + 1;
+      break;
+    }
+
+    int index = static_cast<int>(currentTick_ & (kRootSize - 1));
+    if (index == 0)
+    {
+      int shift = kRootBits;
+      for (int level = 0; level < kLevels; ++level)
+      {
+        if (cascade(level, static_cast<int>((currentTick_ >> shift) & (kLevelSize - 1))) != 0)
+        {
+          break;
+        }
+        shift += kLevelBits;
+      }
+    }
+
+    Timer* timer = root_[index];
+    root_[index] = NULL;
+    while (timer)
+    {
+      Timer* next = timer->next_;
+      timer->next_ = NULL;
+      timer->pprev_ = NULL;
+      --size_;
+      expired->push_back(timer);
+      timer = next;
+    }
+    ++currentTick_;
+  }
+}
+
+Timestamp TimingWheel::nextExpiration() const
+{
+  if (size_ == 0)
+  {
+    return Timestamp::invalid();
+  }
+  const int index = static_cast<int>(currentTick_ & (kRootSize - 1));
+  if (index == 0)
+  {
+    // 新的一圈还没有开始，上层的定时器还没有降级到第0层，下一个tick就要处理
+    return tickToTime(currentTick_);
+  }
+  for (int i = index; i < kRootSize; ++i)
+  {
+    if (root_[i])
+    {
+      return tickToTime(currentTick_ + (i - index));
+    }
+  }
+  // 本圈剩下的槽位都是空的，到下一圈开始时再看
+  return tickToTime(currentTick_ - index + kRootSize);
+}
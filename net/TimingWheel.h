@@ -0,0 +1,93 @@
+#ifndef BO_NET_NET_TIMINGWHEEL_H
+#define BO_NET_NET_TIMINGWHEEL_H
+
+#include "base/Timestamp.h"
+#include "base/noncopyable.h"
+
+#include <vector>
+
+namespace bo_net
+{
+
+namespace net
+{
+
+class Timer;
+
+/**
+ * 分层时间轮，结构同Linux内核早期的定时器（tv1 ~ tv5）：
+ * 第0层256个槽位，每个槽位一个tick；第1~4层各64个槽位，每个槽位分别覆盖2^8、2^14、2^20、2^26个tick。
+ * 定时器按到期tick与当前tick的距离放进对应的层，低层转完一圈时把上一层的一个槽位"降级"重新分配到下面各层。
+ *
+ * 添加、删除、修改到期时间都是O(1)，代价是到期时间被向上取整到tick：定时器只会晚到、不会早到，最多晚一个tick。
+ * 适合连接的空闲超时、读超时这类数量多、经常被推迟、很少真正到期、对精度要求不高的定时器。
+ *
+ * 不是线程安全的，由TimerQueue在IO线程中使用；TimingWheel不拥有Timer
+*/
+class TimingWheel : noncopyable
+{
+    public:
+        TimingWheel(int64_t tickMicroSeconds, Timestamp now);
+
+        // 按timer->expiration()放入时间轮，timer不能已经在轮上。
+        // 时间轮为空时先把当前tick推进到Timestamp::now()，和advance()使用同一个时钟
+        void add(Timer *timer);
+
+        // 从时间轮上摘下timer
+        void remove(Timer *timer);
+
+        // 把时间推进到now，所有到期的定时器从轮上摘下并追加到expired中
+        void advance(Timestamp now, std::vector<Timer*> *expired);
+
+        // 下一次需要调用advance的时刻，时间轮为空时返回Timestamp::invalid()。
+        // 第0层本圈内没有定时器时返回本圈结束的时刻，届时要把上层的定时器降级下来，
+        // 所以返回值可能早于真正最早的到期时间，但一定不会晚于它
+        Timestamp nextExpiration() const;
+
+        // 定时器实际会被触发的时刻，即expiration向上取整到tick
+        Timestamp roundUp(Timestamp expiration) const {
+            return tickToTime(ceilTick(expiration));
+        }
+
+        size_t size() const { return size_; }
+        int64_t tickMicroSeconds() const { return tickMicroSeconds_; }
+
+    private:
+        static const int kRootBits = 8;
+        static const int kLevelBits = 6;
+        static const int kRootSize = 1 << kRootBits;
+        static const int kLevelSize = 1 << kLevelBits;
+        static const int kLevels = 4;   // 第0层之外的层数
+        static const int64_t kMaxTicks = (static_cast<int64_t>(1) << (kRootBits + kLevels * kLevelBits)) - 1;
+
+        int64_t ceilTick(Timestamp when) const {
+            int64_t us = when.microSecondsSinceEpoth();
+            return (us + tickMicroSeconds_ - 1) / tickMicroSeconds_;
+        }
+
+        int64_t floorTick(Timestamp when) const {
+            return when.microSecondsSinceEpoth() / tickMicroSeconds_;
+        }
+
+        Timestamp tickToTime(int64_t tick) const {
+            return Timestamp(tick * tickMicroSeconds_);
+        }
+
+        Timer** slotFor(int64_t expires);
+        void link(Timer **head, Timer *timer);
+        // 把上层index号槽位中的定时器全部重新分配，返回index，为0说明这一层也转完了一圈
+        int cascade(int level, int index);
+
+        const int64_t tickMicroSeconds_;
+        int64_t currentTick_;   // 下一个要处理的tick
+        size_t  size_;
+
+        Timer *root_[kRootSize];
+        Timer *levels_[kLevels][kLevelSize];
+};
+
+} // namespace net
+
+} // namespace bo_net
+
+#endif // BO_NET_NET_TIMINGWHEEL_H
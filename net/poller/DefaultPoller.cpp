@@ -0,0 +1,33 @@
+#include "net/Poller.h"
+#include "net/poller/EPollPoller.h"
+#include "net/poller/IoUringPoller.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+using namespace bo_net::net;
+
+Poller* Poller::newDefaultPoller(EventLoop* loop)
+{
+  EventLoop::PollerBackend backend = defaultBackend();
+  return newPoller(loop, &backend);
+}
+
+Poller* Poller::newPoller(EventLoop* loop, EventLoop::PollerBackend* backend)
+{
+  if (*backend == EventLoop::kIoUring)
+  {
+    if (IoUringPoller::isSupported())
+    {
+      return new IoUringPoller(loop);
+    }
+    fprintf(stderr, "Poller: io_uring is not available, falling back to epoll\n");
+    *backend = EventLoop::kEpoll;
+  }
+  return new EPollPoller(loop);
+}
+
+EventLoop::PollerBackend Poller::defaultBackend()
+{
+  return ::getenv("BO_NET_USE_IO_URING") ? EventLoop::kIoUring : EventLoop::kEpoll;
+}
@@ -0,0 +1,165 @@
+#include "net/poller/EPollPoller.h"
+#include "net/Channel.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+
+using namespace bo_net;
+using namespace bo_net::net;
+
+namespace
+{
+// Channel::index()的取值
+const int kNew = -1;
+const int kAdded = 1;
+const int kDeleted = 2;
+}  // namespace
+
+EPollPoller::EPollPoller(EventLoop* loop)
+  : Poller(loop),
+    epollfd_(::epoll_create1(EPOLL_CLOEXEC)),
+    events_(kInitEventListSize)
+{
+  if (epollfd_ < 0)
+  {
+    fprintf(stderr, "EPollPoller: epoll_create1 failed: %s\n", strerror(errno));
+    abort();
+  }
+}
+
+EPollPoller::~EPollPoller()
+{
+  ::close(epollfd_);
+}
+
+Timestamp EPollPoller::poll(int timeoutMs, ChannelList* activeChannels)
+{
+  int numEvents = ::epoll_wait(epollfd_,
+                               &*events_.begin(),
+                               static_cast<int>(events_.size()),
+                               timeoutMs);
+  int savedErrno = errno;
+  Timestamp now(Timestamp::now());
+  if (numEvents > 0)
+  {
+    fillActiveChannels(numEvents, activeChannels);
+    if (static_cast<size_t>(numEvents) == events_.size())
+    {
+      events_.resize(events_.size()*2);
+    }
+  }
+  else if (numEvents < 0 && savedErrno != EINTR)
+  {
+    fprintf(stderr, "EPollPoller::poll() failed: %s\n", strerror(savedErrno));
+  }
+  return now;
+}
+
+void EPollPoller::fillActiveChannels(int numEvents,
+                                     ChannelList* activeChannels) const
+{
+  assert(static_cast<size_t>(numEvents) <= events_.size());
+  for (int i = 0; i < numEvents; ++i)
+  {
+    Channel* channel = static_cast<Channel*>(events_[i].data.ptr);
+    channel->set_revents(events_[i].events);
+    activeChannels->push_back(channel);
+  }
+}
+
+void EPollPoller::updateChannel(Channel* channel)
+{
+  Poller::assertInLoopThread();
+  const int index = channel->index();
+  if (index == kNew || index == kDeleted)
+  {
+    int fd = channel->fd();
+    if (index == kNew)
+    {
+      assert(channels_.find(fd) == channels_.end());
+      channels_[fd] = channel;
+    }
+    else
+    {
+      assert(channels_.find(fd) != channels_.end());
+      assert(channels_[fd] == channel);
+    }
+    channel->set_index(kAdded);
+    update(EPOLL_CTL_ADD, channel);
+  }
+  else
+  {
+    assert(channels_.find(channel->fd()) != channels_.end());
+    assert(channels_[channel->fd()] == channel);
+    assert(index == kAdded);
+    // 不关心任何事件时从epoll中删掉，但仍然留在channels_里，之后可以直接ADD回来
+    if (channel->isNoneEvent())
+    {
+      update(EPOLL_CTL_DEL, channel);
+      channel->set_index(kDeleted);
+    }
+    else
+    {
+      update(EPOLL_CTL_MOD, channel);
+    }
+  }
+}
+
+void EPollPoller::removeChannel(Channel* channel)
+{
+  Poller::assertInLoopThread();
+  int fd = channel->fd();
+  assert(channels_.find(fd) != channels_.end());
+  assert(channels_[fd] == channel);
+  assert(channel->isNoneEvent());
+  int index = channel->index();
+  assert(index == kAdded || index == kDeleted);
+  size_t n = channels_.erase(fd);
+  (void)n;
+  assert(n == 1);
+
+  if (index == kAdded)
+  {
+    update(EPOLL_CTL_DEL, channel);
+  }
+  channel->set_index(kNew);
+}
+
+void EPollPoller::update(int operation, Channel* channel)
+{
+  struct epoll_event event;
+  memZero(&event, sizeof event);
+  event.events = channel->events();
+  event.data.ptr = channel;
+  int fd = channel->fd();
+  if (::epoll_ctl(epollfd_, operation, fd, &event) < 0)
+  {
+    fprintf(stderr, "epoll_ctl op = %s fd = %d failed: %s\n",
+            operationToString(operation), fd, strerror(errno));
+    if (operation != EPOLL_CTL_DEL)
+    {
+      abort();
+    }
+  }
+}
+
+const char* EPollPoller::operationToString(int op)
+{
+  switch (op)
+  {
+    case EPOLL_CTL_ADD:
+      return "ADD";
+    case EPOLL_CTL_DEL:
+      return "DEL";
+    case EPOLL_CTL_MOD:
+      return "MOD";
+    default:
+      assert(false && "ERROR op");
+      return "Unknown Operation";
+  }
+}
@@ -0,0 +1,46 @@
+#ifndef BO_NET_NET_POLLER_EPOLLPOLLER_H
+#define BO_NET_NET_POLLER_EPOLLPOLLER_H
+
+#include "net/Poller.h"
+
+#include <vector>
+
+struct epoll_event;
+
+namespace bo_net
+{
+
+namespace net
+{
+
+// epoll(7)的封装。Channel的events_里带有EPOLLET时该fd以边沿触发方式注册，否则是水平触发
+class EPollPoller : public Poller
+{
+    public:
+        explicit EPollPoller(EventLoop *loop);
+        ~EPollPoller() override;
+
+        Timestamp poll(int timeoutMs, ChannelList *activeChannels) override;
+        void updateChannel(Channel *channel) override;
+        void removeChannel(Channel *channel) override;
+
+    private:
+        static const int kInitEventListSize = 16;
+
+        static const char* operationToString(int op);
+
+        void fillActiveChannels(int numEvents, ChannelList *activeChannels) const;
+        void update(int operation, Channel *channel);
+
+        typedef std::vector<struct epoll_event> EventList;
+
+        int epollfd_;
+        // 预先分配，每次epoll_wait都直接写入这里；某一轮把它填满了就翻倍，之后不再缩小
+        EventList events_;
+};
+
+} // namespace net
+
+} // namespace bo_net
+
+#endif // BO_NET_NET_POLLER_EPOLLPOLLER_H
@@ -0,0 +1,785 @@
+#include "net/poller/IoUringPoller.h"
+#include "net/Buffer.h"
+#include "net/Channel.h"
+
+#include <algorithm>
+#include <assert.h>
+#include <errno.h>
+#include <linux/io_uring.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// 编译时的内核头文件太旧（5.17以前没有CQE_SKIP）时整个后端不可用，isSupported()返回false；
+// multishot recv在6.0加入，provided buffer ring（5.19）的定义也就一定有；multishot accept在5.19加入
+#if defined(IOSQE_CQE_SKIP_SUCCESS) && defined(IORING_FEAT_CQE_SKIP)
+#define BO_NET_HAVE_IO_URING 1
+#if defined(IORING_RECV_MULTISHOT)
+#define BO_NET_HAVE_IO_URING_RECV 1
+#endif
+#if defined(IORING_ACCEPT_MULTISHOT)
+#define BO_NET_HAVE_IO_URING_ACCEPT 1
+#endif
+#endif
+
+using namespace bo_net;
+using namespace bo_net::net;
+
+#ifdef BO_NET_HAVE_IO_URING
+
+namespace
+{
+
+int sysIoUringSetup(unsigned entries, struct io_uring_params* p)
+{
+  return static_cast<int>(::syscall(__NR_io_uring_setup, entries, p));
+}
+
+int sysIoUringEnter(int fd, unsigned toSubmit, unsigned minComplete,
+                    unsigned flags, const void* arg, size_t argSize)
+{
+  return static_cast<int>(::syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, arg, argSize));
+}
+
+#ifdef BO_NET_HAVE_IO_URING_RECV
+int sysIoUringRegister(int fd, unsigned opcode, void* arg, unsigned nrArgs)
+{
+  return static_cast<int>(::syscall(__NR_io_uring_register, fd, opcode, arg, nrArgs));
+}
+#endif
+
+// 共享内存中的队列头尾由内核和用户态并发读写，按照io_uring的约定用acquire/release访问
+inline unsigned loadAcquire(const unsigned* p)
+{
+  return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+inline void storeRelease(unsigned* p, unsigned v)
+{
+  __atomic_store_n(p, v, __ATOMIC_RELEASE);
+}
+
+// 本Poller依赖的特性：单次mmap、CQ不丢事件、io_uring_enter带超时参数（5.11）、multishot poll（5.13）
+const unsigned kRequiredFeatures = IORING_FEAT_SINGLE_MMAP | IORING_FEAT_NODROP | IORING_FEAT_EXT_ARG;
+
+// user_data低32位：最高位为0时是poll请求的generation，为1时是recv/accept请求，
+// 这时次高位表示accept，其余30位分成注册序号（高16位）和请求序号（低14位）
+const uint32_t kRecvTag = 1u << 31;
+const uint32_t kAcceptTag = 1u << 30;
+const uint32_t kGenerationMask = kRecvTag - 1;
+const int kRecvSequenceBits = 14;
+const uint32_t kRecvSequenceMask = (1u << kRecvSequenceBits) - 1;
+const uint32_t kIncarnationMask = 0xffff;
+
+inline uint64_t makeUserData(int fd, uint32_t generation)
+{
+  return (static_cast<uint64_t>(fd) << 32) | (generation & kGenerationMask);
+}
+
+inline uint64_t makeRecvUserData(int fd, uint32_t incarnation, uint32_t sequence, bool accept)
+{
+  return (static_cast<uint64_t>(fd) << 32) | kRecvTag | (accept ? kAcceptTag : 0)
+      | ((incarnation & kIncarnationMask) << kRecvSequenceBits) | (sequence & kRecvSequenceMask);
+}
+
+bool probeIoUring()
+{
+  struct io_uring_params params;
+  memZero(&params, sizeof params);
+  int fd = sysIoUringSetup(4, &params);
+  if (fd < 0)
+  {
+    return false;
+  }
+  ::close(fd);
+  // FEAT_CQE_SKIP和multishot poll都在5.13左右加入，有它说明multishot poll也可用
+  return (params.features & kRequiredFeatures) == kRequiredFeatures
+      && (params.features & IORING_FEAT_CQE_SKIP);
+}
+
+}  // namespace
+
+bool IoUringPoller::isSupported()
+{
+  // 只探测一次，每个EventLoop创建时都会调用
+  static const bool supported = probeIoUring();
+  return supported;
+}
+
+IoUringPoller::IoUringPoller(EventLoop* loop)
+  : Poller(loop),
+    ringFd_(-1),
+    features_(0),
+    sqRingPtr_(NULL),
+    sqRingSize_(0),
+    sqHead_(NULL),
+    sqTail_(NULL),
+    sqMask_(NULL),
+    sqArray_(NULL),
+    sqes_(NULL),
+    sqesSize_(0),
+    sqeTail_(0),
+    toSubmit_(0),
+    cqRingPtr_(NULL),
+    cqRingSize_(0),
+    cqHead_(NULL),
+    cqTail_(NULL),
+    cqMask_(NULL),
+    cqes_(NULL),
+    recvSupported_(false),
+#ifdef BO_NET_HAVE_IO_URING_ACCEPT
+    acceptSupported_(true),
+#else
+    acceptSupported_(false),
+#endif
+    bufRing_(NULL),
+    bufRingSize_(0),
+    recvBuffers_(NULL),
+    bufRingTail_(0),
+    round_(0)
+{
+  if (!setupRing())
+  {
+    fprintf(stderr, "IoUringPoller: io_uring is not supported by this kernel\n");
+    abort();
+  }
+  recvSupported_ = setupRecvBuffers();
+}
+
+IoUringPoller::~IoUringPoller()
+{
+  ::munmap(sqes_, sqesSize_);
+  ::munmap(sqRingPtr_, sqRingSize_);
+  // 关闭ring之后内核不再引用provided buffer
+  ::close(ringFd_);
+  if (bufRing_ != NULL)
+  {
+    ::munmap(bufRing_, bufRingSize_);
+    ::munmap(recvBuffers_, static_cast<size_t>(kRecvBufferCount) * kRecvBufferSize);
+  }
+}
+
+bool IoUringPoller::setupRing()
+{
+  struct io_uring_params params;
+  memZero(&params, sizeof params);
+  // 完成队列开得比提交队列大，一轮中大量连接同时就绪也不容易溢出；即使溢出，NODROP保证事件不会丢
+  params.flags = IORING_SETUP_CQSIZE;
+  params.cq_entries = kQueueDepth * 4;
+  ringFd_ = sysIoUringSetup(kQueueDepth, &params);
+  if (ringFd_ < 0)
+  {
+    if (errno == ENOSYS || errno == EPERM)
+    {
+      return false;
+    }
+    fprintf(stderr, "IoUringPoller: io_uring_setup failed: %s\n", strerror(errno));
+    abort();
+  }
+  features_ = params.features;
+  if ((features_ & kRequiredFeatures) != kRequiredFeatures)
+  {
+    ::close(ringFd_);
+    ringFd_ = -1;
+    return false;
+  }
+
+  // SINGLE_MMAP：提交队列和完成队列的环在同一块映射里
+  sqRingSize_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  size_t cqSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+  if (cqSize > sqRingSize_)
+  {
+    sqRingSize_ = cqSize;
+  }
+  sqRingPtr_ = ::mmap(NULL, sqRingSize_, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, ringFd_, IORING_OFF_SQ_RING);
+  if (sqRingPtr_ == MAP_FAILED)
+  {
+    fprintf(stderr, "IoUringPoller: mmap sq ring failed: %s\n", strerror(errno));
+    abort();
+  }
+  cqRingPtr_ = sqRingPtr_;
+  cqRingSize_ = sqRingSize_;
+
+  sqesSize_ = params.sq_entries * sizeof(struct io_uring_sqe);
+  void* sqes = ::mmap(NULL, sqesSize_, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, ringFd_, IORING_OFF_SQES);
+  if (sqes == MAP_FAILED)
+  {
+    fprintf(stderr, "IoUringPoller: mmap sqes failed: %s\n", strerror(errno));
+    abort();
+  }
+  sqes_ = static_cast<struct io_uring_sqe*>(sqes);
+
+  char* sq = static_cast<char*>(sqRingPtr_);
+  sqHead_ = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+  sqTail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+  sqMask_ = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+  sqArray_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+  sqeTail_ = *sqTail_;
+
+  char* cq = static_cast<char*>(cqRingPtr_);
+  cqHead_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+  cqTail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+  cqMask_ = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+  cqes_ = reinterpret_cast<struct io_uring_cqe*>(cq + params.cq_off.cqes);
+  return true;
+}
+
+bool IoUringPoller::setupRecvBuffers()
+{
+#ifdef BO_NET_HAVE_IO_URING_RECV
+  static_assert((kRecvBufferCount & (kRecvBufferCount - 1)) == 0, "ring entries must be a power of 2");
+  // 环和缓冲区都要页对齐
+  bufRingSize_ = kRecvBufferCount * sizeof(struct io_uring_buf);
+  void* ring = ::mmap(NULL, bufRingSize_, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+  if (ring == MAP_FAILED)
+  {
+    fprintf(stderr, "IoUringPoller: mmap buffer ring failed: %s\n", strerror(errno));
+    abort();
+  }
+  const size_t buffersSize = static_cast<size_t>(kRecvBufferCount) * kRecvBufferSize;
+  void* buffers = ::mmap(NULL, buffersSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (buffers == MAP_FAILED)
+  {
+    fprintf(stderr, "IoUringPoller: mmap recv buffers failed: %s\n", strerror(errno));
+    abort();
+  }
+
+  struct io_uring_buf_reg reg;
+  memZero(&reg, sizeof reg);
+  reg.ring_addr = reinterpret_cast<uint64_t>(ring);
+  reg.ring_entries = kRecvBufferCount;
+  reg.bgid = kRecvBufferGroup;
+  if (sysIoUringRegister(ringFd_, IORING_REGISTER_PBUF_RING, &reg, 1) < 0)
+  {
+    // 5.19以前没有provided buffer ring，只用poll
+    if (errno != EINVAL)
+    {
+      fprintf(stderr, "IoUringPoller: register buffer ring failed: %s\n", strerror(errno));
+    }
+    ::munmap(ring, bufRingSize_);
+    ::munmap(buffers, buffersSize);
+    bufRingSize_ = 0;
+    return false;
+  }
+  bufRing_ = static_cast<struct io_uring_buf*>(ring);
+  recvBuffers_ = static_cast<char*>(buffers);
+  for (unsigned bid = 0; bid < kRecvBufferCount; ++bid)
+  {
+    recycleRecvBuffer(static_cast<uint16_t>(bid));
+  }
+  // 环尾和第0项的resv字段重叠
+  __atomic_store_n(&bufRing_[0].resv, bufRingTail_, __ATOMIC_RELEASE);
+  return true;
+#else
+  return false;
+#endif
+}
+
+void IoUringPoller::recycleRecvBuffer(uint16_t bid)
+{
+#ifdef BO_NET_HAVE_IO_URING_RECV
+  // 不能写resv，第0项的resv就是环尾
+  struct io_uring_buf* buf = &bufRing_[bufRingTail_ & (kRecvBufferCount - 1)];
+  buf->addr = reinterpret_cast<uint64_t>(recvBuffers_ + static_cast<size_t>(bid) * kRecvBufferSize);
+  buf->len = kRecvBufferSize;
+  buf->bid = bid;
+  ++bufRingTail_;
+#else
+  (void)bid;
+#endif
+}
+
+int IoUringPoller::enter(unsigned toSubmit, unsigned waitNr, int timeoutMs)
+{
+  // 先把本地写好的SQE发布给内核
+  storeRelease(sqTail_, sqeTail_);
+
+  unsigned flags = 0;
+  struct __kernel_timespec ts;
+  struct io_uring_getevents_arg arg;
+  memZero(&arg, sizeof arg);
+  if (waitNr > 0)
+  {
+    flags |= IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG;
+    arg.sigmask = 0;
+    arg.sigmask_sz = _NSIG / 8;
+    if (timeoutMs >= 0)
+    {
+      ts.tv_sec = timeoutMs / 1000;
+      ts.tv_nsec = static_cast<long long>(timeoutMs % 1000) * 1000 * 1000;
+      arg.ts = reinterpret_cast<uint64_t>(&ts);
+    }
+  }
+  int ret = sysIoUringEnter(ringFd_, toSubmit, waitNr, flags,
+                            waitNr > 0 ? &arg : NULL, waitNr > 0 ? sizeof arg : 0);
+  if (ret >= 0)
+  {
+    toSubmit_ -= static_cast<unsigned>(ret);
+  }
+  return ret;
+}
+
+io_uring_sqe* IoUringPoller::getSqe()
+{
+  unsigned head = loadAcquire(sqHead_);
+  if (sqeTail_ - head >= kQueueDepth)
+  {
+    // 提交队列满了，先把已有的提交掉，不等待
+    if (enter(toSubmit_, 0, 0) < 0)
+    {
+      fprintf(stderr, "IoUringPoller: io_uring_enter failed: %s\n", strerror(errno));
+      abort();
+    }
+    head = loadAcquire(sqHead_);
+    assert(sqeTail_ - head < kQueueDepth);
+  }
+  unsigned index = sqeTail_ & *sqMask_;
+  struct io_uring_sqe* sqe = &sqes_[index];
+  memZero(sqe, sizeof *sqe);
+  sqArray_[index] = index;
+  ++sqeTail_;
+  ++toSubmit_;
+  return sqe;
+}
+
+IoUringPoller::Registration& IoUringPoller::registration(int fd)
+{
+  assert(fd >= 0);
+  if (static_cast<size_t>(fd) >= registrations_.size())
+  {
+    Registration empty = { NULL, 0, 0, false, false, false, -1, 0, 0, false, false };
+    registrations_.resize(std::max(static_cast<size_t>(fd) + 1, registrations_.size() * 2), empty);
+  }
+  return registrations_[fd];
+}
+
+bool IoUringPoller::completesReads(const Registration& reg) const
+{
+  return (recvSupported_ && reg.channel->recvBuffer() != NULL)
+      || (acceptSupported_ && reg.channel->acceptQueue() != NULL);
+}
+
+uint32_t IoUringPoller::pollEvents(const Registration& reg) const
+{
+  uint32_t events = static_cast<uint32_t>(reg.channel->events());
+  if (completesReads(reg))
+  {
+    // 可读由recv/accept请求处理
+    events &= ~static_cast<uint32_t>(POLLIN | POLLPRI);
+  }
+  return events;
+}
+
+bool IoUringPoller::wantsRecv(const Registration& reg) const
+{
+  return completesReads(reg) && reg.channel->isReading();
+}
+
+void IoUringPoller::queuePollAdd(int fd, Registration& reg)
+{
+  const uint32_t events = pollEvents(reg);
+  struct io_uring_sqe* sqe = getSqe();
+  sqe->opcode = IORING_OP_POLL_ADD;
+  sqe->fd = fd;
+  // EPOLLET不是poll的事件位，边沿触发由multishot表达
+  sqe->poll32_events = events & ~static_cast<uint32_t>(EPOLLET);
+  sqe->user_data = makeUserData(fd, reg.generation);
+  reg.multishot = reg.channel->isEdgeTriggered();
+  if (reg.multishot)
+  {
+    sqe->len = IORING_POLL_ADD_MULTI;
+  }
+  reg.events = events;
+  reg.armed = true;
+}
+
+void IoUringPoller::queuePollRemove(int fd, Registration& reg)
+{
+  if (reg.armed)
+  {
+    struct io_uring_sqe* sqe = getSqe();
+    sqe->opcode = IORING_OP_POLL_REMOVE;
+    sqe->fd = -1;
+    sqe->addr = makeUserData(fd, reg.generation);
+    sqe->user_data = kIgnoredUserData;
+    // 删除请求本身成功时不需要CQE
+    sqe->flags = IOSQE_CQE_SKIP_SUCCESS;
+    reg.armed = false;
+  }
+  // 之后到达的旧请求的CQE都会被丢弃
+  ++reg.generation;
+}
+
+void IoUringPoller::queueRecv(int fd, Registration& reg)
+{
+  const bool accept = reg.channel->acceptQueue() != NULL;
+  struct io_uring_sqe* sqe = getSqe();
+  if (accept)
+  {
+#ifdef BO_NET_HAVE_IO_URING_ACCEPT
+    // 不要对端地址：multishot时所有连接共用同一个地址缓冲区，由Acceptor用getpeername取
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = fd;
+    sqe->accept_flags = SOCK_NONBLOCK | SOCK_CLOEXEC;
+    sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+#endif
+  }
+  else
+  {
+#ifdef BO_NET_HAVE_IO_URING_RECV
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = fd;
+    // 长度为0表示每次用一整块provided buffer
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = kRecvBufferGroup;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+#endif
+  }
+  sqe->user_data = makeRecvUserData(fd, reg.incarnation, reg.recvSequence, accept);
+  reg.recvArmed = true;
+  reg.channel->setReceiving(true);
+}
+
+void IoUringPoller::queueRecvCancel(int fd, Registration& reg)
+{
+  if (reg.recvArmed)
+  {
+    struct io_uring_sqe* sqe = getSqe();
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->fd = -1;
+    sqe->addr = makeRecvUserData(fd, reg.incarnation, reg.recvSequence, reg.channel->acceptQueue() != NULL);
+    sqe->user_data = kIgnoredUserData;
+    sqe->flags = IOSQE_CQE_SKIP_SUCCESS;
+    reg.recvArmed = false;
+  }
+  // 取消之前已经收到的数据仍然交给同一个Channel，只是旧请求的最后一个CQE不再影响recvArmed
+  ++reg.recvSequence;
+  reg.channel->setReceiving(false);
+}
+
+void IoUringPoller::queueArm(int fd, Registration& reg)
+{
+  if (!reg.queued)
+  {
+    reg.queued = true;
+    toArm_.push_back(fd);
+  }
+}
+
+void IoUringPoller::armPending()
+{
+  for (int fd : toArm_)
+  {
+    Registration& reg = registrations_[fd];
+    reg.queued = false;
+    if (reg.channel == NULL)
+    {
+      continue;
+    }
+    if (!reg.armed && (pollEvents(reg) & ~static_cast<uint32_t>(EPOLLET)) != 0)
+    {
+      queuePollAdd(fd, reg);
+    }
+    if (!reg.recvArmed && !reg.recvEof && wantsRecv(reg))
+    {
+      queueRecv(fd, reg);
+    }
+  }
+  toArm_.clear();
+}
+
+Timestamp IoUringPoller::poll(int timeoutMs, ChannelList* activeChannels)
+{
+  armPending();
+  ++round_;
+
+  int ret = 0;
+  // 完成队列里已经有事件时不需要等待，只提交
+  bool ready = loadAcquire(cqTail_) != *cqHead_;
+  ret = enter(toSubmit_, ready ? 0 : 1, timeoutMs);
+  int savedErrno = errno;
+  Timestamp now(Timestamp::now());
+  if (ret < 0 && savedErrno != EINTR && savedErrno != ETIME && savedErrno != EBUSY)
+  {
+    fprintf(stderr, "IoUringPoller::poll() failed: %s\n", strerror(savedErrno));
+  }
+  fillActiveChannels(activeChannels);
+  return now;
+}
+
+void IoUringPoller::activate(Registration& reg, int revents, ChannelList* activeChannels)
+{
+  if (reg.activeRound == round_)
+  {
+    // 同一个fd在这一轮中有多个CQE，合并成一次回调
+    reg.channel->set_revents(reg.channel->revents() | revents);
+  }
+  else
+  {
+    reg.activeRound = round_;
+    reg.channel->set_revents(revents);
+    activeChannels->push_back(reg.channel);
+  }
+}
+
+void IoUringPoller::handleRecvCompletion(const io_uring_cqe* cqe, ChannelList* activeChannels)
+{
+  const int fd = static_cast<int>(cqe->user_data >> 32);
+  const uint32_t tag = static_cast<uint32_t>(cqe->user_data);
+  const bool accept = (tag & kAcceptTag) != 0;
+  const bool hasBuffer = (cqe->flags & IORING_CQE_F_BUFFER) != 0;
+  const uint16_t bid = static_cast<uint16_t>(cqe->flags >> IORING_CQE_BUFFER_SHIFT);
+  const int res = cqe->res;
+
+  Registration* reg = static_cast<size_t>(fd) < registrations_.size() ? &registrations_[fd] : NULL;
+  if (reg == NULL || reg->channel == NULL
+      || ((tag >> kRecvSequenceBits) & kIncarnationMask) != (reg->incarnation & kIncarnationMask))
+  {
+    // 已经移除的Channel的数据或者连接，fd可能已经被复用，直接丢弃
+    if (hasBuffer)
+    {
+      recycleRecvBuffer(bid);
+    }
+    if (accept && res >= 0)
+    {
+      ::close(res);
+    }
+    return;
+  }
+
+  if (!(cqe->flags & IORING_CQE_F_MORE) && (tag & kRecvSequenceMask) == (reg->recvSequence & kRecvSequenceMask))
+  {
+    // 当前的recv/accept请求结束了：读到了对端关闭、出错、provided buffer用完，下一轮按需重新提交
+    reg->recvArmed = false;
+    reg->channel->setReceiving(false);
+    queueArm(fd, *reg);
+  }
+
+  if (accept)
+  {
+    if (res >= 0)
+    {
+      reg->channel->acceptQueue()->push_back(res);
+      activate(*reg, POLLIN, activeChannels);
+    }
+    else if (res == -ECANCELED)
+    {
+    }
+    else if (res == -EINVAL)
+    {
+      // 内核不支持multishot accept（5.19以前），改回用poll等待可读
+      acceptSupported_ = false;
+      queuePollRemove(fd, *reg);
+      queueArm(fd, *reg);
+    }
+    else
+    {
+      // EMFILE之类的错误交给Acceptor处理
+      reg->channel->addReceived(res);
+      activate(*reg, POLLIN, activeChannels);
+    }
+    return;
+  }
+
+  if (res > 0)
+  {
+    assert(hasBuffer);
+    reg->channel->recvBuffer()->append(recvBuffers_ + static_cast<size_t>(bid) * kRecvBufferSize, res);
+    recycleRecvBuffer(bid);
+    reg->channel->addReceived(res);
+    activate(*reg, POLLIN, activeChannels);
+    return;
+  }
+  if (hasBuffer)
+  {
+    recycleRecvBuffer(bid);
+  }
+  if (res == 0)
+  {
+    reg->recvEof = true;
+    reg->channel->addReceived(0);
+    activate(*reg, POLLIN, activeChannels);
+  }
+  else if (res == -ENOBUFS || res == -ECANCELED)
+  {
+    // provided buffer暂时用完了（这一轮归还之后下一轮重新提交），或者请求被取消
+  }
+  else if (res == -EINVAL)
+  {
+    // 内核不支持multishot recv（6.0以前），所有连接改回用poll等待可读
+    recvSupported_ = false;
+    queuePollRemove(fd, *reg);
+    queueArm(fd, *reg);
+  }
+  else
+  {
+    reg->channel->addReceived(res);
+    activate(*reg, POLLIN, activeChannels);
+  }
+}
+
+void IoUringPoller::fillActiveChannels(ChannelList* activeChannels)
+{
+  const uint16_t bufRingTail = bufRingTail_;
+  unsigned head = *cqHead_;
+  unsigned tail = loadAcquire(cqTail_);
+  const unsigned mask = *cqMask_;
+  for (; head != tail; ++head)
+  {
+    const struct io_uring_cqe* cqe = &cqes_[head & mask];
+    uint64_t userData = cqe->user_data;
+    if (userData == kIgnoredUserData)
+    {
+      continue;
+    }
+    if (userData & kRecvTag)
+    {
+      handleRecvCompletion(cqe, activeChannels);
+      continue;
+    }
+    int fd = static_cast<int>(userData >> 32);
+    uint32_t generation = static_cast<uint32_t>(userData);
+    if (static_cast<size_t>(fd) >= registrations_.size())
+    {
+      continue;
+    }
+    Registration& reg = registrations_[fd];
+    if (reg.channel == NULL || (reg.generation & kGenerationMask) != generation)
+    {
+      continue;
+    }
+
+    if (!(cqe->flags & IORING_CQE_F_MORE))
+    {
+      // 单次poll完成了，或者multishot被内核终止了，下一轮重新提交
+      reg.armed = false;
+      queueArm(fd, reg);
+    }
+
+    int revents;
+    if (cqe->res >= 0)
+    {
+      revents = cqe->res;
+    }
+    else if (cqe->res == -ECANCELED)
+    {
+      continue;
+    }
+    else
+    {
+      revents = POLLERR;
+    }
+    activate(reg, revents, activeChannels);
+  }
+  storeRelease(cqHead_, head);
+#ifdef BO_NET_HAVE_IO_URING_RECV
+  if (bufRingTail_ != bufRingTail)
+  {
+    // 这一轮归还的provided buffer一次发布给内核
+    __atomic_store_n(&bufRing_[0].resv, bufRingTail_, __ATOMIC_RELEASE);
+  }
+#else
+  (void)bufRingTail;
+#endif
+}
+
+void IoUringPoller::updateChannel(Channel* channel)
+{
+  Poller::assertInLoopThread();
+  const int fd = channel->fd();
+  Registration& reg = registration(fd);
+  if (reg.channel == NULL)
+  {
+    assert(channels_.find(fd) == channels_.end());
+    channels_[fd] = channel;
+    reg.channel = channel;
+    ++reg.generation;
+    ++reg.incarnation;
+    reg.armed = false;
+    reg.recvArmed = false;
+    reg.recvEof = false;
+    reg.activeRound = -1;
+  }
+  else
+  {
+    assert(reg.channel == channel);
+    if (reg.recvArmed && !wantsRecv(reg))
+    {
+      // 停止读了：取消recv请求
+      queueRecvCancel(fd, reg);
+    }
+    if (reg.armed && reg.events != pollEvents(reg))
+    {
+      // 事件变了：取消旧的poll请求，下一轮按新的事件重新提交
+      queuePollRemove(fd, reg);
+    }
+  }
+  queueArm(fd, reg);
+}
+
+void IoUringPoller::removeChannel(Channel* channel)
+{
+  Poller::assertInLoopThread();
+  const int fd = channel->fd();
+  assert(channels_.find(fd) != channels_.end());
+  assert(channels_[fd] == channel);
+  assert(channel->isNoneEvent());
+  size_t n = channels_.erase(fd);
+  (void)n;
+  assert(n == 1);
+
+  Registration& reg = registration(fd);
+  assert(reg.channel == channel);
+  queuePollRemove(fd, reg);
+  queueRecvCancel(fd, reg);
+  // 之后到达的recv的CQE因为注册序号对不上被丢弃，不会再碰这个Channel的Buffer
+  ++reg.incarnation;
+  reg.channel = NULL;
+  // 留在toArm_中的fd在armPending()里会因为channel为NULL被跳过
+}
+
+#else  // !BO_NET_HAVE_IO_URING
+
+bool IoUringPoller::isSupported()
+{
+  return false;
+}
+
+// isSupported()为false时Poller::newPoller()不会创建IoUringPoller
+IoUringPoller::IoUringPoller(EventLoop* loop)
+  : Poller(loop)
+{
+  fprintf(stderr, "IoUringPoller: built without io_uring support\n");
+  abort();
+}
+
+IoUringPoller::~IoUringPoller()
+{
+}
+
+Timestamp IoUringPoller::poll(int, ChannelList*)
+{
+  abort();
+}
+
+void IoUringPoller::updateChannel(Channel*)
+{
+  abort();
+}
+
+void IoUringPoller::removeChannel(Channel*)
+{
+  abort();
+}
+
+#endif  // BO_NET_HAVE_IO_URING
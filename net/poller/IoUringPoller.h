@@ -0,0 +1,149 @@
+#ifndef BO_NET_NET_POLLER_IOURINGPOLLER_H
+#define BO_NET_NET_POLLER_IOURINGPOLLER_H
+
+#include "net/Poller.h"
+
+#include <stdint.h>
+#include <vector>
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+struct io_uring_buf;
+
+namespace bo_net
+{
+
+namespace net
+{
+
+/**
+ * 基于io_uring的Poller，直接使用io_uring_setup/io_uring_enter系统调用和<linux/io_uring.h>，不依赖liburing。
+ *
+ * 仍然是"就绪通知"模型，对EventLoop和Channel完全透明：每个Channel对应一个IORING_OP_POLL_ADD请求。
+ * 和epoll相比省掉的是系统调用：一轮循环中所有的注册、修改、删除都只是往提交队列里写SQE，
+ * 下一次poll()时和等待一起通过一次io_uring_enter提交，完成事件直接从共享内存的完成队列里读取。
+ *
+ * - 边沿触发的Channel使用multishot poll（IORING_POLL_ADD_MULTI），注册一次之后每次有新事件都产生一个CQE；
+ * - 水平触发的Channel使用单次poll，完成之后在下一次poll()时重新提交。重新提交时内核会立即检查一次就绪状态，
+ *   上一轮没有读完的数据会马上再次通知，语义和epoll的水平触发相同。
+ *
+ * 设置了recvBuffer()的Channel（TcpConnection）在内核支持时（6.0以上）不再用poll等待可读，
+ * 而是提交一个multishot recv（IORING_RECV_MULTISHOT），数据由内核直接收进注册的provided buffer ring，
+ * Poller在fillActiveChannels()里把它们追加到Channel的recvBuffer()，读回调不用再为每批数据调用一次read()。
+ * 写事件仍然用poll等待。recv请求在停止读、Channel被移除时取消，对端关闭之后不再重新提交。
+ * 设置了acceptQueue()的Channel（Acceptor）同样不用poll，而是提交一个multishot accept（5.19以上），
+ * 新连接的fd放进acceptQueue()，Acceptor不用再为每个连接调用accept()。
+ *
+ * 没有使用registered files/buffers：fixed file只省掉提交SQE时的一次fd查找，而multishot请求只提交一次，
+ * 连接的写、sendfile、splice、shutdown、close仍然是普通系统调用，要用真实的fd；
+ * registered buffer只用于READ_FIXED/WRITE_FIXED，读已经由provided buffer ring承担，写不经过io_uring。
+ *
+ * 每个poll请求的user_data是(fd << 32 | generation)，Channel修改事件或者被移除时generation加一，
+ * 已经取消的旧请求晚到的CQE因为generation对不上而被丢弃，fd被复用也不会串到新的Channel上。
+ * recv/accept请求的user_data低32位最高位为1，其余位是accept标志、Channel的注册序号和请求的序号：
+ * 前者防止数据追加到fd被复用之后的新Channel上，后者用来判断最后一个CQE是不是当前的recv请求。
+ *
+ * 头文件缺少需要的io_uring定义时（编译时的内核头文件早于5.17）isSupported()返回false，
+ * 缺少multishot recv的定义时只用poll
+*/
+class IoUringPoller : public Poller
+{
+    public:
+        explicit IoUringPoller(EventLoop *loop);
+        ~IoUringPoller() override;
+
+        // 当前内核是否支持本Poller需要的io_uring特性
+        static bool isSupported();
+
+        Timestamp poll(int timeoutMs, ChannelList *activeChannels) override;
+        void updateChannel(Channel *channel) override;
+        void removeChannel(Channel *channel) override;
+
+    private:
+        static const unsigned kQueueDepth = 1024;
+        static const uint64_t kIgnoredUserData = ~static_cast<uint64_t>(0);
+        // provided buffer ring：kRecvBufferCount个kRecvBufferSize字节的缓冲区，收到的数据拷进Channel的Buffer之后立即归还
+        static const unsigned kRecvBufferCount = 128;
+        static const unsigned kRecvBufferSize = 16 * 1024;
+        static const uint16_t kRecvBufferGroup = 0;
+
+        struct Registration
+        {
+            Channel  *channel;
+            uint32_t  generation;
+            uint32_t  events;       // 已经提交给内核的poll事件
+            bool      armed;        // 内核中有一个有效的poll请求
+            bool      queued;       // 已经在toArm_中等待提交
+            bool      multishot;
+            int64_t   activeRound;  // 最后一次被放进activeChannels的轮次，同一轮中合并多个CQE
+            uint32_t  incarnation;  // Channel每次注册加一，recv的CQE只交给同一次注册的Channel
+            uint32_t  recvSequence; // recv请求每次取消加一
+            bool      recvArmed;    // 内核中有一个有效的recv（或者accept）请求
+            bool      recvEof;      // recv已经读到对端关闭，不再提交
+        };
+
+        // 只有当内核真的缺少某个特性时才返回false；其他失败直接abort
+        bool setupRing();
+        io_uring_sqe* getSqe();
+        // 把已经写好的SQE提交给内核，waitNr > 0时同时等待完成事件
+        int enter(unsigned toSubmit, unsigned waitNr, int timeoutMs);
+        // 注册provided buffer ring，内核不支持时返回false
+        bool setupRecvBuffers();
+        void armPending();
+        // 可读由recv/accept请求处理，而不是poll
+        bool completesReads(const Registration &reg) const;
+        // 需要用poll等待的事件（含EPOLLET位）；recv/accept模式下去掉读事件
+        uint32_t pollEvents(const Registration &reg) const;
+        bool wantsRecv(const Registration &reg) const;
+        void queuePollAdd(int fd, Registration &reg);
+        void queuePollRemove(int fd, Registration &reg);
+        void queueRecv(int fd, Registration &reg);
+        void queueRecvCancel(int fd, Registration &reg);
+        void queueArm(int fd, Registration &reg);
+        void recycleRecvBuffer(uint16_t bid);
+        void handleRecvCompletion(const io_uring_cqe *cqe, ChannelList *activeChannels);
+        void activate(Registration &reg, int revents, ChannelList *activeChannels);
+        void fillActiveChannels(ChannelList *activeChannels);
+        Registration& registration(int fd);
+
+        int ringFd_;
+        unsigned features_;
+
+        // 提交队列
+        void     *sqRingPtr_;
+        size_t    sqRingSize_;
+        unsigned *sqHead_;
+        unsigned *sqTail_;
+        unsigned *sqMask_;
+        unsigned *sqArray_;
+        io_uring_sqe *sqes_;
+        size_t    sqesSize_;
+        unsigned  sqeTail_;      // 本地的提交队列尾，enter()时才发布给内核
+        unsigned  toSubmit_;
+
+        // 完成队列
+        void     *cqRingPtr_;
+        size_t    cqRingSize_;
+        unsigned *cqHead_;
+        unsigned *cqTail_;
+        unsigned *cqMask_;
+        io_uring_cqe *cqes_;
+
+        // provided buffer ring，recvSupported_为false时不使用
+        bool      recvSupported_;
+        bool      acceptSupported_;
+        io_uring_buf *bufRing_;   // 即io_uring_buf_ring，按io_uring_buf数组访问
+        size_t    bufRingSize_;
+        char     *recvBuffers_;
+        uint16_t  bufRingTail_;  // 本地的环尾，每轮fillActiveChannels()结束时发布给内核
+
+        int64_t round_;
+        std::vector<Registration> registrations_;  // 按fd下标
+        std::vector<int> toArm_;
+};
+
+} // namespace net
+
+} // namespace bo_net
+
+#endif // BO_NET_NET_POLLER_IOURINGPOLLER_H
@@ -0,0 +1,247 @@
+// 在同一个ping-pong echo负载上比较epoll和io_uring两种Poller后端：
+// 服务端是TcpServer，客户端是一个独立线程里的裸epoll循环（两轮测试完全相同），
+// 每个连接同时只有一条消息在路上，收到完整的回显之后立刻发下一条
+//
+// usage: EchoBackend_bench [connections] [message_size] [seconds] [server_threads] [port]
+
+#include "base/Thread.h"
+#include "base/Timestamp.h"
+#include "net/Buffer.h"
+#include "net/EventLoop.h"
+#include "net/InetAddress.h"
+#include "net/TcpServer.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace bo_net;
+using namespace bo_net::net;
+
+namespace
+{
+
+struct Options
+{
+  int connections;
+  int messageSize;
+  int seconds;
+  int serverThreads;
+  uint16_t port;
+};
+
+struct ClientConn
+{
+  int fd;
+  size_t written;   // 当前消息已经写出的字节数
+  size_t received;  // 当前消息已经收到的回显字节数
+};
+
+struct Result
+{
+  int64_t messages;
+  double seconds;
+};
+
+int64_t monotonicNanos()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+// 写出当前消息剩下的部分，返回是否已经写完
+bool flushMessage(ClientConn* c, const std::vector<char>& message)
+{
+  while (c->written < message.size())
+  {
+    ssize_t n = ::write(c->fd, message.data() + c->written, message.size() - c->written);
+    if (n < 0)
+    {
+      if (errno == EAGAIN)
+      {
+        return false;
+      }
+      fprintf(stderr, "client write: %s\n", strerror(errno));
+      abort();
+    }
+    c->written += static_cast<size_t>(n);
+  }
+  return true;
+}
+
+void modify(int epfd, ClientConn* c, uint32_t events)
+{
+  struct epoll_event ev;
+  memset(&ev, 0, sizeof ev);
+  ev.events = events;
+  ev.data.ptr = c;
+  ::epoll_ctl(epfd, EPOLL_CTL_MOD, c->fd, &ev);
+}
+
+Result runClient(const Options& opt, const InetAddress& serverAddr)
+{
+  std::vector<char> message(opt.messageSize, 'x');
+  std::vector<char> readBuf(64 * 1024);
+  std::vector<ClientConn> conns(opt.connections);
+  int epfd = ::epoll_create1(EPOLL_CLOEXEC);
+
+  for (ClientConn& c : conns)
+  {
+    c.fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, IPPROTO_TCP);
+    // 建连时用阻塞connect，简单可靠，之后再切成非阻塞
+    if (::connect(c.fd, serverAddr.getSockAddr(), sizeof(struct sockaddr_in)) < 0)
+    {
+      fprintf(stderr, "client connect: %s\n", strerror(errno));
+      abort();
+    }
+    int one = 1;
+    ::setsockopt(c.fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof one);
+    ::fcntl(c.fd, F_SETFL, ::fcntl(c.fd, F_GETFL, 0) | O_NONBLOCK);
+    c.written = 0;
+    c.received = 0;
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof ev);
+    ev.events = EPOLLIN;
+    ev.data.ptr = &c;
+    ::epoll_ctl(epfd, EPOLL_CTL_ADD, c.fd, &ev);
+  }
+
+  int64_t messages = 0;
+  int64_t start = monotonicNanos();
+  int64_t deadline = start + static_cast<int64_t>(opt.seconds) * 1000000000;
+  for (ClientConn& c : conns)
+  {
+    if (!flushMessage(&c, message))
+    {
+      modify(epfd, &c, EPOLLIN | EPOLLOUT);
+    }
+  }
+
+  std::vector<struct epoll_event> events(conns.size());
+  // 到时间之后不再发新消息，但要把路上的回显都收完再断开，否则服务端会在写的时候收到RST
+  size_t outstanding = conns.size();
+  int64_t now = start;
+  int64_t end = 0;
+  while (outstanding > 0)
+  {
+    int n = ::epoll_wait(epfd, events.data(), static_cast<int>(events.size()), 100);
+    now = monotonicNanos();
+    if (end == 0 && now >= deadline)
+    {
+      end = now;
+    }
+    for (int i = 0; i < n; ++i)
+    {
+      ClientConn* c = static_cast<ClientConn*>(events[i].data.ptr);
+      if (events[i].events & EPOLLOUT)
+      {
+        if (flushMessage(c, message))
+        {
+          modify(epfd, c, EPOLLIN);
+        }
+      }
+      if (events[i].events & EPOLLIN)
+      {
+        for (;;)
+        {
+          ssize_t nr = ::read(c->fd, readBuf.data(), readBuf.size());
+          if (nr <= 0)
+          {
+            if (nr < 0 && errno == EAGAIN)
+            {
+              break;
+            }
+            fprintf(stderr, "client read: %s\n", nr == 0 ? "server closed" : strerror(errno));
+            abort();
+          }
+          c->received += static_cast<size_t>(nr);
+        }
+        // 每个连接同时只有一条消息，收够了一条就发下一条
+        if (c->received >= message.size() && c->written == message.size())
+        {
+          c->received -= message.size();
+          c->written = 0;
+          if (end != 0)
+          {
+            --outstanding;
+            continue;
+          }
+          ++messages;
+          if (!flushMessage(c, message))
+          {
+            modify(epfd, c, EPOLLIN | EPOLLOUT);
+          }
+        }
+      }
+    }
+  }
+
+  for (ClientConn& c : conns)
+  {
+    ::close(c.fd);
+  }
+  ::close(epfd);
+  Result result = { messages, static_cast<double>(end - start) / 1e9 };
+  return result;
+}
+
+const char* backendName(EventLoop::PollerBackend backend)
+{
+  return backend == EventLoop::kIoUring ? "io_uring" : "epoll";
+}
+
+void runBackend(EventLoop::PollerBackend backend, const Options& opt)
+{
+  EventLoop loop(backend);
+  InetAddress listenAddr(opt.port, true);
+  TcpServer server(&loop, listenAddr, "EchoBackendBench");
+  server.setPollerBackend(backend);
+  server.setThreadNum(opt.serverThreads);
+  server.setMessageCallback(
+      [](const TcpConnectionPtr& conn, Buffer* buf, Timestamp) {
+        conn->send(buf);
+      });
+  server.start();
+
+  Result result = { 0, 0.0 };
+  Thread client([&] {
+    result = runClient(opt, listenAddr);
+    // 等服务端处理完客户端的断开再退出
+    loop.runAfter(0.2, [&loop] { loop.quit(); });
+  }, "echo-client");
+  client.start();
+  loop.loop();
+  client.join();
+
+  double msgsPerSec = static_cast<double>(result.messages) / result.seconds;
+  double mibPerSec = msgsPerSec * opt.messageSize / (1024.0 * 1024.0);
+  printf("%-9s conns %5d  msg %7d B  threads %2d  %12.0f msgs/s  %10.2f MiB/s\n",
+         backendName(loop.pollerBackend()), opt.connections, opt.messageSize,
+         opt.serverThreads, msgsPerSec, mibPerSec);
+}
+
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+  Options opt;
+  opt.connections = argc > 1 ? atoi(argv[1]) : 100;
+  opt.messageSize = argc > 2 ? atoi(argv[2]) : 64;
+  opt.seconds = argc > 3 ? atoi(argv[3]) : 5;
+  opt.serverThreads = argc > 4 ? atoi(argv[4]) : 1;
+  opt.port = static_cast<uint16_t>(argc > 5 ? atoi(argv[5]) : 20070);
+
+  // 两轮用不同的端口，避免上一轮的TIME_WAIT影响下一轮的bind
+  runBackend(EventLoop::kEpoll, opt);
+  ++opt.port;
+  runBackend(EventLoop::kIoUring, opt);
+}
@@ -0,0 +1,202 @@
+// OutputChain的正确性测试，通过一对非阻塞的unix socket发送：
+// - 自有Buffer、共享内存片、普通文件区间、管道几种段混在一起，对端按顺序收到完全相同的字节，发完之后释放owner；
+// - socket发送缓冲区满时writeTo只写出一部分，不报错，读走一些之后可以接着写完；
+// - 队首是管道段而管道里暂时没有数据时，stalledPipe()返回这个管道，写进数据之后可以继续发送
+
+#include "base/tests/Check.h"
+#include "net/Buffer.h"
+#include "net/OutputChain.h"
+
+#include <memory>
+#include <string>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace bo_net;
+using namespace bo_net::net;
+
+namespace
+{
+
+struct SocketPair
+{
+  SocketPair()
+  {
+    CHECK(::socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, fds) == 0);
+  }
+
+  ~SocketPair()
+  {
+    ::close(fds[0]);
+    ::close(fds[1]);
+  }
+
+  // 把对端当前能读到的数据全部追加到out
+  void drain(std::string* out)
+  {
+    char buf[65536];
+    ssize_t n;
+    while ((n = ::read(fds[1], buf, sizeof buf)) > 0)
+    {
+      out->append(buf, n);
+    }
+    CHECK(n < 0 && errno == EAGAIN);
+  }
+
+  int fds[2];
+};
+
+std::string makeBytes(size_t len, unsigned seed)
+{
+  std::string s(len, '\0');
+  for (size_t i = 0; i < len; ++i)
+  {
+    seed = seed * 1103515245 + 12345;
+    s[i] = static_cast<char>(seed >> 16);
+  }
+  return s;
+}
+
+// 写到一个已经删除的临时文件里，返回fd
+int makeTempFile(const std::string& content)
+{
+  char path[] = "/tmp/OutputChain_test.XXXXXX";
+  int fd = ::mkstemp(path);
+  CHECK(fd >= 0);
+  ::unlink(path);
+  CHECK_EQ(::write(fd, content.data(), content.size()), content.size());
+  return fd;
+}
+
+// 反复writeTo、读对端，直到发完
+void sendAll(OutputChain* chain, SocketPair* sp, std::string* received)
+{
+  while (!chain->empty())
+  {
+    int savedErrno = 0;
+    size_t before = chain->readableBytes();
+    ssize_t n = chain->writeTo(sp->fds[0], &savedErrno);
+    CHECK(n >= 0);
+    CHECK_EQ(before - chain->readableBytes(), n);
+    CHECK_EQ(chain->stalledPipe(), -1);
+    sp->drain(received);
+  }
+}
+
+void testMixedSegments()
+{
+  SocketPair sp;
+  std::string expected;
+  OutputChain chain;
+
+  chain.append("hello ", 6);
+  expected += "hello ";
+
+  std::shared_ptr<std::string> shared = std::make_shared<std::string>(makeBytes(100000, 1));
+  chain.appendShared(shared, shared->data(), shared->size());
+  expected += *shared;
+
+  std::string fileContent = makeBytes(300000, 2);
+  int fd = makeTempFile(fileContent);
+  std::shared_ptr<int> fileOwner(new int(fd), [](int* p) { ::close(*p); delete p; });
+  chain.appendFile(fileOwner, fd, 1000, 200000);
+  expected += fileContent.substr(1000, 200000);
+
+  Buffer buf;
+  std::string tail = makeBytes(5000, 3);
+  buf.append(tail.data(), tail.size());
+  chain.append(&buf);
+  CHECK_EQ(buf.readableBytes(), 0);
+  expected += tail;
+
+  int pipefd[2];
+  CHECK(::pipe2(pipefd, O_NONBLOCK | O_CLOEXEC) == 0);
+  std::string piped = makeBytes(4000, 4);
+  CHECK_EQ(::write(pipefd[1], piped.data(), piped.size()), piped.size());
+  chain.appendFile(std::shared_ptr<const void>(), pipefd[0], 0, piped.size());
+  expected += piped;
+
+  chain.append("!", 1);
+  expected += "!";
+
+  CHECK_EQ(chain.readableBytes(), expected.size());
+  std::string received;
+  sendAll(&chain, &sp, &received);
+  CHECK(received == expected);
+  CHECK_EQ(shared.use_count(), 1);
+  CHECK_EQ(fileOwner.use_count(), 1);
+  ::close(pipefd[0]);
+  ::close(pipefd[1]);
+}
+
+void testStalledPipe()
+{
+  SocketPair sp;
+  OutputChain chain;
+  int pipefd[2];
+  CHECK(::pipe2(pipefd, O_NONBLOCK | O_CLOEXEC) == 0);
+
+  chain.append("head", 4);
+  chain.appendFile(std::shared_ptr<const void>(), pipefd[0], 0, 10);
+  chain.append("tail", 4);
+
+  int savedErrno = 0;
+  ssize_t n = chain.writeTo(sp.fds[0], &savedErrno);
+  CHECK_EQ(n, 4);
+  CHECK_EQ(chain.stalledPipe(), pipefd[0]);
+  CHECK_EQ(chain.readableBytes(), 14);
+
+  CHECK_EQ(::write(pipefd[1], "0123456789", 10), 10);
+  n = chain.writeTo(sp.fds[0], &savedErrno);
+  CHECK_EQ(n, 14);
+  CHECK_EQ(chain.stalledPipe(), -1);
+  CHECK(chain.empty());
+
+  std::string received;
+  sp.drain(&received);
+  CHECK(received == "head0123456789tail");
+  ::close(pipefd[0]);
+  ::close(pipefd[1]);
+}
+
+// 一次放不进socket发送缓冲区的数据：writeTo写出一部分就返回，不报错
+void testPartialWrite()
+{
+  SocketPair sp;
+  int sndbuf = 16 * 1024;
+  ::setsockopt(sp.fds[0], SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof sndbuf);
+
+  OutputChain chain;
+  std::string expected;
+  for (int i = 0; i < 200; ++i)
+  {
+    std::string piece = makeBytes(10000, 100 + i);
+    chain.append(piece);
+    expected += piece;
+  }
+
+  int savedErrno = 0;
+  ssize_t n = chain.writeTo(sp.fds[0], &savedErrno);
+  CHECK(n > 0);
+  CHECK(static_cast<size_t>(n) < expected.size());
+  CHECK_EQ(chain.readableBytes(), expected.size() - n);
+
+  std::string received;
+  sp.drain(&received);
+  sendAll(&chain, &sp, &received);
+  CHECK(received == expected);
+}
+
+}  // namespace
+
+int main()
+{
+  testMixedSegments();
+  testStalledPipe();
+  testPartialWrite();
+  printf("OutputChain_test passed\n");
+}
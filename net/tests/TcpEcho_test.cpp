@@ -0,0 +1,225 @@
+// TcpConnection读路径在epoll和io_uring两种后端上的正确性测试（io_uring后端由multishot accept接受连接、
+// multishot recv代收数据）：
+// - 连接的对端地址正确；
+// - 几个连接上发送从1字节到几百KB的数据，回显的字节和发送的完全相同、顺序不变；
+// - 连接建立之后服务端先stopRead()一段时间，这期间发来的数据在startRead()之后按顺序收到；
+// - 客户端shutdown(SHUT_WR)之后服务端读到对端关闭并关闭连接，客户端read()返回0；
+// - 客户端不停地发送时服务端在messageCallback里stopRead()，即使内核里还有已经收到的数据，
+//   在startRead()之前messageCallback也不会再被调用，数据在startRead()之后按顺序交给用户
+
+#include "base/Thread.h"
+#include "base/tests/Check.h"
+#include "net/Buffer.h"
+#include "net/EventLoop.h"
+#include "net/InetAddress.h"
+#include "net/TcpServer.h"
+
+#include <string>
+#include <errno.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace bo_net;
+using namespace bo_net::net;
+
+namespace
+{
+
+const int kConnections = 4;
+const size_t kChunkSizes[] = { 1, 7, 1000, 16 * 1024, 65536 + 13, 300000 };
+
+std::string makeBytes(size_t len, unsigned seed)
+{
+  std::string s(len, '\0');
+  for (size_t i = 0; i < len; ++i)
+  {
+    seed = seed * 1103515245 + 12345;
+    s[i] = static_cast<char>(seed >> 16);
+  }
+  return s;
+}
+
+void writeAll(int fd, const std::string& data)
+{
+  size_t written = 0;
+  while (written < data.size())
+  {
+    ssize_t n = ::write(fd, data.data() + written, data.size() - written);
+    CHECK(n > 0);
+    written += static_cast<size_t>(n);
+  }
+}
+
+std::string readExactly(int fd, size_t len)
+{
+  std::string data(len, '\0');
+  size_t got = 0;
+  while (got < len)
+  {
+    ssize_t n = ::read(fd, &data[got], len - got);
+    CHECK(n > 0);
+    got += static_cast<size_t>(n);
+  }
+  return data;
+}
+
+void runClient(const InetAddress& serverAddr)
+{
+  int fds[kConnections];
+  for (int i = 0; i < kConnections; ++i)
+  {
+    fds[i] = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, IPPROTO_TCP);
+    CHECK(fds[i] >= 0);
+    CHECK(::connect(fds[i], serverAddr.getSockAddr(), sizeof(struct sockaddr_in)) == 0);
+  }
+
+  // 服务端这时还没有开始读，数据先积在内核里
+  std::string paused = makeBytes(50000, 7);
+  for (int i = 0; i < kConnections; ++i)
+  {
+    writeAll(fds[i], paused);
+  }
+  for (int i = 0; i < kConnections; ++i)
+  {
+    CHECK(readExactly(fds[i], paused.size()) == paused);
+  }
+
+  unsigned seed = 100;
+  for (size_t size : kChunkSizes)
+  {
+    for (int i = 0; i < kConnections; ++i)
+    {
+      std::string chunk = makeBytes(size, ++seed);
+      writeAll(fds[i], chunk);
+      CHECK(readExactly(fds[i], chunk.size()) == chunk);
+    }
+  }
+
+  for (int i = 0; i < kConnections; ++i)
+  {
+    CHECK(::shutdown(fds[i], SHUT_WR) == 0);
+    char c;
+    CHECK_EQ(::read(fds[i], &c, 1), 0);
+    ::close(fds[i]);
+  }
+}
+
+// 另一个线程读回显，服务端在收的过程中多次停止读
+const size_t kStreamBytes = 2 * 1024 * 1024;
+
+void runStreamingClient(const InetAddress& serverAddr)
+{
+  int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, IPPROTO_TCP);
+  CHECK(fd >= 0);
+  CHECK(::connect(fd, serverAddr.getSockAddr(), sizeof(struct sockaddr_in)) == 0);
+  std::string data = makeBytes(kStreamBytes, 42);
+  Thread reader([fd, &data] {
+    CHECK(readExactly(fd, data.size()) == data);
+  }, "echo-reader");
+  reader.start();
+  // 分批发送，服务端每次停止读时都有数据陆续到达
+  for (size_t offset = 0; offset < data.size(); offset += 4096)
+  {
+    writeAll(fd, data.substr(offset, 4096));
+    if (offset % (64 * 1024) == 0)
+    {
+      ::usleep(2000);
+    }
+  }
+  reader.join();
+  CHECK(::shutdown(fd, SHUT_WR) == 0);
+  char c;
+  CHECK_EQ(::read(fd, &c, 1), 0);
+  ::close(fd);
+}
+
+void testStopReadWhileReceiving(EventLoop::PollerBackend backend, uint16_t port)
+{
+  const int kPauses = 20;
+  EventLoop loop(backend);
+  InetAddress listenAddr(port, true);
+  TcpServer server(&loop, listenAddr, "TcpEcho_test");
+  server.setPollerBackend(backend);
+  bool paused = false;
+  int pauses = 0;
+  int callbacksWhilePaused = 0;
+  server.setMessageCallback([&](const TcpConnectionPtr& conn, Buffer* buf, Timestamp) {
+    if (paused)
+    {
+      ++callbacksWhilePaused;
+    }
+    conn->send(buf);
+    if (pauses < kPauses)
+    {
+      ++pauses;
+      paused = true;
+      conn->stopRead();
+      loop.runAfter(0.01, [conn, &paused] {
+        paused = false;
+        conn->startRead();
+      });
+    }
+  });
+  server.start();
+
+  Thread client([&loop, &listenAddr] {
+    runStreamingClient(listenAddr);
+    loop.runAfter(0.1, [&loop] { loop.quit(); });
+  }, "echo-client");
+  client.start();
+  loop.loop();
+  client.join();
+  CHECK(pauses >= 3);
+  CHECK_EQ(callbacksWhilePaused, 0);
+}
+
+void testBackend(EventLoop::PollerBackend backend, uint16_t port)
+{
+  EventLoop loop(backend);
+  InetAddress listenAddr(port, true);
+  TcpServer server(&loop, listenAddr, "TcpEcho_test");
+  server.setPollerBackend(backend);
+  int disconnected = 0;
+  server.setConnectionCallback([&loop, &disconnected](const TcpConnectionPtr& conn) {
+    if (conn->connected())
+    {
+      CHECK(conn->peerAddress().toIp() == "127.0.0.1");
+      CHECK(conn->peerAddress().port() != 0);
+      conn->stopRead();
+      loop.runAfter(0.05, [conn] { conn->startRead(); });
+    }
+    else
+    {
+      ++disconnected;
+    }
+  });
+  server.setMessageCallback([](const TcpConnectionPtr& conn, Buffer* buf, Timestamp) {
+    conn->send(buf);
+  });
+  server.start();
+
+  Thread client([&loop, &listenAddr] {
+    runClient(listenAddr);
+    // 客户端读到0时服务端已经在关闭连接了，稍等再退出
+    loop.runAfter(0.1, [&loop] { loop.quit(); });
+  }, "echo-client");
+  client.start();
+  loop.loop();
+  client.join();
+  CHECK_EQ(disconnected, kConnections);
+  printf("%s passed\n", loop.pollerBackend() == EventLoop::kIoUring ? "io_uring" : "epoll");
+}
+
+}  // namespace
+
+int main()
+{
+  testBackend(EventLoop::kEpoll, 20180);
+  testBackend(EventLoop::kIoUring, 20181);
+  testStopReadWhileReceiving(EventLoop::kEpoll, 20182);
+  testStopReadWhileReceiving(EventLoop::kIoUring, 20183);
+  printf("TcpEcho_test passed\n");
+}
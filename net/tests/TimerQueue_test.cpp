@@ -0,0 +1,98 @@
+// TimerQueue的正确性测试：同一批到期的定时器里，前面的回调refresh了后面的定时器，
+// 后面的定时器这次不能执行，只能在新的到期时间执行一次
+
+#include "base/tests/Check.h"
+#include "net/EventLoop.h"
+#include "net/TimerId.h"
+
+#include <stdio.h>
+
+using namespace bo_net;
+using namespace bo_net::net;
+
+namespace
+{
+
+struct Probe
+{
+  Probe() : fired(0) {}
+
+  TimerId id;
+  int fired;
+  Timestamp firedAt;
+  Timestamp refreshedTo;
+};
+
+// 两个定时器同时到期，先执行的那个把另一个推迟delay秒
+void testRefreshInBatch(bool firstCoarse, bool secondCoarse)
+{
+  const double kDelay = 0.1;
+  EventLoop loop;
+  Probe probes[2];
+  Timestamp when = addTime(Timestamp::now(), 0.02);
+  const bool coarse[2] = { firstCoarse, secondCoarse };
+  for (int i = 0; i < 2; ++i)
+  {
+    Probe* self = &probes[i];
+    Probe* other = &probes[1 - i];
+    TimerCallback cb = [&loop, self, other, kDelay] {
+      ++self->fired;
+      self->firedAt = Timestamp::now();
+      if (other->fired == 0 && !other->refreshedTo.valid())
+      {
+        other->refreshedTo = addTime(Timestamp::now(), kDelay);
+        loop.refresh(other->id, other->refreshedTo);
+      }
+    };
+    self->id = coarse[i] ? loop.runAtCoarse(when, cb) : loop.runAt(when, cb);
+  }
+  loop.runAfter(3 * kDelay, [&loop] { loop.quit(); });
+  loop.loop();
+
+  int refreshed = 0;
+  for (const Probe& p : probes)
+  {
+    CHECK_EQ(p.fired, 1);
+    if (p.refreshedTo.valid())
+    {
+      ++refreshed;
+      CHECK(!(p.firedAt < p.refreshedTo));
+    }
+  }
+  CHECK_EQ(refreshed, 1);
+}
+
+// 回调里取消同一批中还没有执行的定时器
+void testCancelInBatch()
+{
+  EventLoop loop;
+  Probe probes[2];
+  Timestamp when = addTime(Timestamp::now(), 0.02);
+  for (int i = 0; i < 2; ++i)
+  {
+    Probe* self = &probes[i];
+    Probe* other = &probes[1 - i];
+    self->id = loop.runAt(when, [&loop, self, other] {
+      ++self->fired;
+      if (other->fired == 0)
+      {
+        loop.cancel(other->id);
+      }
+    });
+  }
+  loop.runAfter(0.1, [&loop] { loop.quit(); });
+  loop.loop();
+  CHECK_EQ(probes[0].fired + probes[1].fired, 1);
+}
+
+}  // namespace
+
+int main()
+{
+  testRefreshInBatch(false, false);
+  testRefreshInBatch(true, true);
+  testRefreshInBatch(false, true);
+  testRefreshInBatch(true, false);
+  testCancelInBatch();
+  printf("TimerQueue_test passed\n");
+}
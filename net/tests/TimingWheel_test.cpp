@@ -0,0 +1,111 @@
+// TimingWheel的正确性测试：
+// - 每个定时器都在到期时间向上取整到tick之后的第一次advance中触发，不早到、不多等一个tick；
+// - 删除的定时器不会触发；
+// - 空闲了很久之后往空的时间轮上添加定时器，nextExpiration()不会落在过去
+
+#include "base/tests/Check.h"
+#include "net/Timer.h"
+#include "net/TimingWheel.h"
+
+#include <memory>
+#include <random>
+#include <set>
+#include <vector>
+#include <stdio.h>
+
+using namespace bo_net;
+using namespace bo_net::net;
+
+namespace
+{
+
+const int64_t kTickMicroSeconds = 10 * 1000;
+
+Timestamp plusMicros(Timestamp t, int64_t us)
+{
+  return Timestamp(t.microSecondsSinceEpoth() + us);
+}
+
+void testFireTimes()
+{
+  const int kTimers = 4000;
+  // 跨过第1、2层，覆盖降级的路径
+  const int64_t kSpanTicks = static_cast<int64_t>(1) << 21;
+  std::mt19937_64 rng(17);
+  Timestamp start = Timestamp::now();
+  TimingWheel wheel(kTickMicroSeconds, start);
+
+  std::vector<std::unique_ptr<Timer> > timers;
+  std::set<Timer*> pending;
+  std::set<Timer*> removed;
+  for (int i = 0; i < kTimers; ++i)
+  {
+    int64_t us = static_cast<int64_t>(rng() % static_cast<uint64_t>(kSpanTicks * kTickMicroSeconds));
+    timers.emplace_back(new Timer(TimerCallback(), plusMicros(start, us), 0.0, true));
+    wheel.add(timers.back().get());
+    pending.insert(timers.back().get());
+  }
+  for (int i = 0; i < kTimers; i += 7)
+  {
+    wheel.remove(timers[i].get());
+    pending.erase(timers[i].get());
+    removed.insert(timers[i].get());
+  }
+  CHECK_EQ(wheel.size(), pending.size());
+
+  Timestamp now = start;
+  Timestamp prev = plusMicros(start, -1);
+  std::vector<Timer*> expired;
+  while (!pending.empty())
+  {
+    Timestamp next = wheel.nextExpiration();
+    CHECK(next.valid());
+    // nextExpiration()不会晚于最早的到期时刻，按它推进，偶尔多跳一段
+    now = next < now ? now : next;
+    if (rng() % 4 == 0)
+    {
+      now = plusMicros(now, static_cast<int64_t>(rng() % (300 * kTickMicroSeconds)));
+    }
+    expired.clear();
+    wheel.advance(now, &expired);
+    for (Timer* timer : expired)
+    {
+      CHECK(removed.count(timer) == 0);
+      CHECK_EQ(pending.erase(timer), 1);
+      Timestamp due = wheel.roundUp(timer->expiration());
+      // 到期之后的第一次advance触发
+      CHECK(!(now < due));
+      CHECK(prev < due);
+    }
+    prev = now;
+  }
+  CHECK_EQ(wheel.size(), 0);
+}
+
+void testAddAfterIdle()
+{
+  Timestamp now = Timestamp::now();
+  // 时间轮在一天之前创建，之后一直没有advance
+  TimingWheel wheel(kTickMicroSeconds, plusMicros(now, -86400LL * Timestamp::kMicroSecondsPerSecond));
+  Timer timer(TimerCallback(), plusMicros(now, 50 * 1000), 0.0, true);
+  wheel.add(&timer);
+  Timestamp next = wheel.nextExpiration();
+  CHECK(next.valid());
+  CHECK(!(next < plusMicros(now, -kTickMicroSeconds)));
+
+  std::vector<Timer*> expired;
+  wheel.advance(plusMicros(now, 40 * 1000), &expired);
+  CHECK(expired.empty());
+  wheel.advance(plusMicros(now, 60 * 1000), &expired);
+  CHECK_EQ(expired.size(), 1);
+  CHECK(expired[0] == &timer);
+}
+
+}  // namespace
+
+int main()
+{
+  testFireTimes();
+  testAddAfterIdle();
+  printf("TimingWheel_test passed\n");
+}